@@ -0,0 +1,122 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_ASYNC_LOG_SINK_H
+#define ARTI_PROFILING_ASYNC_LOG_SINK_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace arti_profiling
+{
+
+/// Writes records to a stream or to rotating files from a dedicated thread, so that writing a record never waits for
+/// I/O. Records are appended to one of two buffers, allocated up front, while the thread writes out the other one. If
+/// a record doesn't fit into the buffer, it is dropped and counted rather than blocking or allocating.
+class AsyncLogSink
+{
+public:
+  struct FileOptions
+  {
+    std::string directory;  ///< Defaults to the ROS log directory
+    std::string base_name{"profiling"};
+    std::string extension{".log"};
+    std::size_t max_file_size{16 * 1024 * 1024};  ///< In bytes; zero disables rotation by size
+    std::chrono::seconds max_file_age{std::chrono::hours(1)};  ///< Zero disables rotation by age
+    std::size_t max_file_count{10};  ///< Number of files kept, including the current one; zero keeps all
+    bool compress{false};  ///< Whether to compress files with gzip when rotating them
+  };
+
+  static const std::size_t DEFAULT_BUFFER_SIZE;
+
+  /// Writes to the given stream, which must outlive the sink.
+  explicit AsyncLogSink(std::ostream& out, std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+  /// Writes to files named "<directory>/<base_name>_<pid>_<n><extension>".
+  explicit AsyncLogSink(FileOptions options, std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+  AsyncLogSink(const AsyncLogSink&) = delete;
+
+  /// Writes out the remaining records.
+  ~AsyncLogSink();
+
+  AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+  /// Appends the record to the buffer; returns false if it was dropped because the buffer is full.
+  bool write(const std::string& record);
+
+  /// Waits until all records written so far are written out.
+  void flush();
+
+  std::uint64_t getDroppedCount() const;
+
+  /// Returns the name of the file currently written to, or an empty string for streams or if none is open yet.
+  std::string getFileName() const;
+
+protected:
+  AsyncLogSink(std::ostream* out, FileOptions options, std::size_t buffer_size);
+
+  void run();
+  void writeOut(const std::string& data);
+  bool isRotationDue() const;
+  void rotate();
+  /// Replaces the file by a gzip compressed one; returns false and keeps the file if that fails.
+  bool compress(const std::string& file_name);
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  std::size_t buffer_size_;
+  std::string front_buffer_;  ///< Appended to by write()
+  std::string back_buffer_;  ///< Written out by the thread
+  bool writing_{false};
+  bool stopping_{false};
+  std::uint64_t dropped_count_{0};
+
+  // Only accessed by the thread, except for file_name_, which is guarded by mutex_:
+  std::ostream* out_;
+  FileOptions options_;
+  std::ofstream file_;
+  std::string file_name_;
+  std::size_t file_size_{0};
+  std::chrono::steady_clock::time_point file_open_time_;
+  std::uint64_t file_index_{0};
+  std::deque<std::string> file_names_;  ///< Files written so far, oldest first, for removing old ones
+  bool open_failed_{false};
+
+  std::thread thread_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_ASYNC_LOG_SINK_H
@@ -0,0 +1,120 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_BENCH_H
+#define ARTI_PROFILING_BENCH_H
+
+#include <arti_profiling/histogram.h>
+#include <arti_profiling/snapshot.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace arti_profiling
+{
+namespace bench
+{
+
+/// Prevents the compiler from optimizing away the computation of the given value.
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Prevents the compiler from optimizing away or reordering writes to memory across this point.
+inline void clobberMemory()
+{
+  asm volatile("" : : : "memory");
+}
+
+struct Options
+{
+  /// Time for which a benchmark is run before measuring, to warm up caches and CPU frequency.
+  std::chrono::nanoseconds warmup_time{std::chrono::milliseconds(100)};
+
+  /// Minimum time per repetition; the number of iterations per repetition is chosen accordingly.
+  std::chrono::nanoseconds min_repetition_time{std::chrono::milliseconds(10)};
+
+  std::size_t repetitions{20};
+
+  /// CPU to which the benchmarking thread is pinned while running a benchmark, or -1 to not pin it.
+  int cpu{-1};
+
+  std::size_t bootstrap_resamples{1000};
+  double confidence_level{0.95};
+};
+
+/// The result of a benchmark; all durations are per iteration, in nanoseconds.
+struct Result
+{
+  std::string name;
+  std::uint64_t iterations{0};  ///< Per repetition
+  std::vector<double> repetitions;  ///< Average duration of an iteration in each repetition
+  Histogram histogram;  ///< Of the repetitions
+  double mean{0.0};
+  double ci_lower{0.0};  ///< Bounds of the bootstrap confidence interval of the mean
+  double ci_upper{0.0};
+
+  /// Stores the result like the statistics of a DurationMeasurement, so that the snapshot tools can compare it.
+  ProfileSnapshot toSnapshot() const;
+};
+
+/// Runs benchmarks with a common methodology: a warm-up, an iteration count calibrated to the minimum repetition time,
+/// several timed repetitions and a bootstrap confidence interval of the mean over the repetitions.
+class Runner
+{
+public:
+  explicit Runner(Options options = Options());
+
+  /// Runs the given function as benchmark with the given name, and returns its result. The reference is valid until
+  /// the next benchmark is run.
+  const Result& run(const std::string& name, const std::function<void()>& function);
+
+  const std::vector<Result>& getResults() const;
+
+  /// Prints one line per result.
+  void print(std::ostream& out) const;
+
+  /// Returns the results as snapshot, which saveSnapshot() can store as JSON for compare_snapshots.
+  ProfilerSnapshot takeSnapshot(const std::string& name = "benchmarks") const;
+
+protected:
+  std::uint64_t calibrate(const std::function<void()>& function) const;
+  void computeConfidenceInterval(Result& result) const;
+
+  Options options_;
+  std::vector<Result> results_;
+};
+
+}  // namespace bench
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_BENCH_H
@@ -0,0 +1,115 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_COMPARISON_H
+#define ARTI_PROFILING_COMPARISON_H
+
+#include <arti_profiling/histogram.h>
+#include <arti_profiling/snapshot.h>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace arti_profiling
+{
+
+struct ComparisonOptions
+{
+  /// Significance level of the tests.
+  double alpha{0.01};
+
+  /// Minimum relative change of the median or the 99th percentile (or the average, without histograms) to report a
+  /// change.
+  double min_relative_change{0.05};
+
+  /// Whether hasRegressions() counts profiles that could not be tested as regressions.
+  bool fail_untestable{false};
+};
+
+struct ProfileComparison
+{
+  enum class Verdict
+  {
+    UNCHANGED,
+    IMPROVEMENT,
+    REGRESSION,
+    NOT_TESTABLE,  ///< Too few values available, so no significance test could be performed
+    MISSING,  ///< Missing in the current snapshot
+    ADDED,  ///< Missing in the baseline snapshot
+  };
+
+  struct Values
+  {
+    std::uint64_t count{0};
+    double average{0.0};
+    double p50{0.0};
+    double p99{0.0};
+  };
+
+  std::string path;
+  std::string type;
+  Values baseline;
+  Values current;
+  /// Whether both profiles have histograms, which give the percentiles and are used for the tests.
+  bool histograms{false};
+  /// The p-value of the Mann-Whitney U test, or of the test of the averages without histograms.
+  double p_value{1.0};
+  /// The p-value of the test of the 99th percentile (only with histograms).
+  double p99_p_value{1.0};
+  Verdict verdict{Verdict::UNCHANGED};
+};
+
+/// Returns the two-sided p-value of the Mann-Whitney U test for the given histograms, using the normal approximation
+/// with tie correction (values in the same bucket are ties). If given, z is set to the standardized U statistic, which
+/// is positive if the values of b tend to be larger than those of a.
+double mannWhitneyTest(const Histogram& a, const Histogram& b, double* z = nullptr);
+
+/// Returns the two-sided p-value of a two-proportion z-test for the fraction of values above the given quantile of a
+/// (i.e. above its bucket). If given, z is set to the test statistic, which is positive if b has more values there.
+double tailTest(const Histogram& a, const Histogram& b, double quantile, double* z = nullptr);
+
+/// Returns the two-sided p-value of Welch's test for the averages of the given profiles, which is used if they have no
+/// histograms. Snapshots hold no variances, so each variance is bounded by (max - min)^2 / 4 (Popoviciu's inequality),
+/// which makes the test conservative; the t distribution is approximated by the normal one. If given, z is set to the
+/// test statistic. Returns NaN if a profile has less than two values.
+double averageTest(const ProfileSnapshot& a, const ProfileSnapshot& b, double* z = nullptr);
+
+/// Compares all profiles (including labeled ones) of the current snapshot to those of the baseline. For frequencies,
+/// lower values are regressions, for all other profiles higher values are.
+std::vector<ProfileComparison> compareSnapshots(
+  const ProfilerSnapshot& baseline, const ProfilerSnapshot& current, const ComparisonOptions& options = {});
+
+/// Returns whether any comparison is a regression or, if options.fail_untestable is set, could not be tested.
+bool hasRegressions(const std::vector<ProfileComparison>& comparisons, const ComparisonOptions& options = {});
+
+void printComparisons(std::ostream& out, const std::vector<ProfileComparison>& comparisons);
+
+const char* toString(ProfileComparison::Verdict verdict);
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_COMPARISON_H
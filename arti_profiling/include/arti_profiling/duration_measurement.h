@@ -27,9 +27,12 @@
 #ifndef ARTI_PROFILING_DURATION_MEASUREMENT_H
 #define ARTI_PROFILING_DURATION_MEASUREMENT_H
 
+#include <arti_profiling/labeled_statistics.h>
+#include <arti_profiling/labels.h>
 #include <arti_profiling/profile.h>
 #include <arti_profiling/profiler.h>
 #include <chrono>
+#include <cstdint>
 #include <functional>
 #include <iomanip>
 #include <ostream>
@@ -38,32 +41,102 @@
 namespace arti_profiling
 {
 
+class DurationStatistics;
+
 class DurationMeasurement
 {
 public:
   using Clock = std::chrono::steady_clock;
   using Formatter = Statistics<Clock::duration::rep>::Formatter;
+  using OverrunCallback = std::function<void(
+    const std::string& name, const Clock::duration& measurement, const Clock::duration& budget)>;
 
   static const Clock::time_point NEVER;
+  static const Clock::duration NO_BUDGET;
   static const Formatter DEFAULT_FORMATTER;
 
   DurationMeasurement(Profiler& profiler, std::string name, const Clock::time_point& start_time = Clock::now());
   DurationMeasurement(
     Profiler& profiler, std::string name, Formatter formatter, const Clock::time_point& start_time = Clock::now());
+
+  /// Creates a measurement that is accumulated both in total and per label set, see LabeledStatistics.
+  DurationMeasurement(
+    Profiler& profiler, std::string name, LabelSet labels, const Clock::time_point& start_time = Clock::now());
+  DurationMeasurement(
+    Profiler& profiler, std::string name, LabelSet labels, Formatter formatter,
+    const Clock::time_point& start_time = Clock::now());
+
+  /// Creates a measurement that is accumulated in the given statistics, which frequent callers can look up once and
+  /// keep instead of having them looked up by name for each measurement.
+  DurationMeasurement(
+    DurationStatistics& statistics, std::string name, const Clock::time_point& start_time = Clock::now());
   ~DurationMeasurement();
 
   void start(const Clock::time_point& start_time = Clock::now());
   void stop(const Clock::time_point& stop_time = Clock::now());
 
+  /// Sets a time budget for this measurement. Measurements exceeding it are counted as overruns in the profile and
+  /// passed to the given callback, which is called after the profiler has been unlocked.
+  void setBudget(const Clock::duration& budget, OverrunCallback overrun_callback = {});
+
+  /// Makes the profile keep (at least) the given number of slowest samples, with time, thread and tag of each.
+  void setTopSampleCount(std::size_t count);
+
+  /// Sets a short tag stored with this measurement if it ends up among the slowest samples.
+  void setTag(std::string tag);
+
+  /// Makes the profile record a histogram of the measurements, which adds quantiles to its statistics.
+  void setHistogramEnabled(bool enabled);
+
 protected:
   void commit(const Clock::duration& measurement);
+  void accumulate(DurationStatistics& statistics, const Clock::duration& measurement, bool overrun) const;
 
   Profiler* profiler_{nullptr};
+  DurationStatistics* statistics_{nullptr};  ///< Used instead of the profiler if set
   std::string name_;
+  LabelSet labels_;
   Formatter formatter_;
   Clock::time_point start_time_;
+  Clock::duration budget_{NO_BUDGET};
+  OverrunCallback overrun_callback_;
+  std::size_t top_sample_count_{0};
+  std::string tag_;
+  bool histogram_enabled_{false};
+  std::uintptr_t sampled_scope_{0};  ///< Returned by SamplingProfiler::enterScope()
 };
 
+class DurationStatistics : public Statistics<DurationMeasurement::Clock::duration::rep>
+{
+public:
+  using WallClock = std::chrono::system_clock;
+
+  explicit DurationStatistics(Formatter formatter = DurationMeasurement::DEFAULT_FORMATTER);
+
+  void accumulateOverrun(
+    const DurationMeasurement::Clock::duration& measurement, const DurationMeasurement::Clock::duration& budget,
+    const WallClock::time_point& time = WallClock::now());
+
+  std::size_t getOverrunCount() const;
+
+  using Statistics::merge;
+  void merge(const DurationStatistics& other);
+  bool merge(const Profile& other) override;
+
+  void clear() override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+
+protected:
+  void printAdditionalValues(std::ostream& out) const override;
+
+  std::size_t overrun_count_ = 0;
+  DurationMeasurement::Clock::duration last_overrun_budget_{};
+  DurationMeasurement::Clock::duration last_overrun_{};
+  WallClock::time_point last_overrun_time_;
+};
+
+using LabeledDurationStatistics = LabeledStatistics<DurationStatistics>;
+
 template<typename DurationType>
 class SimpleDurationFormatter
 {
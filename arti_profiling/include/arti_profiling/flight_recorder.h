@@ -0,0 +1,93 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_FLIGHT_RECORDER_H
+#define ARTI_PROFILING_FLIGHT_RECORDER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace arti_profiling
+{
+
+/// An always-on recorder of the most recent measurement events of each thread (durations, counter values and markers),
+/// which can be dumped to a trace file in the Chrome trace event format (viewable with chrome://tracing or Perfetto)
+/// when something goes wrong, e.g. on a deadline overrun, on SIGUSR2 or on a crash.
+///
+/// Each thread records into its own fixed-size ring, allocated on its first event (or by registerThread()), so
+/// recording neither locks nor allocates. Names are truncated to MAX_NAME_LENGTH characters. Dumping reads the rings
+/// without stopping the threads; events that are overwritten while being read are skipped.
+class FlightRecorder
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static const std::size_t DEFAULT_CAPACITY;
+  static const std::size_t MAX_NAME_LENGTH;
+
+  FlightRecorder() = delete;
+
+  /// Recording is enabled by default.
+  static void setEnabled(bool enabled);
+  static bool isEnabled();
+
+  /// Sets the number of events kept per thread, for the threads that start recording afterwards.
+  static void setCapacity(std::size_t capacity);
+
+  /// Allocates the calling thread's ring, which real-time threads should do before entering their loop.
+  static void registerThread();
+
+  static void recordDuration(
+    const std::string& name, const Clock::time_point& start_time, const Clock::duration& duration) noexcept;
+  static void recordCounter(const std::string& name, double value) noexcept;
+  static void recordMarker(const std::string& name) noexcept;
+
+  /// Records a marker for the overrun of the measurement with the given name and, if enabled, requests a dump.
+  static void recordOverrun(const std::string& name) noexcept;
+
+  /// Sets the directory of the dumped files; by default the ROS log directory.
+  static void setDumpDirectory(const std::string& directory);
+
+  /// Writes the events of all threads to a new file and returns its name, or an empty string on failure.
+  static std::string dump(const std::string& reason);
+
+  /// Makes a background thread dump the events as soon as possible; async-signal-safe and real-time safe once the
+  /// thread has been started by one of the functions below. The reason must be a string literal.
+  static void requestDump(const char* reason) noexcept;
+
+  /// Requests a dump on every overrun of a DurationMeasurement budget, but at most once per the given interval.
+  static void setDumpOnOverrun(bool enabled, const Clock::duration& min_interval = std::chrono::seconds(10));
+
+  /// Installs handlers that request a dump on SIGUSR2 and, optionally, write a dump on SIGSEGV, SIGBUS, SIGFPE, SIGILL
+  /// and SIGABRT before passing the signal on to the previously installed handler.
+  static void installSignalHandlers(bool dump_on_crash = true);
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_FLIGHT_RECORDER_H
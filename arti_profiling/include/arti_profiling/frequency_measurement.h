@@ -36,6 +36,8 @@
 namespace arti_profiling
 {
 
+class FrequencyStatistics;
+
 class FrequencyMeasurement
 {
 public:
@@ -48,6 +50,10 @@ public:
   FrequencyMeasurement(
     Profiler& profiler, const std::string& name, const Formatter& formatter,
     const Clock::time_point& time = Clock::now());
+
+  /// Accumulates the measurement in the given statistics, which frequent callers can look up once and keep.
+  FrequencyMeasurement(
+    FrequencyStatistics& statistics, const std::string& name, const Clock::time_point& time = Clock::now());
 };
 
 class FrequencyStatistics : public Statistics<double>
@@ -55,6 +61,11 @@ class FrequencyStatistics : public Statistics<double>
 public:
   explicit FrequencyStatistics(Formatter formatter = FrequencyMeasurement::DEFAULT_FORMATTER);
 
+  /// Accumulates the frequency since the previous event, if any.
+  void accumulateEvent(const FrequencyMeasurement::Clock::time_point& time);
+
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+
   FrequencyMeasurement::Clock::time_point last_time_;
 };
 
@@ -0,0 +1,70 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_GAUGE_H
+#define ARTI_PROFILING_GAUGE_H
+
+#include <arti_profiling/profile.h>
+#include <arti_profiling/profiler.h>
+#include <iosfwd>
+#include <string>
+
+namespace arti_profiling
+{
+
+/// Records a sample of a quantity that varies over time, like memory usage or a queue length.
+class GaugeMeasurement
+{
+public:
+  using Formatter = Statistics<double>::Formatter;
+
+  static const Formatter DEFAULT_FORMATTER;
+
+  GaugeMeasurement(Profiler& profiler, const std::string& name, double value);
+  GaugeMeasurement(Profiler& profiler, const std::string& name, double value, const Formatter& formatter);
+};
+
+/// Statistics of the samples of a gauge, which additionally show the latest sample.
+class GaugeStatistics : public Statistics<double>
+{
+public:
+  explicit GaugeStatistics(Formatter formatter = GaugeMeasurement::DEFAULT_FORMATTER);
+
+  void accumulate(const double& value) override;
+  double getLastValue() const;
+
+  void clear() override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+
+protected:
+  void printAdditionalValues(std::ostream& out) const override;
+
+  double last_value_{0.0};
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_GAUGE_H
@@ -0,0 +1,82 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_HISTOGRAM_H
+#define ARTI_PROFILING_HISTOGRAM_H
+
+#include <cstdint>
+#include <map>
+
+namespace arti_profiling
+{
+
+/// A sparse histogram with logarithmically spaced buckets: each power of two is split into SUB_BUCKET_COUNT linear
+/// buckets, so the relative error of a bucket's representative value is below 1 / (2 * SUB_BUCKET_COUNT). Bucket
+/// indices are independent of the data, which makes histograms from different sources mergeable.
+class Histogram
+{
+public:
+  using Buckets = std::map<std::int32_t, std::uint64_t>;
+
+  static const int SUB_BUCKET_COUNT = 16;
+
+  void add(double value, std::uint64_t count = 1);
+  void merge(const Histogram& other);
+  void clear();
+
+  bool empty() const;
+  std::uint64_t getCount() const;
+
+  /// Returns an estimate of the memory used by this histogram, in bytes.
+  std::size_t getMemoryUsage() const;
+  const Buckets& getBuckets() const;
+
+  /// Sets the count of a single bucket, e.g. when loading a histogram.
+  void setBucketCount(std::int32_t index, std::uint64_t count);
+
+  /// Returns the representative value of the bucket containing the given quantile (0 <= quantile <= 1).
+  double getQuantile(double quantile) const;
+
+  /// Returns the number of values less than the given bucket's values plus half of those in it, i.e. the rank used
+  /// for rank-based statistics.
+  double getMidRank(std::int32_t index) const;
+
+  static std::int32_t getBucketIndex(double value);
+  static double getBucketLowerBound(std::int32_t index);
+  static double getBucketUpperBound(std::int32_t index);
+  static double getBucketValue(std::int32_t index);
+
+  bool operator==(const Histogram& other) const;
+  bool operator!=(const Histogram& other) const;
+
+protected:
+  Buckets buckets_;
+  std::uint64_t count_{0};
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_HISTOGRAM_H
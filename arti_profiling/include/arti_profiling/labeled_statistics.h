@@ -0,0 +1,266 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_LABELED_STATISTICS_H
+#define ARTI_PROFILING_LABELED_STATISTICS_H
+
+#include <arti_profiling/labels.h>
+#include <arti_profiling/profile.h>
+#include <algorithm>
+#include <cstddef>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace arti_profiling
+{
+
+class LabeledProfile
+{
+public:
+  /// Key used for the overflow bucket in snapshots; it cannot clash with label sets, which always contain a '='.
+  static constexpr const char* OVERFLOW_LABEL = "overflow";
+
+  virtual ~LabeledProfile() = default;
+
+  /// Prints the statistics merged per value of the label with the given key, one line per value.
+  virtual void printGroupedBy(std::ostream& out, int indent, const std::string& key) const = 0;
+};
+
+/// Keeps separate statistics per label set of a measurement, plus a total over all of them. At most the given number
+/// of label sets is stored, measurements with further label sets are accumulated into an overflow bucket.
+template<typename StatisticsType>
+class LabeledStatistics : public MeasurementAccumulator<typename StatisticsType::ValueType>, public LabeledProfile
+{
+public:
+  using T = typename StatisticsType::ValueType;
+  using Formatter = typename StatisticsType::Formatter;
+  using StatisticsPtr = std::shared_ptr<StatisticsType>;
+
+  LabeledStatistics(Formatter formatter, const std::size_t cardinality_limit)
+    : formatter_(std::move(formatter)), cardinality_limit_(cardinality_limit),
+      total_(std::make_shared<StatisticsType>(formatter_))
+  {
+  }
+
+  void print(std::ostream& out) const override
+  {
+    total_->print(out);
+  }
+
+  void printDetails(std::ostream& out, const int indent) const override
+  {
+    total_->printDetails(out, indent);
+
+    Lock lock(mutex_);
+    std::map<std::string, StatisticsPtr> sorted;
+    for (const auto& entry : statistics_)
+    {
+      sorted.emplace(entry.first.toString(), entry.second);
+    }
+    for (const auto& entry : sorted)
+    {
+      printLine(out, indent, "{" + entry.first + "}", *entry.second);
+    }
+    printOverflow(out, indent);
+  }
+
+  void printGroupedBy(std::ostream& out, const int indent, const std::string& key) const override
+  {
+    Lock lock(mutex_);
+    std::map<std::string, StatisticsPtr> groups;
+    for (const auto& entry : statistics_)
+    {
+      const std::string* value = entry.first.find(key);
+      StatisticsPtr& group = groups[value != nullptr ? key + "=" + *value : key + " unset"];
+      if (!group)
+      {
+        group = std::make_shared<StatisticsType>(formatter_);
+      }
+      group->merge(*entry.second);
+    }
+    for (const auto& group : groups)
+    {
+      printLine(out, indent, "{" + group.first + "}", *group.second);
+    }
+    printOverflow(out, indent);
+  }
+
+  void exportTopSamples(std::ostream& out, const std::string& prefix) const override
+  {
+    total_->exportTopSamples(out, prefix);
+  }
+
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override
+  {
+    if (!total_->takeSnapshot(snapshot))
+    {
+      return false;
+    }
+
+    Lock lock(mutex_);
+    for (const auto& entry : statistics_)
+    {
+      entry.second->takeSnapshot(snapshot.labels[entry.first.toString()]);
+    }
+    if (overflow_)
+    {
+      overflow_->takeSnapshot(snapshot.labels[OVERFLOW_LABEL]);
+    }
+    return true;
+  }
+
+  void accumulate(const T& value) override
+  {
+    total_->accumulate(value);
+    getStatistics(LabelSet())->accumulate(value);
+  }
+
+  const StatisticsPtr& getTotal() const
+  {
+    return total_;
+  }
+
+  /// Returns the statistics for the given label set, or the overflow bucket if the cardinality limit is reached.
+  StatisticsPtr getStatistics(const LabelSet& labels)
+  {
+    Lock lock(mutex_);
+
+    const auto it = statistics_.find(labels);
+    if (it != statistics_.end())
+    {
+      return it->second;
+    }
+
+    if (statistics_.size() < cardinality_limit_)
+    {
+      StatisticsPtr& statistics = statistics_[labels];
+      statistics = std::make_shared<StatisticsType>(formatter_);
+      return statistics;
+    }
+
+    if (!overflow_)
+    {
+      overflow_ = std::make_shared<StatisticsType>(formatter_);
+    }
+    return overflow_;
+  }
+
+  bool merge(const Profile& other) override
+  {
+    const LabeledStatistics* labeled = dynamic_cast<const LabeledStatistics*>(&other);
+    if (labeled == nullptr || labeled == this)
+    {
+      return false;
+    }
+
+    total_->merge(*labeled->total_);
+
+    // Copy the other's entries first, so that both mutexes are never held at the same time:
+    std::vector<std::pair<LabelSet, StatisticsPtr>> entries;
+    StatisticsPtr other_overflow;
+    {
+      Lock other_lock(labeled->mutex_);
+      entries.assign(labeled->statistics_.begin(), labeled->statistics_.end());
+      other_overflow = labeled->overflow_;
+    }
+
+    for (const auto& entry : entries)
+    {
+      getStatistics(entry.first)->merge(*entry.second);
+    }
+    if (other_overflow)
+    {
+      Lock lock(mutex_);
+      if (!overflow_)
+      {
+        overflow_ = std::make_shared<StatisticsType>(formatter_);
+      }
+      overflow_->merge(*other_overflow);
+    }
+    return true;
+  }
+
+  std::size_t getCardinality() const
+  {
+    Lock lock(mutex_);
+    return statistics_.size();
+  }
+
+  std::size_t getMeasurementCount() const override
+  {
+    return total_->getMeasurementCount();
+  }
+
+  std::size_t getMemoryUsage() const override
+  {
+    Lock lock(mutex_);
+    std::size_t result = sizeof(*this) + total_->getMemoryUsage() + (overflow_ ? overflow_->getMemoryUsage() : 0)
+      + statistics_.bucket_count() * sizeof(void*);
+    for (const auto& entry : statistics_)
+    {
+      result += this->NODE_OVERHEAD + entry.first.getMemoryUsage() + entry.second->getMemoryUsage();
+    }
+    return result;
+  }
+
+protected:
+  using Mutex = std::recursive_mutex;
+  using Lock = std::unique_lock<Mutex>;
+
+  void printLine(std::ostream& out, const int indent, const std::string& label, const StatisticsType& statistics) const
+  {
+    out << std::setw(indent) << "" << label
+        << std::setw(28 - std::min(28, static_cast<int>(label.size())) + 2) << std::left << ": " << std::right;
+    statistics.print(out);
+  }
+
+  void printOverflow(std::ostream& out, const int indent) const
+  {
+    if (overflow_)
+    {
+      printLine(out, indent, "{" + std::string(OVERFLOW_LABEL) + "}", *overflow_);
+    }
+  }
+
+  mutable Mutex mutex_;
+
+  Formatter formatter_;
+  std::size_t cardinality_limit_;
+  StatisticsPtr total_;
+  std::unordered_map<LabelSet, StatisticsPtr, LabelSet::Hash> statistics_;
+  StatisticsPtr overflow_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_LABELED_STATISTICS_H
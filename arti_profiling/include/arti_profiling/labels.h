@@ -0,0 +1,87 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_LABELS_H
+#define ARTI_PROFILING_LABELS_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// An immutable set of key/value labels whose hash is computed once on construction. Copies share the labels, so
+/// passing a label set to a measurement does not allocate.
+class LabelSet
+{
+public:
+  using Label = std::pair<std::string, std::string>;
+
+  struct Hash
+  {
+    std::size_t operator()(const LabelSet& labels) const
+    {
+      return labels.getHash();
+    }
+  };
+
+  LabelSet();
+  LabelSet(std::initializer_list<Label> labels);
+  explicit LabelSet(std::vector<Label> labels);
+
+  bool empty() const;
+  std::size_t getHash() const;
+  const std::vector<Label>& getLabels() const;
+
+  /// Returns the value of the label with the given key, or nullptr if there is no such label.
+  const std::string* find(const std::string& key) const;
+
+  /// Returns the labels formatted as "key1=value1,key2=value2".
+  std::string toString() const;
+
+  /// Returns an estimate of the memory used by the (shared) labels, in bytes.
+  std::size_t getMemoryUsage() const;
+
+  bool operator==(const LabelSet& other) const;
+  bool operator!=(const LabelSet& other) const;
+
+protected:
+  struct Data
+  {
+    std::vector<Label> labels;
+    std::size_t hash{0};
+  };
+
+  std::shared_ptr<const Data> data_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_LABELS_H
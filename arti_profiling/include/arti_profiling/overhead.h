@@ -0,0 +1,61 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_OVERHEAD_H
+#define ARTI_PROFILING_OVERHEAD_H
+
+namespace arti_profiling
+{
+
+/// Costs of the profiler's own operations on this machine, in nanoseconds.
+struct OverheadCalibration
+{
+  double clock_read{0.0};  ///< Reading the steady clock once
+  double lock{0.0};  ///< Locking and unlocking an uncontended mutex
+  double commit{0.0};  ///< Recording a DurationMeasurement in an existing profile, excluding clock reads and tracing
+
+  /// Returns the time a DurationMeasurement adds to the program: reading the clock twice and committing.
+  double getMeasurementCost() const;
+};
+
+/// Measures the costs of the profiler's operations, which takes a few milliseconds.
+OverheadCalibration calibrateOverhead();
+
+/// Returns whether the calling thread is calibrating the overhead. Its measurements are then neither recorded by the
+/// FlightRecorder and the SamplingProfiler nor passed to USDT probes, so calibration doesn't show up in traces.
+bool isCalibratingOverhead();
+
+/// Returns the costs measured on the first call, which should therefore happen at startup; done by StatisticsPrinter.
+const OverheadCalibration& getOverheadCalibration();
+
+/// Makes DurationMeasurement subtract the calibrated cost of a clock read from each measurement (but not below zero),
+/// which is included in durations measured between two reads of the clock. Disabled by default.
+void setOverheadCompensationEnabled(bool enabled);
+bool isOverheadCompensationEnabled();
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_OVERHEAD_H
@@ -0,0 +1,194 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_PIPELINE_PROFILER_H
+#define ARTI_PROFILING_PIPELINE_PROFILER_H
+
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profile.h>
+#include <arti_profiling/profiler.h>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// Statistics of a pipeline of stages forming a DAG. Stages are connected by named streams: a stage consumes the items
+/// that the stages producing its input streams have finished. Items are identified by an ID (e.g. a sequence number or
+/// timestamp) and timed through the stages, which yields per stage the throughput, the backlog of items waiting for
+/// it, the time items wait for it (queue time) and the time it takes to process them (service time).
+///
+/// Once an item is finished by a stage without consumers and not pending anywhere else, its end-to-end latency is
+/// recorded, and its critical path is determined by following each stage back to the input stage that finished last.
+/// The stages most often on the critical path and contributing the most time are the ones to optimize next.
+class PipelineProfile : public Profile
+{
+public:
+  using Clock = DurationMeasurement::Clock;
+  using ItemId = std::uint64_t;
+  using Formatter = DurationStatistics::Formatter;
+
+  static const std::size_t DEFAULT_MAX_ITEMS_IN_FLIGHT;
+
+  explicit PipelineProfile(const Formatter& formatter = DurationMeasurement::DEFAULT_FORMATTER);
+
+  /// Declares a stage consuming the given input streams and producing the given output streams. Declaring an existing
+  /// stage again replaces its streams.
+  void addStage(
+    const std::string& name, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs);
+
+  /// Limits the number of items tracked at a time; if exceeded, the oldest items are dropped.
+  void setMaxItemsInFlight(std::size_t count);
+
+  /// Marks the time an item entered the pipeline, e.g. its sensor timestamp. Otherwise, an item enters the pipeline
+  /// when the first stage begins processing it.
+  void startItem(ItemId id, const Clock::time_point& time = Clock::now());
+
+  void beginStage(const std::string& stage, ItemId id, const Clock::time_point& time = Clock::now());
+  void endStage(const std::string& stage, ItemId id, const Clock::time_point& time = Clock::now());
+
+  /// Stops tracking an item that won't be finished, e.g. because a stage filtered it out.
+  void dropItem(ItemId id);
+
+  void print(std::ostream& out) const override;
+  void printDetails(std::ostream& out, int indent) const override;
+  bool reset() override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+  std::size_t getMemoryUsage() const override;
+
+protected:
+  using Mutex = std::recursive_mutex;
+  using Lock = std::unique_lock<Mutex>;
+
+  static const std::size_t NO_STAGE;
+
+  struct Stage
+  {
+    Stage(std::string name, const Formatter& formatter);
+
+    std::string name;
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    std::vector<std::size_t> upstream;
+    std::vector<std::size_t> downstream;
+    DurationStatistics queue_times;
+    DurationStatistics service_times;
+    std::size_t completed_count{0};
+    std::size_t backlog{0};
+    std::size_t max_backlog{0};
+    std::size_t critical_count{0};
+    Clock::duration critical_time{};
+  };
+
+  struct StageTiming
+  {
+    enum class State
+    {
+      PENDING, ACTIVE, DONE
+    };
+
+    State state{State::PENDING};
+    Clock::time_point arrival;
+    Clock::time_point begin;
+    Clock::time_point end;
+    std::size_t critical_predecessor{NO_STAGE};
+  };
+
+  struct Item
+  {
+    Clock::time_point start;
+    std::map<std::size_t, StageTiming> stages;
+  };
+
+  using Items = std::unordered_map<ItemId, Item>;
+
+  std::size_t findStage(const std::string& name) const;
+  Items::iterator findItem(ItemId id, const Clock::time_point& time);
+  void completeItem(Items::iterator item, std::size_t sink);
+  void eraseItem(Items::iterator item);
+
+  mutable Mutex mutex_;
+  Formatter formatter_;
+  std::vector<std::unique_ptr<Stage>> stages_;
+  std::map<std::string, std::size_t> stage_indices_;
+  Items items_;
+  std::size_t max_items_in_flight_;
+  DurationStatistics latencies_;
+  std::map<std::string, std::size_t> critical_paths_;
+  std::size_t dropped_count_{0};
+  Clock::time_point interval_start_;
+};
+
+/// Records the items passing through a pipeline in a PipelineProfile registered in a Profiler.
+class PipelineProfiler
+{
+public:
+  using Clock = PipelineProfile::Clock;
+  using ItemId = PipelineProfile::ItemId;
+
+  /// Measures the time a stage takes to process an item while it exists.
+  class StageScope
+  {
+  public:
+    StageScope(PipelineProfiler& pipeline, std::string stage, ItemId id);
+    ~StageScope();
+
+    StageScope(const StageScope&) = delete;
+    StageScope& operator=(const StageScope&) = delete;
+
+  protected:
+    PipelineProfiler& pipeline_;
+    std::string stage_;
+    ItemId id_;
+  };
+
+  PipelineProfiler(Profiler& profiler, const std::string& name);
+
+  void addStage(
+    const std::string& name, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs);
+  void setMaxItemsInFlight(std::size_t count);
+
+  void startItem(ItemId id, const Clock::time_point& time = Clock::now());
+  void beginStage(const std::string& stage, ItemId id, const Clock::time_point& time = Clock::now());
+  void endStage(const std::string& stage, ItemId id, const Clock::time_point& time = Clock::now());
+  void dropItem(ItemId id);
+
+  const std::shared_ptr<PipelineProfile>& getProfile() const;
+
+protected:
+  std::shared_ptr<PipelineProfile> profile_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_PIPELINE_PROFILER_H
@@ -27,13 +27,22 @@
 #ifndef ARTI_PROFILING_PROFILE_H
 #define ARTI_PROFILING_PROFILE_H
 
+#include <arti_profiling/histogram.h>
+#include <arti_profiling/snapshot.h>
+#include <arti_profiling/top_samples.h>
+#include <algorithm>
 #include <boost/format.hpp>
+#include <chrono>
 #include <functional>
 #include <iomanip>
+#include <limits>
+#include <memory>
 #include <ostream>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <mutex>
+#include <vector>
 
 namespace arti_profiling
 {
@@ -45,6 +54,52 @@ public:
   virtual ~Profile() = default;
 
   virtual void print(std::ostream& out) const = 0;
+
+  /// Prints further lines below the one written by print(), indented by the given number of characters.
+  virtual void printDetails(std::ostream& /*out*/, int /*indent*/) const
+  {
+  }
+
+  /// Writes the recorded top samples as CSV rows, each starting with the given prefix.
+  virtual void exportTopSamples(std::ostream& /*out*/, const std::string& /*prefix*/) const
+  {
+  }
+
+  /// Starts a new interval, e.g. on Profiler::clear(). Returns false if the profile should be removed instead, which is
+  /// what happens to all profiles that don't need to persist between intervals.
+  virtual bool reset()
+  {
+    return false;
+  }
+
+  /// Stores the profile's state in the given snapshot; returns false if this profile cannot be stored in snapshots.
+  virtual bool takeSnapshot(ProfileSnapshot& /*snapshot*/) const
+  {
+    return false;
+  }
+
+  /// Returns an estimate of the memory used by this profile in bytes, which profilers use to enforce memory limits.
+  virtual std::size_t getMemoryUsage() const
+  {
+    return sizeof(Profile);
+  }
+
+  /// Adds the measurements of the other profile to this one; returns false if the profiles cannot be merged.
+  virtual bool merge(const Profile& /*other*/)
+  {
+    return false;
+  }
+
+  /// Returns the number of measurements recorded in this profile in the current interval, which is used to estimate
+  /// the overhead of profiling.
+  virtual std::size_t getMeasurementCount() const
+  {
+    return 0;
+  }
+
+protected:
+  /// Estimated bookkeeping overhead of an element of a node-based container like std::map, besides the value itself.
+  static constexpr std::size_t NODE_OVERHEAD = 4 * sizeof(void*);
 };
 
 template<typename T>
@@ -58,6 +113,7 @@ template<typename T>
 class Statistics : public MeasurementAccumulator<T>
 {
 public:
+  using ValueType = T;
   using Formatter = std::function<void(std::ostream&, const T& value)>;
 
   explicit Statistics(Formatter formatter)
@@ -81,14 +137,54 @@ public:
       formatter_(out, getAverage());
       out << ", max: ";
       formatter_(out, max_);
+      if (histogram_ && !histogram_->empty())
+      {
+        out << ", p50: ";
+        formatter_(out, getQuantile(0.5));
+        out << ", p99: ";
+        formatter_(out, getQuantile(0.99));
+      }
+      printAdditionalValues(out);
+      out << std::endl;
+    }
+  }
+
+  void printDetails(std::ostream& out, const int indent) const override
+  {
+    Lock lock(mutex_);
+
+    for (const typename TopSamples<T>::Sample& sample : top_samples_.getSorted())
+    {
+      out << std::setw(indent) << "" << "top: ";
+      TopSamples<T>::printSample(out, sample, formatter_);
       out << std::endl;
     }
   }
 
+  void exportTopSamples(std::ostream& out, const std::string& prefix) const override
+  {
+    Lock lock(mutex_);
+    top_samples_.exportCsv(out, prefix);
+  }
+
   void accumulate(const T& value) override
+  {
+    accumulate(value, std::string());
+  }
+
+  void accumulate(const T& value, const std::string& tag)
   {
     Lock lock(mutex_);
 
+    if (top_samples_.accepts(value))
+    {
+      top_samples_.add(value, tag);
+    }
+    if (histogram_)
+    {
+      histogram_->add(static_cast<double>(value));
+    }
+
     ++count_;
     sum_ += value;
     if (max_ < value)
@@ -101,6 +197,27 @@ public:
     }
   }
 
+  /// Adds values that were aggregated elsewhere, e.g. in a real-time buffer, given their count, sum, extremes and
+  /// (if recorded) histogram.
+  void accumulateAggregate(
+    const std::size_t count, const T& sum, const T& min, const T& max, const Histogram* histogram = nullptr)
+  {
+    Lock lock(mutex_);
+
+    if (count == 0)
+    {
+      return;
+    }
+    if (histogram != nullptr && histogram_)
+    {
+      histogram_->merge(*histogram);
+    }
+    count_ += count;
+    sum_ += sum;
+    max_ = std::max(max_, max);
+    min_ = std::min(min_, min);
+  }
+
   T getAverage() const
   {
     Lock lock(mutex_);
@@ -108,10 +225,171 @@ public:
     return sum_ / static_cast<T>(count_);
   }
 
+  /// Adds the measurements accumulated by the other statistics to these ones.
+  void merge(const Statistics& other)
+  {
+    if (&other == this)
+    {
+      return;
+    }
+
+    Lock lock(mutex_, std::defer_lock);
+    Lock other_lock(other.mutex_, std::defer_lock);
+    std::lock(lock, other_lock);
+
+    count_ += other.count_;
+    sum_ += other.sum_;
+    if (max_ < other.max_)
+    {
+      max_ = other.max_;
+    }
+    if (min_ > other.min_)
+    {
+      min_ = other.min_;
+    }
+    top_samples_.merge(other.top_samples_);
+    if (other.histogram_)
+    {
+      if (!histogram_)
+      {
+        histogram_.reset(new Histogram);
+      }
+      histogram_->merge(*other.histogram_);
+    }
+  }
+
+  bool merge(const Profile& other) override
+  {
+    const Statistics* statistics = dynamic_cast<const Statistics*>(&other);
+    if (statistics == nullptr)
+    {
+      return false;
+    }
+    merge(*statistics);
+    return true;
+  }
+
+  /// Discards all accumulated values, keeping the settings.
+  virtual void clear()
+  {
+    Lock lock(mutex_);
+
+    count_ = 0;
+    sum_ = 0;
+    min_ = std::numeric_limits<T>::max();
+    max_ = std::numeric_limits<T>::lowest();
+    top_samples_.clear();
+    if (histogram_)
+    {
+      histogram_->clear();
+    }
+  }
+
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override
+  {
+    Lock lock(mutex_);
+
+    snapshot.type = "statistics";
+    snapshot.count = count_;
+    snapshot.sum = SnapshotValue::from(sum_);
+    snapshot.min = SnapshotValue::from(min_);
+    snapshot.max = SnapshotValue::from(max_);
+    if (histogram_)
+    {
+      snapshot.histogram = *histogram_;
+    }
+    snapshot.top_sample_capacity = top_samples_.getCapacity();
+    for (const typename TopSamples<T>::Sample& sample : top_samples_.getSorted())
+    {
+      SampleSnapshot sample_snapshot;
+      sample_snapshot.value = SnapshotValue::from(sample.value);
+      sample_snapshot.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        sample.time.time_since_epoch()).count();
+      std::ostringstream thread;
+      thread << sample.thread_id;
+      sample_snapshot.thread = thread.str();
+      sample_snapshot.tag = sample.tag;
+      snapshot.top_samples.push_back(sample_snapshot);
+    }
+    return true;
+  }
+
+  std::size_t getCount() const
+  {
+    Lock lock(mutex_);
+    return count_;
+  }
+
+  std::size_t getMeasurementCount() const override
+  {
+    return getCount();
+  }
+
+  std::size_t getMemoryUsage() const override
+  {
+    Lock lock(mutex_);
+    return sizeof(*this) + top_samples_.getMemoryUsage() + (histogram_ ? histogram_->getMemoryUsage() : 0);
+  }
+
+  std::size_t getTopSampleCount() const
+  {
+    Lock lock(mutex_);
+    return top_samples_.getCapacity();
+  }
+
+  /// Keeps the given number of largest samples, or none if zero.
+  void setTopSampleCount(const std::size_t count)
+  {
+    Lock lock(mutex_);
+    top_samples_.setCapacity(count);
+  }
+
+  bool isHistogramEnabled() const
+  {
+    Lock lock(mutex_);
+    return static_cast<bool>(histogram_);
+  }
+
+  /// Enables recording all values in a histogram, which makes quantiles available.
+  void setHistogramEnabled(const bool enabled)
+  {
+    Lock lock(mutex_);
+    if (!enabled)
+    {
+      histogram_.reset();
+    }
+    else if (!histogram_)
+    {
+      histogram_.reset(new Histogram);
+    }
+  }
+
+  /// Returns the approximate value of the given quantile, or the average if no histogram is recorded.
+  T getQuantile(const double quantile) const
+  {
+    Lock lock(mutex_);
+    if (!histogram_ || histogram_->empty())
+    {
+      return getAverage();
+    }
+    return std::min(std::max(static_cast<T>(histogram_->getQuantile(quantile)), min_), max_);
+  }
+
+  std::vector<typename TopSamples<T>::Sample> getTopSamples() const
+  {
+    Lock lock(mutex_);
+    return top_samples_.getSorted();
+  }
+
 protected:
-  using Mutex = std::recursive_mutex;
+  using Mutex = std::recursive_mutex;  // Not a ProfiledRecursiveMutex, which would recurse into this class
   using Lock = std::unique_lock<Mutex>;
 
+  /// Hook for subclasses to append values to the statistics line; called with the mutex locked.
+  virtual void printAdditionalValues(std::ostream& /*out*/) const
+  {
+  }
+
   mutable Mutex mutex_;
 
   Formatter formatter_;
@@ -119,6 +397,8 @@ protected:
   T sum_ = 0;
   T min_ = std::numeric_limits<T>::max();
   T max_ = std::numeric_limits<T>::lowest();
+  TopSamples<T> top_samples_;
+  std::unique_ptr<Histogram> histogram_;
 };
 
 }  // namespace arti_profiling
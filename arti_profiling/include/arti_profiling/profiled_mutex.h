@@ -0,0 +1,251 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_PROFILED_MUTEX_H
+#define ARTI_PROFILING_PROFILED_MUTEX_H
+
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profile.h>
+#include <arti_profiling/profiler.h>
+#include <atomic>
+#include <boost/thread/shared_mutex.hpp>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+namespace arti_profiling
+{
+
+/// Statistics of a (group of) ProfiledMutex(es): how often it was acquired, how often and how long threads had to
+/// wait for it, and how long it was held. The longest waits are kept together with the thread holding the mutex at
+/// the time. Everything on the uncontended path is recorded with atomic operations only.
+class LockStatistics : public Profile
+{
+public:
+  using Clock = DurationMeasurement::Clock;
+  using Formatter = DurationStatistics::Formatter;
+
+  static const std::size_t DEFAULT_TOP_WAIT_COUNT;
+  static const Formatter DEFAULT_FORMATTER;  ///< Microseconds, as locks are usually held briefly
+
+  explicit LockStatistics(const Formatter& formatter = DEFAULT_FORMATTER);
+
+  /// Returns the statistics with the given name in the given profiler, creating them if necessary.
+  static std::shared_ptr<LockStatistics> getStatistics(Profiler& profiler, const std::string& name);
+
+  void accumulateAcquisition(bool shared);
+  void accumulateWait(const Clock::duration& wait, const std::thread::id& holder, bool shared);
+  void accumulateHold(const Clock::duration& hold);
+
+  std::uint64_t getAcquisitionCount() const;
+  std::uint64_t getContendedCount() const;
+  const DurationStatistics& getWaitStatistics() const;
+
+  void print(std::ostream& out) const override;
+  void printDetails(std::ostream& out, int indent) const override;
+  void exportTopSamples(std::ostream& out, const std::string& prefix) const override;
+  bool reset() override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+  std::size_t getMemoryUsage() const override;
+
+protected:
+  static void updateMaximum(std::atomic<Clock::rep>& maximum, Clock::rep value);
+  static void updateMinimum(std::atomic<Clock::rep>& minimum, Clock::rep value);
+
+  Formatter formatter_;
+  std::atomic<std::uint64_t> acquisition_count_{0};
+  std::atomic<std::uint64_t> shared_acquisition_count_{0};
+  std::atomic<std::uint64_t> contended_count_{0};
+  std::atomic<std::uint64_t> hold_count_{0};
+  std::atomic<Clock::rep> hold_sum_{0};
+  std::atomic<Clock::rep> hold_min_;
+  std::atomic<Clock::rep> hold_max_{0};
+  DurationStatistics wait_statistics_;
+};
+
+/// A mutex that records its wait and hold times in a LockStatistics profile. It can replace std::mutex and
+/// std::recursive_mutex (see the type aliases below) wherever these are used through lock(), try_lock() and unlock(),
+/// e.g. with std::lock_guard, std::unique_lock and std::condition_variable_any. A default-constructed instance
+/// doesn't record anything.
+///
+/// An uncontended lock() costs a try_lock() and a few atomic operations, but no timestamp. Only if the mutex is
+/// contended, the wait is timed with two timestamps and recorded, together with the thread holding the mutex. Hold
+/// times are only recorded if enabled, as they take one timestamp in lock() and another one in unlock(); the
+/// second timestamp of a wait doubles as the start of the hold time.
+///
+/// Profiler and Statistics keep using plain recursive mutexes: a ProfiledMutex registers its statistics in a
+/// Profiler and records waits in a Statistics instance, so profiling their own mutexes would recurse.
+template<typename MutexType>
+class BasicProfiledMutex
+{
+public:
+  using Clock = LockStatistics::Clock;
+
+  BasicProfiledMutex() = default;
+
+  BasicProfiledMutex(Profiler& profiler, const std::string& name, const bool time_holds = false)
+    : statistics_(LockStatistics::getStatistics(profiler, name)), time_holds_(time_holds)
+  {
+  }
+
+  BasicProfiledMutex(const BasicProfiledMutex&) = delete;
+  BasicProfiledMutex& operator=(const BasicProfiledMutex&) = delete;
+
+  void lock()
+  {
+    if (!statistics_)
+    {
+      mutex_.lock();
+    }
+    else if (mutex_.try_lock())
+    {
+      acquired(time_holds_ ? Clock::now() : Clock::time_point());
+    }
+    else
+    {
+      const std::thread::id holder = holder_.load(std::memory_order_relaxed);
+      const Clock::time_point wait_start = Clock::now();
+      mutex_.lock();
+      const Clock::time_point now = Clock::now();
+      statistics_->accumulateWait(now - wait_start, holder, false);
+      acquired(now);
+    }
+  }
+
+  bool try_lock()
+  {
+    if (!mutex_.try_lock())
+    {
+      return false;
+    }
+
+    if (statistics_)
+    {
+      acquired(time_holds_ ? Clock::now() : Clock::time_point());
+    }
+    return true;
+  }
+
+  void unlock()
+  {
+    if (statistics_ && --depth_ == 0)
+    {
+      holder_.store(std::thread::id(), std::memory_order_relaxed);
+      if (time_holds_)
+      {
+        statistics_->accumulateHold(Clock::now() - acquisition_time_);
+      }
+    }
+    mutex_.unlock();
+  }
+
+  MutexType& getMutex()
+  {
+    return mutex_;
+  }
+
+  const std::shared_ptr<LockStatistics>& getStatistics() const
+  {
+    return statistics_;
+  }
+
+protected:
+  void acquired(const Clock::time_point& time)
+  {
+    // Nested locks of recursive mutexes are neither counted nor timed:
+    if (depth_++ == 0)
+    {
+      acquisition_time_ = time;
+      holder_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+      statistics_->accumulateAcquisition(false);
+    }
+  }
+
+  MutexType mutex_;
+  std::shared_ptr<LockStatistics> statistics_;
+  bool time_holds_{false};
+  std::atomic<std::thread::id> holder_{std::thread::id()};
+  std::size_t depth_{0};  ///< Only accessed by the thread holding the mutex
+  Clock::time_point acquisition_time_;  ///< Only accessed by the thread holding the mutex
+};
+
+using ProfiledMutex = BasicProfiledMutex<std::mutex>;
+using ProfiledRecursiveMutex = BasicProfiledMutex<std::recursive_mutex>;
+
+/// A reader-writer mutex that records its wait and hold times like ProfiledMutex. Shared acquisitions are counted
+/// and their waits are recorded, but their hold times are not, as there can be several holders at a time.
+class ProfiledSharedMutex : public BasicProfiledMutex<boost::shared_mutex>
+{
+public:
+  using BasicProfiledMutex::BasicProfiledMutex;
+
+  void lock_shared()
+  {
+    if (!statistics_)
+    {
+      mutex_.lock_shared();
+    }
+    else if (mutex_.try_lock_shared())
+    {
+      statistics_->accumulateAcquisition(true);
+    }
+    else
+    {
+      const std::thread::id holder = holder_.load(std::memory_order_relaxed);
+      const Clock::time_point wait_start = Clock::now();
+      mutex_.lock_shared();
+      statistics_->accumulateWait(Clock::now() - wait_start, holder, true);
+      statistics_->accumulateAcquisition(true);
+    }
+  }
+
+  bool try_lock_shared()
+  {
+    if (!mutex_.try_lock_shared())
+    {
+      return false;
+    }
+
+    if (statistics_)
+    {
+      statistics_->accumulateAcquisition(true);
+    }
+    return true;
+  }
+
+  void unlock_shared()
+  {
+    mutex_.unlock_shared();
+  }
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_PROFILED_MUTEX_H
@@ -27,6 +27,10 @@
 #ifndef ARTI_PROFILING_PROFILER_H
 #define ARTI_PROFILING_PROFILER_H
 
+#include <arti_profiling/snapshot.h>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <iosfwd>
 #include <map>
 #include <memory>
@@ -44,9 +48,21 @@ using ProfilePtr = std::shared_ptr<Profile>;
 class Profiler
 {
 public:
-  using Mutex = std::recursive_mutex;
+  using Mutex = std::recursive_mutex;  // Not a ProfiledRecursiveMutex, which would recurse into this class
   using Lock = std::unique_lock<Mutex>;
 
+  /// What happens to a profile with a new name if the profile or memory limit is reached.
+  enum class LimitPolicy
+  {
+    OVERFLOW_BUCKET,  ///< Count its updates in the profile named OVERFLOW_PROFILE_NAME instead, whatever their type
+    EVICT_COLDEST,  ///< Remove the profile that was least recently used (and isn't used outside the profiler)
+  };
+
+  static const std::size_t DEFAULT_PROFILE_LIMIT;
+  static const std::size_t DEFAULT_MEMORY_LIMIT;
+  static const std::size_t MEMORY_UPDATE_INTERVAL;  ///< Number of limit checks between full memory usage updates
+  static const char* const OVERFLOW_PROFILE_NAME;
+
   explicit Profiler(std::string name);
   Profiler(Profiler& parent, std::string name);
   Profiler(const Profiler&) = delete;
@@ -58,6 +74,9 @@ public:
 
   void printStatistics(std::ostream& out, int indent = 0) const;
 
+  /// Writes the top samples of all profiles in this profiler and its children as CSV, including a header line.
+  void exportTopSamples(std::ostream& out) const;
+
   struct ProfileUpdate
   {
     ProfileUpdate(ProfilePtr& _profile, Mutex &mutex) : profile(_profile), local_lock(mutex)
@@ -69,13 +88,91 @@ public:
     Lock local_lock;
   };
 
+  /// Returns the current state of this profiler and all its children.
+  ProfilerSnapshot takeSnapshot() const;
+
+  /// Stores the current state of a single profile in the given snapshot. The path consists of the names of the child
+  /// profilers leading to it and the profile name, separated by '/'; leading names that match no child are taken as
+  /// part of the profile name. Child names may contain '/' as well, like the topic names of topic profilers. Returns
+  /// false if there is no such profile or it cannot be stored in snapshots.
+  bool takeSnapshot(const std::string& path, ProfileSnapshot& snapshot) const;
+
   ProfileUpdate getProfile(const std::string& name);
   void clear();
   bool hasChildren() const;
 
+  /// Maximum number of label sets stored per labeled profile created in this profiler.
+  std::size_t getLabelCardinalityLimit() const;
+  void setLabelCardinalityLimit(std::size_t limit);
+
+  /// Makes printStatistics() print labeled profiles grouped by the label with the given key (or per label set if
+  /// empty). Applies to the children as well, unless they set their own grouping.
+  void setLabelGrouping(std::string key);
+
+  /// Makes printStatistics() print, for each profile name occurring below this profiler, the aggregate of all profiles
+  /// with that name in this profiler and its descendants. Applies to the children as well. The roll-ups are computed
+  /// from a snapshot taken once, bottom-up, so each profile is locked and merged only once.
+  void setRollUpEnabled(bool enabled);
+
+  /// Keeps snapshots of the profiles of the last given number of intervals, each taken by clear() before resetting the
+  /// profiles; zero (the default) disables this. Applies to the children as well, unless they set their own capacity.
+  /// Top samples are not kept, to keep the history compact. The history counts towards getMemoryUsage(), but not the
+  /// memory limit, as it cannot be evicted; it is bounded by the capacity instead.
+  void setHistoryCapacity(std::size_t capacity);
+
+  /// Returns the recorded intervals of the profiler at the given path of child names separated by '/' (this profiler
+  /// if empty; names may contain '/' themselves), oldest first. The snapshots contain the profiler's own profiles
+  /// only, no children.
+  std::vector<ProfilerSnapshot> getHistory(const std::string& path = std::string()) const;
+
+  /// Assembles the state of this profiler and its children in the last interval that ended at or before the given
+  /// time (in nanoseconds since the epoch) from their histories; returns false if there is no such interval.
+  bool getHistoricSnapshot(std::int64_t time, ProfilerSnapshot& snapshot) const;
+
+  /// Limits the number of profiles and their estimated memory usage in bytes (zero disables a limit), to bound the
+  /// memory used by e.g. profile names accidentally built from message contents. The limits apply to this profiler
+  /// only, not its children. As computing the memory usage visits all profiles, the memory limit is checked against
+  /// an estimate that is adjusted for each profile added or evicted, and only fully updated every
+  /// MEMORY_UPDATE_INTERVAL lookups of new names to account for the growth of existing profiles.
+  void setProfileLimit(std::size_t limit);
+  void setMemoryLimit(std::size_t limit);
+  void setLimitPolicy(LimitPolicy policy);
+
+  /// Returns the estimated memory usage of this profiler and its children, in bytes.
+  std::size_t getMemoryUsage() const;
+
+  /// Returns the number of measurements recorded in this profiler and its children in the current interval.
+  std::size_t getMeasurementCount() const;
+
 protected:
   Profiler();
 
+  void printStatistics(
+    std::ostream& out, int indent, const std::string& label_grouping, const ProfilerSnapshot* rollup_snapshot) const;
+  void printRollUp(std::ostream& out, int indent, const ProfilerSnapshot& snapshot) const;
+  static void printOverhead(std::ostream& out, int indent, const Profile& profile);
+  void exportTopSamples(std::ostream& out, const std::string& path) const;
+  void takeSnapshot(ProfilerSnapshot& snapshot) const;
+  void clear(std::size_t inherited_history_capacity, std::int64_t time);
+  void recordHistory(std::size_t capacity, std::int64_t time);
+
+  /// Returns the child whose name, followed by '/', starts the given path (the longest one), or nullptr.
+  const Profiler* findChild(const std::string& path) const;
+
+  struct ProfileEntry
+  {
+    ProfilePtr profile;
+    std::uint64_t last_use{0};
+  };
+  using ProfileEntries = std::map<std::string, ProfileEntry>;
+
+  /// Returns the estimated memory usage of this profiler without its history and children, in bytes.
+  std::size_t getOwnMemoryUsage() const;
+  static std::size_t getMemoryUsage(const ProfileEntries::value_type& entry);
+  void addToMemoryEstimate(const ProfileEntries::iterator& entry);
+  bool isLimitReached();
+  bool evictColdestProfile();
+
   void addChild(Profiler* child);
   void removeChild(Profiler* child);
 
@@ -83,7 +180,24 @@ protected:
   Profiler* parent_{nullptr};
   std::string name_;
   std::vector<Profiler*> children_;
-  std::map<std::string, ProfilePtr> profiles_;
+  ProfileEntries profiles_;
+  std::uint64_t use_count_{0};
+  std::size_t label_cardinality_limit_{64};
+  std::string label_grouping_;
+  bool rollup_enabled_{false};
+  std::size_t history_capacity_{0};
+  std::deque<ProfilerSnapshot> history_;
+  std::size_t history_memory_usage_{0};
+  std::size_t profile_limit_{DEFAULT_PROFILE_LIMIT};
+  std::size_t memory_limit_{DEFAULT_MEMORY_LIMIT};
+  std::size_t memory_estimate_{0};
+  std::size_t misses_until_memory_update_{0};
+  ProfileEntries::iterator new_entry_{profiles_.end()};  ///< Added last, its profile created by the caller
+  std::size_t new_entry_memory_usage_{0};  ///< Estimated memory usage of new_entry_ when it was added
+  LimitPolicy limit_policy_{LimitPolicy::OVERFLOW_BUCKET};
+  std::size_t evicted_count_{0};
+  std::size_t overflow_count_{0};
+  ProfilePtr overflow_scratch_;  ///< Updated instead of profiles beyond the limit, and discarded
 };
 
 }  // namespace arti_profiling
@@ -0,0 +1,112 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_PROFILING_DIAGNOSTICS_H
+#define ARTI_PROFILING_PROFILING_DIAGNOSTICS_H
+
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <chrono>
+#include <cstdint>
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <memory>
+#include <ros/node_handle.h>
+#include <string>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// Limits on the statistics of a profile within an evaluation window; zero disables a limit.
+struct DiagnosticThresholds
+{
+  double min_frequency_warn{0.0};  ///< Hz
+  double min_frequency_error{0.0};  ///< Hz
+  double max_p99_duration_warn{0.0};  ///< Seconds
+  double max_p99_duration_error{0.0};  ///< Seconds
+  std::uint64_t overrun_count_warn{0};  ///< Number of overruns in a window that causes a warning
+  std::uint64_t overrun_count_error{0};  ///< Number of overruns in a window that causes an error
+};
+
+/// Reports the health of selected profiles as diagnostic statuses, one per profile, whose levels are determined by
+/// thresholds on the frequency, the 99th percentile of durations and the number of overruns. The percentile requires
+/// histograms (see DurationMeasurement::setHistogramEnabled()); without, only the average duration is reported, and
+/// a threshold on the percentile causes a warning, as the maximum in the snapshots covers all measurements since the
+/// last reset instead of the window. A profile that has never been found is reported as a warning, too, or an error if
+/// it has a minimum frequency for errors.
+///
+/// Each update evaluates only the measurements since the previous update, computed as the difference of the profile's
+/// snapshots, so degradations show up and clear within one update period. If the profile was reset in between, e.g.
+/// by a StatisticsPrinter, the window falls back to the measurements since the reset. The frequency is the average
+/// instantaneous frequency for frequency profiles, and the number of measurements per second otherwise.
+class ProfilingDiagnostics
+{
+public:
+  /// Adds the profiles listed in the "diagnostics" parameter of the given node handle, e.g.:
+  ///
+  ///   diagnostics:
+  ///     - profile: planner/plan  # Profile path, see Profiler::takeSnapshot()
+  ///       min_frequency_warn: 9.0
+  ///       max_p99_duration_warn: 0.05
+  ///       overrun_count_error: 1
+  ProfilingDiagnostics(
+    Profiler& profiler, diagnostic_updater::Updater& updater,
+    const ros::NodeHandle& node_handle = {{"~"}, "profiling"});
+  ProfilingDiagnostics(const ProfilingDiagnostics&) = delete;
+  virtual ~ProfilingDiagnostics();
+
+  ProfilingDiagnostics& operator=(const ProfilingDiagnostics&) = delete;
+
+  void addProfile(const std::string& path, const DiagnosticThresholds& thresholds);
+
+protected:
+  using Clock = std::chrono::steady_clock;
+
+  struct Task
+  {
+    std::string name;
+    std::string path;
+    DiagnosticThresholds thresholds;
+    ProfileSnapshot previous;
+    Clock::time_point previous_time;
+    bool found{false};  ///< Whether the profile has been found at least once
+  };
+
+  void loadParameters(const ros::NodeHandle& node_handle);
+  void evaluate(Task& task, diagnostic_updater::DiagnosticStatusWrapper& status);
+
+  /// Returns the measurements in current that are not in previous, or current if the profile was reset in between.
+  static ProfileSnapshot computeWindow(const ProfileSnapshot& previous, const ProfileSnapshot& current);
+  static bool isReset(const ProfileSnapshot& previous, const ProfileSnapshot& current);
+
+  Profiler* profiler_;
+  diagnostic_updater::Updater* updater_;
+  std::vector<std::unique_ptr<Task>> tasks_;  // Pointers, as the updater's callbacks refer to them
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_PROFILING_DIAGNOSTICS_H
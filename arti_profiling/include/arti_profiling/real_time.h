@@ -0,0 +1,142 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_REAL_TIME_H
+#define ARTI_PROFILING_REAL_TIME_H
+
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/histogram.h>
+#include <arti_profiling/profile.h>
+#include <arti_profiling/profiler.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// Marks the calling thread as real-time (or not). Threads that aren't marked explicitly are considered real-time if
+/// they run with SCHED_FIFO or SCHED_RR when they are first checked.
+void setRealTimeThread(bool real_time);
+bool isRealTimeThread();
+
+/// Counts a violation of real-time constraints if called on a real-time thread, and returns whether it did. Called by
+/// operations that may allocate or block, like creating or looking up profiles.
+bool checkRealTimeViolation(const char* operation);
+
+/// Returns the number of violations so far and the operation that caused the last one (or nullptr if none).
+std::uint64_t getRealTimeViolationCount();
+const char* getLastRealTimeViolation();
+
+/// Duration statistics that can be recorded from a real-time thread. All memory is allocated on construction, at
+/// configure time; commit() neither allocates nor blocks and finishes in a bounded number of steps (wait-free). The
+/// committed values are kept in a fixed-size buffer guarded by a sequence counter, from which the reporting thread
+/// pulls them into regular DurationStatistics whenever the profile is printed, stored or reset.
+///
+/// Only one thread at a time may commit; commits that overlap with another one are dropped and counted.
+class RealTimeDurationProfile : public Profile
+{
+public:
+  using Clock = DurationMeasurement::Clock;
+  using Formatter = DurationStatistics::Formatter;
+
+  /// Durations above this are recorded in the histogram's topmost bucket.
+  static const Clock::duration MAX_HISTOGRAM_DURATION;
+
+  explicit RealTimeDurationProfile(const Formatter& formatter = DurationMeasurement::DEFAULT_FORMATTER);
+
+  /// Records a measurement. Real-time safe, but must not be called by more than one thread at a time.
+  void commit(const Clock::duration& measurement) noexcept;
+
+  std::uint64_t getDroppedCount() const;
+
+  void print(std::ostream& out) const override;
+  void printDetails(std::ostream& out, int indent) const override;
+  bool reset() override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+  std::size_t getMemoryUsage() const override;
+
+protected:
+  using Mutex = std::mutex;
+  using Lock = std::unique_lock<Mutex>;
+
+  /// Moves the values committed since the last call into statistics_; must be called with pull_mutex_ locked.
+  void pull() const;
+
+  std::size_t getBucketOffset(Clock::rep value) const noexcept;
+
+  // Written by the committing thread only, read by pull():
+  std::atomic<std::uint64_t> sequence_{0};  ///< Odd while a commit is in progress
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<Clock::rep> sum_{0};
+  std::atomic<Clock::rep> min_{0};
+  std::atomic<Clock::rep> max_{0};
+  std::atomic<std::uint64_t> reset_acknowledged_{0};
+  std::unique_ptr<std::atomic<std::uint64_t>[]> buckets_;
+  std::atomic<std::uint64_t> dropped_count_{0};
+
+  // Used by the reporting threads, which are serialized by pull_mutex_:
+  std::atomic<std::uint64_t> reset_requested_{0};  ///< Makes the next commit restart the extremes
+  const std::int32_t first_bucket_index_;
+  const std::size_t bucket_count_;
+  mutable Mutex pull_mutex_;
+  mutable std::uint64_t pulled_count_{0};
+  mutable Clock::rep pulled_sum_{0};
+  mutable std::vector<std::uint64_t> pulled_buckets_;
+  mutable std::vector<std::uint64_t> current_buckets_;
+  mutable DurationStatistics statistics_;
+};
+
+/// Measures durations from a real-time thread: create it (which allocates) while configuring, then call start() and
+/// stop() or commit() from the real-time loop.
+class RealTimeDurationMeasurement
+{
+public:
+  using Clock = RealTimeDurationProfile::Clock;
+
+  RealTimeDurationMeasurement(
+    Profiler& profiler, const std::string& name,
+    const RealTimeDurationProfile::Formatter& formatter = DurationMeasurement::DEFAULT_FORMATTER);
+
+  void start(const Clock::time_point& start_time = Clock::now()) noexcept;
+  void stop(const Clock::time_point& stop_time = Clock::now()) noexcept;
+  void commit(const Clock::duration& measurement) noexcept;
+
+  const std::shared_ptr<RealTimeDurationProfile>& getProfile() const;
+
+protected:
+  std::shared_ptr<RealTimeDurationProfile> profile_;
+  Clock::time_point start_time_{DurationMeasurement::NEVER};
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_REAL_TIME_H
@@ -0,0 +1,86 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_RESOURCE_SAMPLER_H
+#define ARTI_PROFILING_RESOURCE_SAMPLER_H
+
+#include <arti_profiling/profiler.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace arti_profiling
+{
+
+/// A thread that periodically samples the resource usage of the process into gauges in a child profiler named
+/// "resources": resident memory, heap in use, open file descriptors, threads, CPU usage, context switch and major page
+/// fault rates. Seen next to the latency statistics, these show whether a slowdown coincides with e.g. memory growth.
+class ResourceSampler
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit ResourceSampler(
+    Profiler& profiler = Profiler::getRootInstance(), const Clock::duration& period = std::chrono::seconds(1));
+  ~ResourceSampler();
+
+  ResourceSampler(const ResourceSampler&) = delete;
+  ResourceSampler& operator=(const ResourceSampler&) = delete;
+
+  /// Takes a sample immediately; normally called by the sampling thread, but safe to call from others.
+  void sample();
+
+protected:
+  struct Counters
+  {
+    Clock::time_point time;
+    double cpu_time{0.0};  ///< User and system time, in seconds
+    std::int64_t voluntary_context_switches{0};
+    std::int64_t involuntary_context_switches{0};
+    std::int64_t major_page_faults{0};
+  };
+
+  void run();
+
+  static std::size_t countOpenFileDescriptors();
+  static bool readStatusValue(const std::string& key, std::int64_t& value);
+
+  Profiler profiler_;
+  Clock::duration period_;
+  std::mutex sample_mutex_;  ///< Serializes samples, which compute rates from last_counters_
+  Counters last_counters_;
+  std::mutex mutex_;
+  std::condition_variable stop_condition_;
+  bool stopped_{false};
+  std::thread thread_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_RESOURCE_SAMPLER_H
@@ -0,0 +1,81 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_SAMPLING_PROFILER_H
+#define ARTI_PROFILING_SAMPLING_PROFILER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace arti_profiling
+{
+
+/// A statistical CPU profiler that samples the call stacks of registered threads, for code that isn't instrumented
+/// with measurements. Each registered thread gets a timer on its CPU time that sends it SIGPROF, whose handler stores
+/// the stack's return addresses (and the innermost active DurationMeasurement) in a buffer allocated on start().
+/// Addresses are only symbolized when writing the samples, as folded stacks for flame graph tools; functions that
+/// aren't exported by their binary show up as binary+offset unless it's linked with -rdynamic.
+///
+/// Samples of threads that were busy in the kernel, or whose stacks lack frame information, may be truncated.
+class SamplingProfiler
+{
+public:
+  static const std::size_t MAX_STACK_DEPTH;
+  static const std::size_t MAX_SCOPE_NAME_LENGTH;
+
+  SamplingProfiler() = delete;
+
+  /// Allocates a buffer for the given number of samples and starts sampling all registered threads (including the
+  /// calling one) with the given interval of CPU time. Throws std::runtime_error if the timers cannot be created.
+  static void start(
+    const std::chrono::microseconds& interval = std::chrono::milliseconds(10), std::size_t capacity = 10000);
+  static void stop();
+  static bool isRunning();
+
+  /// Makes the calling thread be sampled while the profiler is running, until the thread exits.
+  static void registerThread();
+
+  /// Discards the samples recorded so far.
+  static void clear();
+  static std::size_t getSampleCount();
+  static std::size_t getDroppedCount();
+
+  /// Writes one line per distinct stack, consisting of the thread, the active measurement (if any) and the frames from
+  /// the outermost to the innermost, all separated by semicolons, followed by the number of samples.
+  static void writeFoldedStacks(std::ostream& out);
+
+  /// Called by DurationMeasurement to attribute samples to it; enterScope() returns the value to pass to leaveScope(),
+  /// which only has an effect on the same thread.
+  static std::uintptr_t enterScope(const std::string& name) noexcept;
+  static void leaveScope(std::uintptr_t scope) noexcept;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_SAMPLING_PROFILER_H
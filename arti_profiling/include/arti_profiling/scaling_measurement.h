@@ -0,0 +1,139 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_SCALING_MEASUREMENT_H
+#define ARTI_PROFILING_SCALING_MEASUREMENT_H
+
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profiler.h>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// Cost models that ScalingStatistics fits to durations, as duration = a + b * f(n) for an input size n.
+enum class Complexity
+{
+  UNKNOWN,  ///< No expectation; only used as expected complexity
+  LINEAR,  ///< f(n) = n
+  N_LOG_N,  ///< f(n) = n * log2(n)
+  QUADRATIC,  ///< f(n) = n^2
+};
+
+const char* toString(Complexity complexity);
+
+/// Statistics of durations together with the input sizes they were measured for. A bounded reservoir keeps a uniform
+/// random sample of the (n, duration) pairs, to which each model is fitted by least squares when printing. The model
+/// with the best fit is reported and flagged if it grows faster than the expected model. As the models are strongly
+/// correlated (n and n log n in particular), a faster growing model only counts as the better fit if its R^2 exceeds
+/// that of the slower one by MIN_R_SQUARED_MARGIN; otherwise, noise would decide between them.
+class ScalingStatistics : public DurationStatistics
+{
+public:
+  static const std::size_t DEFAULT_RESERVOIR_SIZE;
+  static const double MIN_SIZE_RATIO;
+  static const double MIN_R_SQUARED_MARGIN;
+
+  /// The least squares fit of a model.
+  struct Fit
+  {
+    Complexity complexity{Complexity::UNKNOWN};
+    double offset{0.0};  ///< a, in nanoseconds
+    double factor{0.0};  ///< b, in nanoseconds per unit of f(n)
+    double r_squared{0.0};
+  };
+
+  explicit ScalingStatistics(
+    Formatter formatter = DurationMeasurement::DEFAULT_FORMATTER, std::size_t reservoir_size = DEFAULT_RESERVOIR_SIZE);
+
+  void accumulateScaling(std::size_t n, const DurationMeasurement::Clock::duration& duration);
+
+  Complexity getExpectedComplexity() const;
+  void setExpectedComplexity(Complexity complexity);
+
+  /// Fits all models to the current reservoir; returns an empty vector if the sizes don't vary enough to tell the
+  /// models apart (less than a factor of MIN_SIZE_RATIO between smallest and largest size).
+  std::vector<Fit> fit() const;
+
+  /// Returns the slowest growing fit whose R^2 no faster growing fit exceeds by MIN_R_SQUARED_MARGIN, or a fit with
+  /// complexity UNKNOWN if there is none.
+  Fit getBestFit() const;
+
+  /// Returns whether the best fit grows faster than the expected complexity.
+  bool exceedsExpectedComplexity() const;
+
+  void printDetails(std::ostream& out, int indent) const override;
+  void clear() override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+  std::size_t getMemoryUsage() const override;
+
+protected:
+  static double evaluate(Complexity complexity, double n);
+  static Fit getBestFit(const std::vector<Fit>& fits);
+
+  void printAdditionalValues(std::ostream& out) const override;
+
+  std::size_t reservoir_size_;
+  std::vector<std::pair<double, double>> reservoir_;  ///< (n, duration in nanoseconds)
+  std::uint64_t scaling_count_{0};
+  std::minstd_rand random_;
+  Complexity expected_complexity_{Complexity::UNKNOWN};
+};
+
+/// Measures the duration of processing an input of a given size, e.g. the number of points of a cloud, so that the
+/// profile can report how the duration scales with the size.
+class ScalingMeasurement
+{
+public:
+  using Clock = DurationMeasurement::Clock;
+
+  ScalingMeasurement(
+    Profiler& profiler, std::string name, std::size_t n, Complexity expected_complexity = Complexity::UNKNOWN,
+    const Clock::time_point& start_time = Clock::now());
+  ~ScalingMeasurement();
+
+  void start(const Clock::time_point& start_time = Clock::now());
+  void stop(const Clock::time_point& stop_time = Clock::now());
+
+  /// Sets the input size, if it's only known after starting the measurement.
+  void setSize(std::size_t n);
+
+protected:
+  Profiler* profiler_;
+  std::string name_;
+  std::size_t n_;
+  Complexity expected_complexity_;
+  Clock::time_point start_time_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_SCALING_MEASUREMENT_H
@@ -0,0 +1,181 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_SNAPSHOT_H
+#define ARTI_PROFILING_SNAPSHOT_H
+
+#include <arti_profiling/histogram.h>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// A measurement value that is either integral or floating-point, so that both can be stored without loss.
+struct SnapshotValue
+{
+  bool integral{false};
+  std::int64_t integer{0};
+  double real{0.0};
+
+  template<typename T>
+  static SnapshotValue from(const T& value)
+  {
+    return from(value, std::is_integral<T>());
+  }
+
+  template<typename T>
+  T to() const
+  {
+    return integral ? static_cast<T>(integer) : static_cast<T>(real);
+  }
+
+  double toDouble() const;
+
+  SnapshotValue& operator+=(const SnapshotValue& other);
+  bool operator<(const SnapshotValue& other) const;
+  bool operator==(const SnapshotValue& other) const;
+  bool operator!=(const SnapshotValue& other) const;
+
+protected:
+  template<typename T>
+  static SnapshotValue from(const T& value, std::true_type /*integral*/)
+  {
+    SnapshotValue result;
+    result.integral = true;
+    result.integer = static_cast<std::int64_t>(value);
+    return result;
+  }
+
+  template<typename T>
+  static SnapshotValue from(const T& value, std::false_type /*integral*/)
+  {
+    SnapshotValue result;
+    result.real = static_cast<double>(value);
+    return result;
+  }
+};
+
+struct SampleSnapshot
+{
+  SnapshotValue value;
+  std::int64_t time{0};  // Nanoseconds since the epoch
+  std::string thread;
+  std::string tag;
+
+  bool operator==(const SampleSnapshot& other) const;
+};
+
+/// The state of a single profile. Durations are stored in ticks of DurationMeasurement::Clock, which are nanoseconds
+/// (checked at compile time), times in nanoseconds since the epoch.
+struct ProfileSnapshot
+{
+  std::string type;
+  std::uint64_t count{0};
+  SnapshotValue sum;
+  SnapshotValue min;
+  SnapshotValue max;
+  Histogram histogram;
+  std::uint64_t top_sample_capacity{0};
+  std::vector<SampleSnapshot> top_samples;
+  std::uint64_t overrun_count{0};
+  std::int64_t last_overrun{0};
+  std::int64_t last_overrun_budget{0};
+  std::int64_t last_overrun_time{0};
+  std::map<std::string, ProfileSnapshot> labels;
+  std::map<std::string, std::int64_t> counters;  ///< Further profile-specific counts, summed when merging
+
+  double getAverage() const;
+
+  /// Returns the estimated memory usage of this snapshot in bytes, including its labels.
+  std::size_t getMemoryUsage() const;
+
+  /// Combines the other snapshot into this one; returns false if their types differ.
+  bool merge(const ProfileSnapshot& other);
+
+  bool operator==(const ProfileSnapshot& other) const;
+  bool operator!=(const ProfileSnapshot& other) const;
+};
+
+/// The state of a Profiler and all its children.
+struct ProfilerSnapshot
+{
+  static const std::uint32_t VERSION;
+
+  std::string name;
+  std::int64_t time{0};  // Nanoseconds since the epoch
+  std::map<std::string, ProfileSnapshot> profiles;
+  std::vector<ProfilerSnapshot> children;
+
+  /// The profiles of this profiler and all its descendants merged by name; only set by computeRollUp(), and neither
+  /// stored in snapshot files nor compared.
+  std::map<std::string, ProfileSnapshot> rollup;
+
+  ProfilerSnapshot* findChild(const std::string& child_name);
+  const ProfilerSnapshot* findChild(const std::string& child_name) const;
+
+  /// Returns the estimated memory usage of this snapshot in bytes, including its children and roll-up.
+  std::size_t getMemoryUsage() const;
+
+  /// Combines the other snapshot into this one, matching profiles and children by name.
+  void merge(const ProfilerSnapshot& other);
+
+  /// Computes the roll-ups of this snapshot and all its children, bottom-up: each roll-up merges the profiles of its
+  /// snapshot with the roll-ups of the children, so every profile is merged only once per level.
+  void computeRollUp();
+
+  bool operator==(const ProfilerSnapshot& other) const;
+  bool operator!=(const ProfilerSnapshot& other) const;
+};
+
+/// Returns whether the values of profile snapshots of the given type are durations, i.e. nanoseconds.
+bool isDurationType(const std::string& type);
+
+/// Prints the statistics of a profile snapshot in the format of Statistics::print(), choosing the unit by its type.
+void printSnapshot(std::ostream& out, const ProfileSnapshot& snapshot);
+
+void writeBinary(std::ostream& out, const ProfilerSnapshot& snapshot);
+ProfilerSnapshot readBinary(std::istream& in);
+
+void writeJson(std::ostream& out, const ProfilerSnapshot& snapshot);
+
+/// Writes a JSON array of snapshots, each in the same format as written by writeJson().
+void writeJson(std::ostream& out, const std::vector<ProfilerSnapshot>& snapshots);
+ProfilerSnapshot readJson(std::istream& in);
+
+/// Loads a snapshot file, detecting its format from its content. Throws std::runtime_error on errors.
+ProfilerSnapshot loadSnapshot(const std::string& file_name);
+
+/// Saves a snapshot file in JSON format if the file name ends with ".json", in binary format otherwise.
+void saveSnapshot(const std::string& file_name, const ProfilerSnapshot& snapshot);
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_SNAPSHOT_H
@@ -0,0 +1,164 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_SPAN_H
+#define ARTI_PROFILING_SPAN_H
+
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profile.h>
+#include <arti_profiling/profiler.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// Measures an operation that may start and end in different threads or callbacks, e.g. from receiving an action
+/// goal until sending its result. Spans are moved along with the work (through queues, futures, lambda captures);
+/// each hop records the time since the previous hop as a named segment, finishing records the total latency.
+class Span
+{
+public:
+  using Clock = DurationMeasurement::Clock;
+  using Id = std::uint64_t;
+
+  /// Returns a new process-wide unique span ID (never 0).
+  static Id generateId();
+
+  Span() = default;
+  Span(Profiler& profiler, std::string name, const Clock::time_point& start_time = Clock::now());
+  Span(Profiler& profiler, std::string name, Id id, const Clock::time_point& start_time = Clock::now());
+  Span(const Span&) = delete;
+  Span(Span&& other) noexcept;
+  ~Span();
+
+  Span& operator=(const Span&) = delete;
+  Span& operator=(Span&& other) noexcept;
+
+  Id getId() const;
+  bool isActive() const;
+
+  /// Records the time since the start or the previous hop as the given segment.
+  void hop(const std::string& segment, const Clock::time_point& time = Clock::now());
+
+  /// Records the total duration, plus the time since the previous hop as the given segment, if it's not empty.
+  void finish(const std::string& last_segment = std::string(), const Clock::time_point& time = Clock::now());
+
+  /// Ends the span without recording its duration; it's counted as abandoned instead. Also done on destruction.
+  void abandon();
+
+protected:
+  Profiler* profiler_{nullptr};
+  std::string name_;
+  Id id_{0};
+  Clock::time_point start_time_;
+  Clock::time_point last_time_;
+};
+
+/// Tracks spans by ID only, for cases where just an ID can be passed on (e.g. a goal ID or a message sequence number).
+/// The table has a fixed capacity and is lock-free: slots are claimed and released with atomic operations. A slot is
+/// claimed by storing its ID tagged as pending, then its times are stored, and then the ID is published, so other
+/// threads only find a span once its times are valid. Concurrent starts of the same ID are resolved so that exactly
+/// one of them succeeds.
+class SpanTable
+{
+public:
+  using Clock = Span::Clock;
+  using Id = Span::Id;
+
+  SpanTable(Profiler& profiler, std::string name, std::size_t capacity = 1024);
+
+  /// Starts tracking the span with the given ID; returns false if the ID is 0 or has the highest bit set (these are
+  /// reserved), is already used or the table is full.
+  bool start(Id id, const Clock::time_point& time = Clock::now());
+
+  /// Returns false if there's no span with the given ID.
+  bool hop(Id id, const std::string& segment, const Clock::time_point& time = Clock::now());
+  bool finish(Id id, const std::string& last_segment = std::string(), const Clock::time_point& time = Clock::now());
+  bool abandon(Id id);
+
+protected:
+  static const std::size_t MAX_PROBES = 32;
+
+  /// Tag of IDs of slots being claimed; on its own, it marks a slot that is being released.
+  static constexpr Id PENDING = Id(1) << 63;
+
+  struct Slot
+  {
+    std::atomic<Id> id{0};
+    std::atomic<Clock::rep> start_time{0};
+    std::atomic<Clock::rep> last_time{0};
+  };
+
+  Slot* find(Id id);
+  std::size_t getProbeCount() const;
+
+  Profiler* profiler_;
+  std::string name_;
+  std::size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+};
+
+/// Statistics of a span: the total duration, the duration of each segment (in order of appearance), and the number of
+/// abandoned spans.
+class SpanStatistics : public DurationStatistics
+{
+public:
+  explicit SpanStatistics(Formatter formatter = DurationMeasurement::DEFAULT_FORMATTER);
+
+  void printDetails(std::ostream& out, int indent) const override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+  std::size_t getMemoryUsage() const override;
+  bool merge(const Profile& other) override;
+
+  void accumulateSegment(const std::string& segment, const DurationMeasurement::Clock::duration& duration);
+  void accumulateAbandoned();
+
+  /// Records a span event in the given profiler's profile with the given name. If segment is nullptr, the total
+  /// duration is recorded.
+  static void commit(
+    Profiler& profiler, const std::string& name, const std::string* segment,
+    const DurationMeasurement::Clock::duration& duration);
+  static void commitAbandoned(Profiler& profiler, const std::string& name);
+
+protected:
+  static std::shared_ptr<SpanStatistics> getSpanStatistics(Profiler::ProfileUpdate& profile_update);
+
+  void printAdditionalValues(std::ostream& out) const override;
+
+  std::vector<std::pair<std::string, std::unique_ptr<DurationStatistics>>> segments_;
+  std::size_t abandoned_count_{0};
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_SPAN_H
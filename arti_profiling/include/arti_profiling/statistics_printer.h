@@ -28,15 +28,23 @@
 #define ARTI_PROFILING_STATISTICS_PRINTER_H
 
 #include <arti_profiling/profiler.h>
+#include <arti_profiling/async_log_sink.h>
+#include <arti_profiling/GetProfilingHistory.h>
 #include <arti_profiling/StatisticsPrinterConfig.h>
 #include <dynamic_reconfigure/server.h>
 #include <iosfwd>
+#include <memory>
+#include <mutex>
 #include <ros/node_handle.h>
+#include <ros/service_server.h>
 #include <ros/wall_timer.h>
 
 namespace arti_profiling
 {
 
+/// Prints and clears the statistics of a profiler regularly. The statistics are written by an AsyncLogSink, to the
+/// given stream or to rotating files, so that slow output never delays the timer callback. The statistics of past
+/// intervals are kept in the profiler's history, which the get_profiling_history service makes available.
 class StatisticsPrinter
 {
 public:
@@ -49,13 +57,19 @@ public:
 protected:
   void printStatistics(const ros::WallTimerEvent&);
   void reconfigure(const StatisticsPrinterConfig& config);
+  bool getHistory(GetProfilingHistory::Request& request, GetProfilingHistory::Response& response);
+  std::unique_ptr<AsyncLogSink> createSink(const StatisticsPrinterConfig& config) const;
 
   Profiler* profiler_;
   std::ostream* out_;
   ros::NodeHandle node_handle_;
   dynamic_reconfigure::Server<StatisticsPrinterConfig> config_server_;
   StatisticsPrinterConfig config_;
+  std::mutex sink_mutex_;  ///< Guards sink_ and json_format_, which the timer callback may use concurrently
+  std::unique_ptr<AsyncLogSink> sink_;
+  bool json_format_{false};
   ros::WallTimer timer_;
+  ros::ServiceServer history_service_;
 };
 
 }  // namespace arti_profiling
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_THREAD_UTILIZATION_H
+#define ARTI_PROFILING_THREAD_UTILIZATION_H
+
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profile.h>
+#include <arti_profiling/profiler.h>
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// Busy and idle time of the threads of a pool (e.g. the threads of a ros::AsyncSpinner or of a worker pool). Threads
+/// join the pool with a ThreadRegistration and mark their busy periods with BusyScopes. The profile persists between
+/// intervals and reports, per thread, the share of the interval spent busy (measured by the BusyScopes) and running
+/// on a CPU (measured by the thread's CPU time), plus the busy period durations.
+class ThreadPoolUtilization : public Profile
+{
+public:
+  using Clock = DurationMeasurement::Clock;
+
+  struct ThreadState
+  {
+    explicit ThreadState(std::string name);
+
+    std::string name;
+    clockid_t cpu_clock;
+    std::atomic<Clock::rep> busy_time{0};  ///< Of the finished busy periods in the interval below
+    std::atomic<Clock::rep> busy_time_interval{0};  ///< Start of the interval busy_time belongs to
+    std::atomic<Clock::rep> busy_since{0};  ///< Start of the current busy period, zero if idle
+    std::atomic<std::int64_t> cpu_time_at_interval_start{0};
+    DurationStatistics busy_periods;
+  };
+
+  using ThreadStatePtr = std::shared_ptr<ThreadState>;
+
+  /// Returns the pool with the given name in the given profiler, creating it if necessary.
+  static std::shared_ptr<ThreadPoolUtilization> getPool(Profiler& profiler, const std::string& name);
+
+  ThreadPoolUtilization();
+
+  void print(std::ostream& out) const override;
+  void printDetails(std::ostream& out, int indent) const override;
+  bool reset() override;
+  std::size_t getMemoryUsage() const override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+
+  ThreadStatePtr addThread(std::string name);
+  void removeThread(const ThreadStatePtr& thread);
+  std::size_t getThreadCount() const;
+
+  /// Marks the beginning and end of a busy period of the given thread; they must be called by that thread.
+  void beginBusy(ThreadState& thread, const Clock::time_point& time = Clock::now());
+  void endBusy(ThreadState& thread, const Clock::time_point& time = Clock::now());
+
+protected:
+  using Mutex = std::recursive_mutex;
+  using Lock = std::unique_lock<Mutex>;
+
+  struct Utilization
+  {
+    double busy{0.0};
+    double cpu{0.0};
+  };
+
+  Utilization getUtilization(const ThreadState& thread, const Clock::time_point& now) const;
+  static std::int64_t getCpuTime(const ThreadState& thread);
+
+  mutable Mutex mutex_;
+  std::vector<ThreadStatePtr> threads_;
+  std::atomic<Clock::rep> interval_start_;
+  std::atomic<int> automatic_thread_count_{0};
+
+  friend class BusyScope;
+};
+
+/// Registers the calling thread with a thread pool for as long as it exists.
+class ThreadRegistration
+{
+public:
+  ThreadRegistration(Profiler& profiler, const std::string& pool_name, std::string thread_name);
+  ThreadRegistration(const ThreadRegistration&) = delete;
+  ~ThreadRegistration();
+
+  ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+
+  /// Returns the registration of the calling thread, or nullptr if it isn't registered.
+  static ThreadRegistration* getCurrent();
+
+  ThreadPoolUtilization& getPool() const;
+  ThreadPoolUtilization::ThreadState& getState() const;
+
+  /// Marks the thread busy; calls can be nested. Must be called by the registered thread.
+  void beginBusy();
+  void endBusy();
+
+protected:
+  std::shared_ptr<ThreadPoolUtilization> pool_;
+  ThreadPoolUtilization::ThreadStatePtr state_;
+  ThreadRegistration* previous_;
+  int busy_depth_{0};
+};
+
+/// Marks the calling thread as busy while it exists. Nested scopes are counted once. Does nothing if the thread is not
+/// registered, unless a profiler and pool name are given: then unregistered threads are registered automatically
+/// (named after the pool and numbered), which suits threads one doesn't create oneself, like those of spinners.
+class BusyScope
+{
+public:
+  BusyScope();
+  BusyScope(Profiler& profiler, const std::string& pool_name);
+  BusyScope(const BusyScope&) = delete;
+  ~BusyScope();
+
+  BusyScope& operator=(const BusyScope&) = delete;
+
+protected:
+  ThreadRegistration* registration_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_THREAD_UTILIZATION_H
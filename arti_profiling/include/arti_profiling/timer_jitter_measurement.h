@@ -0,0 +1,94 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_TIMER_JITTER_MEASUREMENT_H
+#define ARTI_PROFILING_TIMER_JITTER_MEASUREMENT_H
+
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profiler.h>
+#include <cstdint>
+#include <memory>
+#include <ros/forwards.h>
+#include <string>
+
+namespace arti_profiling
+{
+
+/// Statistics of a periodic callback: the lateness of its calls relative to their expected times (which are the
+/// values of the base statistics), the deviation of the actual from the expected periods, and the callback durations.
+class TimerJitterStatistics : public DurationStatistics
+{
+public:
+  explicit TimerJitterStatistics(Formatter formatter);
+
+  void accumulateCall(
+    const DurationMeasurement::Clock::duration& lateness, const DurationMeasurement::Clock::duration* period_error);
+  void accumulateCallbackDuration(const DurationMeasurement::Clock::duration& duration);
+
+  void printDetails(std::ostream& out, int indent) const override;
+  void clear() override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+  std::size_t getMemoryUsage() const override;
+
+protected:
+  DurationStatistics period_errors_;
+  DurationStatistics callback_durations_;
+};
+
+/// Records how late timer callbacks run, from the expected and actual times in their events. Wrap a callback when
+/// creating the timer, e.g. nh.createTimer(period, jitter.wrap(callback)), to also record the callback durations.
+class TimerJitterMeasurement
+{
+public:
+  using Clock = DurationMeasurement::Clock;
+  using Formatter = DurationStatistics::Formatter;
+
+  static const Formatter DEFAULT_FORMATTER;  ///< Microseconds
+
+  TimerJitterMeasurement(Profiler& profiler, std::string name, Formatter formatter = DEFAULT_FORMATTER);
+
+  ros::TimerCallback wrap(ros::TimerCallback callback) const;
+  ros::WallTimerCallback wrap(ros::WallTimerCallback callback) const;
+
+  void record(const ros::TimerEvent& event) const;
+  void record(const ros::WallTimerEvent& event) const;
+
+  /// Records the lateness of periodic work not driven by a ROS timer, e.g. a loop sleeping until its next period.
+  void record(const Clock::time_point& expected, const Clock::time_point& actual) const;
+
+protected:
+  std::shared_ptr<TimerJitterStatistics> getStatistics() const;
+  void record(std::int64_t lateness_ns, bool has_period, std::int64_t period_error_ns) const;
+  void recordCallbackDuration(const Clock::duration& duration) const;
+
+  Profiler* profiler_;
+  std::string name_;
+  Formatter formatter_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_TIMER_JITTER_MEASUREMENT_H
@@ -0,0 +1,211 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_TOP_SAMPLES_H
+#define ARTI_PROFILING_TOP_SAMPLES_H
+
+#include <algorithm>
+#include <boost/format.hpp>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace arti_profiling
+{
+
+/// Keeps the K largest samples seen so far, together with the context they were recorded in. The samples are kept in
+/// a min-heap of fixed capacity, so checking whether a sample is among the largest ones is a single comparison.
+template<typename T>
+class TopSamples
+{
+public:
+  using Clock = std::chrono::system_clock;
+
+  struct Sample
+  {
+    T value;
+    Clock::time_point time;
+    std::thread::id thread_id;
+    std::string tag;
+  };
+
+  explicit TopSamples(std::size_t capacity = 0)
+  {
+    setCapacity(capacity);
+  }
+
+  std::size_t getCapacity() const
+  {
+    return capacity_;
+  }
+
+  void setCapacity(const std::size_t capacity)
+  {
+    capacity_ = capacity;
+    samples_.reserve(capacity_);
+    while (samples_.size() > capacity_)
+    {
+      std::pop_heap(samples_.begin(), samples_.end(), &TopSamples::isLarger);
+      samples_.pop_back();
+    }
+  }
+
+  bool accepts(const T& value) const
+  {
+    return samples_.size() < capacity_ || (!samples_.empty() && samples_.front().value < value);
+  }
+
+  void add(
+    const T& value, const std::string& tag, const Clock::time_point& time = Clock::now(),
+    const std::thread::id& thread_id = std::this_thread::get_id())
+  {
+    add(Sample{value, time, thread_id, tag});
+  }
+
+  void add(Sample sample)
+  {
+    if (!accepts(sample.value))
+    {
+      return;
+    }
+
+    if (samples_.size() >= capacity_)
+    {
+      std::pop_heap(samples_.begin(), samples_.end(), &TopSamples::isLarger);
+      samples_.pop_back();
+    }
+    samples_.push_back(std::move(sample));
+    std::push_heap(samples_.begin(), samples_.end(), &TopSamples::isLarger);
+  }
+
+  /// Adds the other's samples, growing the capacity to the larger of both.
+  void merge(const TopSamples& other)
+  {
+    if (other.capacity_ > capacity_)
+    {
+      setCapacity(other.capacity_);
+    }
+    for (const Sample& sample : other.samples_)
+    {
+      add(sample);
+    }
+  }
+
+  bool empty() const
+  {
+    return samples_.empty();
+  }
+
+  /// Returns an estimate of the memory allocated for the samples, in bytes.
+  std::size_t getMemoryUsage() const
+  {
+    std::size_t result = samples_.capacity() * sizeof(Sample);
+    for (const Sample& sample : samples_)
+    {
+      result += sample.tag.capacity();
+    }
+    return result;
+  }
+
+  void clear()
+  {
+    samples_.clear();
+  }
+
+  /// Returns the samples sorted from largest to smallest.
+  std::vector<Sample> getSorted() const
+  {
+    std::vector<Sample> result(samples_);
+    std::sort(result.begin(), result.end(), [](const Sample& a, const Sample& b) { return b.value < a.value; });
+    return result;
+  }
+
+  static double toSeconds(const Clock::time_point& time)
+  {
+    return std::chrono::duration_cast<std::chrono::duration<double>>(time.time_since_epoch()).count();
+  }
+
+  static void printSample(
+    std::ostream& out, const Sample& sample, const std::function<void(std::ostream&, const T&)>& formatter)
+  {
+    formatter(out, sample.value);
+    out << boost::format(" at %.6f") % toSeconds(sample.time) << " in thread " << sample.thread_id;
+    if (!sample.tag.empty())
+    {
+      out << " [" << sample.tag << "]";
+    }
+  }
+
+  /// Writes one CSV row per sample, each starting with the given (already quoted) prefix.
+  void exportCsv(std::ostream& out, const std::string& prefix) const
+  {
+    for (const Sample& sample : getSorted())
+    {
+      out << prefix << sample.value << ',' << boost::format("%.6f") % toSeconds(sample.time) << ','
+          << sample.thread_id << ',';
+      writeCsvField(out, sample.tag);
+      out << '\n';
+    }
+  }
+
+  static void writeCsvField(std::ostream& out, const std::string& field)
+  {
+    if (field.find_first_of(",\"\n") == std::string::npos)
+    {
+      out << field;
+      return;
+    }
+
+    out << '"';
+    for (const char c : field)
+    {
+      if (c == '"')
+      {
+        out << '"';
+      }
+      out << c;
+    }
+    out << '"';
+  }
+
+protected:
+  static bool isLarger(const Sample& a, const Sample& b)
+  {
+    return b.value < a.value;
+  }
+
+  std::size_t capacity_{0};
+  std::vector<Sample> samples_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_TOP_SAMPLES_H
@@ -0,0 +1,211 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_TOPIC_PROFILING_H
+#define ARTI_PROFILING_TOPIC_PROFILING_H
+
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/frequency_measurement.h>
+#include <arti_profiling/profile.h>
+#include <arti_profiling/profiler.h>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ros/node_handle.h>
+#include <ros/serialization.h>
+#include <string>
+
+namespace arti_profiling
+{
+
+/// Statistics of the serialized sizes of the messages on a topic, plus their throughput in bytes per second since the
+/// first message.
+class MessageSizeStatistics : public Statistics<double>
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static const Formatter DEFAULT_FORMATTER;
+
+  explicit MessageSizeStatistics(Formatter formatter = DEFAULT_FORMATTER);
+
+  void clear() override;
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override;
+
+protected:
+  void printAdditionalValues(std::ostream& out) const override;
+
+  Clock::time_point first_time_;
+};
+
+/// The child profiler of a topic, shared by all profiled subscribers and publishers of the topic below a profiler.
+class TopicProfiler
+{
+public:
+  /// The profiles of the messages received or published on the topic. As they are updated for every message, they
+  /// are looked up only once, and stay in the profiler when it is cleared, like LockStatistics.
+  struct MessageProfiles
+  {
+    MessageProfiles(
+      Profiler& profiler, std::string rate_name, const std::string& size_name, std::string duration_name);
+
+    /// Accumulates the rate and the size of a message.
+    void accumulate(std::size_t message_size) const;
+
+    std::string rate_name;
+    std::string duration_name;
+    std::shared_ptr<FrequencyStatistics> rate;
+    std::shared_ptr<MessageSizeStatistics> size;
+    std::shared_ptr<DurationStatistics> duration;  ///< Of the callbacks or the publish() calls
+  };
+
+  TopicProfiler(Profiler& parent, const std::string& topic);
+
+  /// Returns the topic profiler for the given topic below the given profiler, creating it if necessary.
+  static std::shared_ptr<TopicProfiler> get(Profiler& parent, const std::string& topic);
+
+  Profiler& getProfiler();
+
+  /// Returns the profiles of received or published messages, creating them on the first call.
+  const MessageProfiles& getReceivedProfiles();
+  const MessageProfiles& getPublishedProfiles();
+
+protected:
+  Profiler profiler_;
+  std::once_flag received_profiles_flag_;
+  std::unique_ptr<MessageProfiles> received_profiles_;
+  std::once_flag published_profiles_flag_;
+  std::unique_ptr<MessageProfiles> published_profiles_;
+};
+
+/// Subscribes to a topic like ros::NodeHandle::subscribe(), recording the callback durations, the message rate and
+/// the message sizes in a child profiler of the given one, named after the topic.
+template<typename M>
+ros::Subscriber subscribe(
+  Profiler& profiler, ros::NodeHandle& node_handle, const std::string& topic, const std::uint32_t queue_size,
+  const boost::function<void(const boost::shared_ptr<M const>&)>& callback,
+  const ros::TransportHints& transport_hints = ros::TransportHints())
+{
+  // The topic profiler is captured to keep its profiles alive:
+  const std::shared_ptr<TopicProfiler> topic_profiler = TopicProfiler::get(profiler, node_handle.resolveName(topic));
+  const TopicProfiler::MessageProfiles* const profiles = &topic_profiler->getReceivedProfiles();
+  const boost::function<void(const boost::shared_ptr<M const>&)> profiled_callback
+    = [topic_profiler, profiles, callback](const boost::shared_ptr<M const>& message)
+    {
+      profiles->accumulate(ros::serialization::serializationLength(*message));
+      DurationMeasurement measurement(*profiles->duration, profiles->duration_name);
+      callback(message);
+    };
+  return node_handle.subscribe<M>(topic, queue_size, profiled_callback, ros::VoidConstPtr(), transport_hints);
+}
+
+template<typename M>
+ros::Subscriber subscribe(
+  Profiler& profiler, ros::NodeHandle& node_handle, const std::string& topic, const std::uint32_t queue_size,
+  void (*callback)(const boost::shared_ptr<M const>&), const ros::TransportHints& transport_hints = ros::TransportHints())
+{
+  return subscribe<M>(
+    profiler, node_handle, topic, queue_size, boost::function<void(const boost::shared_ptr<M const>&)>(callback),
+    transport_hints);
+}
+
+template<typename M, typename T>
+ros::Subscriber subscribe(
+  Profiler& profiler, ros::NodeHandle& node_handle, const std::string& topic, const std::uint32_t queue_size,
+  void (T::*callback)(const boost::shared_ptr<M const>&), T* object,
+  const ros::TransportHints& transport_hints = ros::TransportHints())
+{
+  return subscribe<M>(
+    profiler, node_handle, topic, queue_size, boost::function<void(const boost::shared_ptr<M const>&)>(
+      [callback, object](const boost::shared_ptr<M const>& message) { (object->*callback)(message); }),
+    transport_hints);
+}
+
+/// A publisher that records the durations of publish() calls, the message rate and the message sizes in the profiler
+/// of its topic.
+class ProfiledPublisher
+{
+public:
+  ProfiledPublisher() = default;
+  ProfiledPublisher(Profiler& profiler, ros::Publisher publisher);
+
+  template<typename M>
+  void publish(const M& message) const
+  {
+    if (profiles_ != nullptr)
+    {
+      profiles_->accumulate(ros::serialization::serializationLength(message));
+      DurationMeasurement measurement(*profiles_->duration, profiles_->duration_name);
+      publisher_.publish(message);
+    }
+    else
+    {
+      publisher_.publish(message);
+    }
+  }
+
+  template<typename M>
+  void publish(const boost::shared_ptr<M>& message) const
+  {
+    if (profiles_ != nullptr)
+    {
+      profiles_->accumulate(ros::serialization::serializationLength(*message));
+      DurationMeasurement measurement(*profiles_->duration, profiles_->duration_name);
+      publisher_.publish(message);
+    }
+    else
+    {
+      publisher_.publish(message);
+    }
+  }
+
+  const ros::Publisher& getPublisher() const;
+  std::string getTopic() const;
+  std::uint32_t getNumSubscribers() const;
+  void shutdown();
+
+protected:
+  ros::Publisher publisher_;
+  std::shared_ptr<TopicProfiler> topic_profiler_;
+  const TopicProfiler::MessageProfiles* profiles_{nullptr};  ///< Owned by topic_profiler_
+};
+
+/// Advertises a topic like ros::NodeHandle::advertise(), returning a publisher that profiles the published messages.
+template<typename M>
+ProfiledPublisher advertise(
+  Profiler& profiler, ros::NodeHandle& node_handle, const std::string& topic, const std::uint32_t queue_size,
+  const bool latch = false)
+{
+  return ProfiledPublisher(profiler, node_handle.advertise<M>(topic, queue_size, latch));
+}
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_TOPIC_PROFILING_H
@@ -0,0 +1,115 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_VALUE_MEASUREMENT_H
+#define ARTI_PROFILING_VALUE_MEASUREMENT_H
+
+#include <arti_profiling/profile.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/simple_formatter.h>
+#include <memory>
+#include <ros/console.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace arti_profiling
+{
+
+/// Emits the value probe and records the value in the flight recorder. This is not part of the template, because the
+/// probes are defined in the library's translation units.
+void recordValue(const std::string& name, double value);
+
+/// Records the distribution of a value, typically the size of the work done by an operation, like the number of points
+/// in a cloud, nodes expanded in a search or iterations of an optimizer, which explains the distribution of its
+/// duration. T may be any arithmetic type.
+template<typename T>
+class ValueMeasurement
+{
+public:
+  using Formatter = typename Statistics<T>::Formatter;
+
+  /// Records the value, formatted with the given unit (e.g. "pts") and no decimals for integral types.
+  ValueMeasurement(
+    Profiler& profiler, const std::string& name, const T& value, const std::string& unit = std::string(),
+    bool histogram_enabled = false)
+    : ValueMeasurement(profiler, name, value, getFormatter(unit), histogram_enabled)
+  {
+  }
+
+  /// Records the value; enabling the histogram makes quantiles available, see Statistics::setHistogramEnabled().
+  ValueMeasurement(
+    Profiler& profiler, const std::string& name, const T& value, const Formatter& formatter, bool histogram_enabled)
+  {
+    recordValue(name, static_cast<double>(value));
+
+    Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+    if (!profile_update.profile)
+    {
+      profile_update.profile = std::make_shared<ValueStatistics>(formatter);
+    }
+
+    std::shared_ptr<ValueStatistics> vs = std::dynamic_pointer_cast<ValueStatistics>(profile_update.profile);
+    if (vs)
+    {
+      if (histogram_enabled && !vs->isHistogramEnabled())
+      {
+        vs->setHistogramEnabled(true);
+      }
+      vs->accumulate(value);
+    }
+    else
+    {
+      ROS_WARN_NAMED("value_measurement", "profiling measurement types do not match");
+    }
+  }
+
+  static Formatter getFormatter(const std::string& unit)
+  {
+    return SimpleFormatter<T>(unit, 8, std::is_integral<T>::value ? 0 : 1);
+  }
+
+  /// Statistics of a value measurement, which differ from plain statistics only in their snapshot type.
+  class ValueStatistics : public Statistics<T>
+  {
+  public:
+    explicit ValueStatistics(Formatter formatter)
+      : Statistics<T>(std::move(formatter))
+    {
+    }
+
+    bool takeSnapshot(ProfileSnapshot& snapshot) const override
+    {
+      Statistics<T>::takeSnapshot(snapshot);
+      snapshot.type = "value";
+      return true;
+    }
+  };
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_VALUE_MEASUREMENT_H
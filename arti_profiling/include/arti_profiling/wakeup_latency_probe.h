@@ -0,0 +1,72 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_WAKEUP_LATENCY_PROBE_H
+#define ARTI_PROFILING_WAKEUP_LATENCY_PROBE_H
+
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/real_time.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace arti_profiling
+{
+
+/// A thread that repeatedly sleeps until an absolute time and records how late it wakes up, like cyclictest does. This
+/// measures the scheduling latency of the OS (and the machine's load) that all periodic work suffers from, separately
+/// from the work's own duration. Running it with a real-time priority shows what real-time threads can expect.
+class WakeupLatencyProbe
+{
+public:
+  using Clock = RealTimeDurationProfile::Clock;
+
+  /// Starts the probe thread, which wakes up with the given interval. A priority above zero makes it run with
+  /// SCHED_FIFO and that priority, if permitted; a CPU of zero or above pins it to that CPU.
+  WakeupLatencyProbe(
+    Profiler& profiler, const std::string& name, const Clock::duration& interval = std::chrono::milliseconds(1),
+    int priority = 0, int cpu = -1);
+  ~WakeupLatencyProbe();
+
+  WakeupLatencyProbe(const WakeupLatencyProbe&) = delete;
+  WakeupLatencyProbe& operator=(const WakeupLatencyProbe&) = delete;
+
+protected:
+  void run();
+
+  std::shared_ptr<RealTimeDurationProfile> profile_;
+  Clock::duration interval_;
+  int priority_;
+  int cpu_;
+  std::atomic<bool> stopped_{false};
+  std::thread thread_;
+};
+
+}  // namespace arti_profiling
+
+#endif  // ARTI_PROFILING_WAKEUP_LATENCY_PROBE_H
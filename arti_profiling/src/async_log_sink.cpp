@@ -0,0 +1,267 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/async_log_sink.h>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <ros/console.h>
+#include <unistd.h>
+#include <utility>
+
+namespace arti_profiling
+{
+
+const std::size_t AsyncLogSink::DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+namespace
+{
+
+std::string getDefaultDirectory()
+{
+  const char* ros_log_dir = std::getenv("ROS_LOG_DIR");
+  const char* ros_home = std::getenv("ROS_HOME");
+  const char* home = std::getenv("HOME");
+  if (ros_log_dir != nullptr)
+  {
+    return ros_log_dir;
+  }
+  if (ros_home != nullptr)
+  {
+    return std::string(ros_home) + "/log";
+  }
+  if (home != nullptr)
+  {
+    return std::string(home) + "/.ros/log";
+  }
+  return "/tmp";
+}
+
+}  // namespace
+
+AsyncLogSink::AsyncLogSink(std::ostream& out, const std::size_t buffer_size)
+  : AsyncLogSink(&out, FileOptions(), buffer_size)
+{
+}
+
+AsyncLogSink::AsyncLogSink(FileOptions options, const std::size_t buffer_size)
+  : AsyncLogSink(nullptr, std::move(options), buffer_size)
+{
+}
+
+AsyncLogSink::AsyncLogSink(std::ostream* out, FileOptions options, const std::size_t buffer_size)
+  : buffer_size_(buffer_size), out_(out), options_(std::move(options))
+{
+  if (out_ == nullptr && options_.directory.empty())
+  {
+    options_.directory = getDefaultDirectory();
+  }
+  front_buffer_.reserve(buffer_size_);
+  back_buffer_.reserve(buffer_size_);
+  thread_ = std::thread(&AsyncLogSink::run, this);
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  thread_.join();
+}
+
+bool AsyncLogSink::write(const std::string& record)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (front_buffer_.size() + record.size() > buffer_size_)
+    {
+      ++dropped_count_;
+      return false;
+    }
+    front_buffer_.append(record);
+  }
+  condition_.notify_all();
+  return true;
+}
+
+void AsyncLogSink::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this]() { return front_buffer_.empty() && !writing_; });
+}
+
+std::uint64_t AsyncLogSink::getDroppedCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return dropped_count_;
+}
+
+std::string AsyncLogSink::getFileName() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_name_;
+}
+
+void AsyncLogSink::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true)
+  {
+    condition_.wait(lock, [this]() { return stopping_ || !front_buffer_.empty(); });
+    if (front_buffer_.empty())
+    {
+      break;  // Stopping, and everything is written out
+    }
+
+    // Swapping keeps the capacities, so neither buffer is ever reallocated:
+    front_buffer_.swap(back_buffer_);
+    writing_ = true;
+    lock.unlock();
+
+    writeOut(back_buffer_);
+    back_buffer_.clear();
+
+    lock.lock();
+    writing_ = false;
+    condition_.notify_all();
+  }
+}
+
+void AsyncLogSink::writeOut(const std::string& data)
+{
+  if (out_ != nullptr)
+  {
+    out_->write(data.data(), static_cast<std::streamsize>(data.size()));
+    out_->flush();
+    return;
+  }
+
+  if (!file_.is_open() || isRotationDue())
+  {
+    rotate();
+  }
+  if (file_.is_open())
+  {
+    file_.write(data.data(), static_cast<std::streamsize>(data.size()));
+    file_.flush();
+    file_size_ += data.size();
+  }
+}
+
+bool AsyncLogSink::isRotationDue() const
+{
+  return (options_.max_file_size != 0 && file_size_ >= options_.max_file_size)
+    || (options_.max_file_age != std::chrono::seconds::zero()
+        && std::chrono::steady_clock::now() - file_open_time_ >= options_.max_file_age);
+}
+
+void AsyncLogSink::rotate()
+{
+  if (file_.is_open())
+  {
+    file_.close();
+    // If compressing fails, the uncompressed file is kept and removed as usual:
+    if (options_.compress && compress(file_names_.back()))
+    {
+      file_names_.back() += ".gz";
+    }
+  }
+
+  std::string file_name = options_.directory + "/" + options_.base_name + "_" + std::to_string(::getpid()) + "_"
+    + std::to_string(file_index_++) + options_.extension;
+  file_.clear();
+  file_.open(file_name, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!file_.is_open())
+  {
+    // Report once instead of at every rotation attempt, which happens for every write until a file can be opened:
+    if (!open_failed_)
+    {
+      ROS_ERROR_NAMED("async_log_sink", "failed to open profiling log file %s", file_name.c_str());
+      open_failed_ = true;
+    }
+    file_name.clear();
+  }
+  else
+  {
+    open_failed_ = false;
+    file_size_ = 0;
+    file_open_time_ = std::chrono::steady_clock::now();
+    file_names_.push_back(file_name);
+    while (options_.max_file_count != 0 && file_names_.size() > options_.max_file_count)
+    {
+      std::remove(file_names_.front().c_str());
+      file_names_.pop_front();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_name_ = std::move(file_name);
+}
+
+bool AsyncLogSink::compress(const std::string& file_name)
+{
+  const std::string compressed_file_name = file_name + ".gz";
+  std::ifstream in(file_name, std::ios::in | std::ios::binary);
+  std::ofstream out(compressed_file_name, std::ios::out | std::ios::trunc | std::ios::binary);
+  if (!in.is_open() || !out.is_open())
+  {
+    ROS_ERROR_NAMED("async_log_sink", "failed to open profiling log file %s or %s for compressing it",
+                    file_name.c_str(), compressed_file_name.c_str());
+    return false;
+  }
+
+  try
+  {
+    boost::iostreams::filtering_streambuf<boost::iostreams::output> compressor;
+    compressor.push(boost::iostreams::gzip_compressor());
+    compressor.push(out);
+    boost::iostreams::copy(in, compressor);  // Also closes the compressor, which writes the remaining data
+    out.close();
+  }
+  catch (const std::exception& e)
+  {
+    ROS_ERROR_NAMED("async_log_sink", "failed to compress profiling log file %s: %s", file_name.c_str(), e.what());
+    std::remove(compressed_file_name.c_str());
+    return false;
+  }
+
+  // Reading sets the fail bit at the end of the file, so only the bad bit indicates an error there:
+  if (in.bad() || out.fail())
+  {
+    ROS_ERROR_NAMED("async_log_sink", "failed to compress profiling log file %s", file_name.c_str());
+    std::remove(compressed_file_name.c_str());
+    return false;
+  }
+  std::remove(file_name.c_str());
+  return true;
+}
+
+}  // namespace arti_profiling
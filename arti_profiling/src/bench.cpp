@@ -0,0 +1,261 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/bench.h>
+#include <algorithm>
+#include <boost/format.hpp>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <numeric>
+#include <pthread.h>
+#include <random>
+#include <ros/console.h>
+#include <sched.h>
+#include <utility>
+
+namespace arti_profiling
+{
+namespace bench
+{
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+
+/// Pins the calling thread to a CPU for its lifetime, restoring the previous affinity afterwards.
+class CpuPinning
+{
+public:
+  explicit CpuPinning(const int cpu)
+  {
+    if (cpu < 0 || pthread_getaffinity_np(pthread_self(), sizeof(previous_cpus_), &previous_cpus_) != 0)
+    {
+      return;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (result != 0)
+    {
+      ROS_WARN_NAMED("bench", "cannot pin benchmark to CPU %d: %s", cpu, std::strerror(result));
+      return;
+    }
+    pinned_ = true;
+  }
+
+  ~CpuPinning()
+  {
+    if (pinned_)
+    {
+      pthread_setaffinity_np(pthread_self(), sizeof(previous_cpus_), &previous_cpus_);
+    }
+  }
+
+private:
+  cpu_set_t previous_cpus_;
+  bool pinned_{false};
+};
+
+double toNanoseconds(const Clock::duration& duration)
+{
+  return std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(duration).count();
+}
+
+void printNanoseconds(std::ostream& out, const double nanoseconds)
+{
+  if (nanoseconds >= 1e6)
+  {
+    out << boost::format("%.3fms") % (nanoseconds * 1e-6);
+  }
+  else if (nanoseconds >= 1e3)
+  {
+    out << boost::format("%.3fus") % (nanoseconds * 1e-3);
+  }
+  else
+  {
+    out << boost::format("%.1fns") % nanoseconds;
+  }
+}
+
+}  // namespace
+
+ProfileSnapshot Result::toSnapshot() const
+{
+  ProfileSnapshot snapshot;
+  snapshot.type = "duration";
+  snapshot.count = repetitions.size();
+  if (!repetitions.empty())
+  {
+    const auto range = std::minmax_element(repetitions.begin(), repetitions.end());
+    // Stored as floating-point nanoseconds, as iterations of micro-benchmarks often take less than one:
+    snapshot.sum = SnapshotValue::from(std::accumulate(repetitions.begin(), repetitions.end(), 0.0));
+    snapshot.min = SnapshotValue::from(*range.first);
+    snapshot.max = SnapshotValue::from(*range.second);
+  }
+  snapshot.histogram = histogram;
+  snapshot.counters["iterations"] = static_cast<std::int64_t>(iterations);
+  snapshot.counters["ci_lower_ns"] = std::llround(ci_lower);
+  snapshot.counters["ci_upper_ns"] = std::llround(ci_upper);
+  return snapshot;
+}
+
+Runner::Runner(Options options)
+  : options_(std::move(options))
+{
+}
+
+const Result& Runner::run(const std::string& name, const std::function<void()>& function)
+{
+  CpuPinning pinning(options_.cpu);
+
+  Result result;
+  result.name = name;
+  result.iterations = calibrate(function);
+  for (std::size_t repetition = 0; repetition < std::max<std::size_t>(options_.repetitions, 1); ++repetition)
+  {
+    const Clock::time_point start_time = Clock::now();
+    for (std::uint64_t i = 0; i < result.iterations; ++i)
+    {
+      function();
+    }
+    const double duration = toNanoseconds(Clock::now() - start_time) / static_cast<double>(result.iterations);
+    result.repetitions.push_back(duration);
+    result.histogram.add(duration);
+  }
+  computeConfidenceInterval(result);
+
+  results_.push_back(std::move(result));
+  return results_.back();
+}
+
+const std::vector<Result>& Runner::getResults() const
+{
+  return results_;
+}
+
+void Runner::print(std::ostream& out) const
+{
+  for (const Result& result : results_)
+  {
+    out << result.name << std::setw(30 - std::min(30, static_cast<int>(result.name.size())) + 2) << std::left << ": "
+        << std::right;
+    printNanoseconds(out, result.mean);
+    out << " per iteration, " << static_cast<int>(options_.confidence_level * 100.0) << "% CI: [";
+    printNanoseconds(out, result.ci_lower);
+    out << ", ";
+    printNanoseconds(out, result.ci_upper);
+    out << "], " << result.repetitions.size() << " x " << result.iterations << " iterations" << std::endl;
+  }
+}
+
+ProfilerSnapshot Runner::takeSnapshot(const std::string& name) const
+{
+  ProfilerSnapshot snapshot;
+  snapshot.name = name;
+  snapshot.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  for (const Result& result : results_)
+  {
+    snapshot.profiles[result.name] = result.toSnapshot();
+  }
+  return snapshot;
+}
+
+std::uint64_t Runner::calibrate(const std::function<void()>& function) const
+{
+  // Warm up, which also gives a first estimate of the duration of an iteration:
+  std::uint64_t iterations = 0;
+  const Clock::time_point warmup_start_time = Clock::now();
+  Clock::duration elapsed{};
+  do
+  {
+    function();
+    ++iterations;
+    elapsed = Clock::now() - warmup_start_time;
+  }
+  while (elapsed < options_.warmup_time);
+
+  // Grow the iteration count until a batch takes at least the minimum repetition time:
+  double iteration_duration = toNanoseconds(elapsed) / static_cast<double>(iterations);
+  const double min_repetition_time = static_cast<double>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(options_.min_repetition_time).count());
+  while (true)
+  {
+    iterations = static_cast<std::uint64_t>(std::max(1.0, std::ceil(min_repetition_time / iteration_duration)));
+    const Clock::time_point start_time = Clock::now();
+    for (std::uint64_t i = 0; i < iterations; ++i)
+    {
+      function();
+    }
+    const double batch_duration = toNanoseconds(Clock::now() - start_time);
+    if (batch_duration >= min_repetition_time)
+    {
+      return iterations;
+    }
+    // Use the more accurate estimate of this batch, but make sure that the next batch is at least twice as long:
+    iteration_duration = std::max(
+      std::min(batch_duration / static_cast<double>(iterations), iteration_duration * 0.5), 1e-3);
+  }
+}
+
+void Runner::computeConfidenceInterval(Result& result) const
+{
+  const std::vector<double>& values = result.repetitions;
+  result.mean = std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+  result.ci_lower = result.mean;
+  result.ci_upper = result.mean;
+  if (values.size() < 2 || options_.bootstrap_resamples == 0)
+  {
+    return;
+  }
+
+  // Percentile bootstrap, with a fixed seed to make reports reproducible:
+  std::mt19937 random(42);
+  std::uniform_int_distribution<std::size_t> index(0, values.size() - 1);
+  std::vector<double> means(options_.bootstrap_resamples);
+  for (double& mean : means)
+  {
+    double sum = 0.0;
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+      sum += values[index(random)];
+    }
+    mean = sum / static_cast<double>(values.size());
+  }
+  std::sort(means.begin(), means.end());
+
+  const double alpha = (1.0 - std::min(std::max(options_.confidence_level, 0.0), 1.0)) / 2.0;
+  const std::size_t last = means.size() - 1;
+  result.ci_lower = means[static_cast<std::size_t>(std::floor(alpha * last))];
+  result.ci_upper = means[static_cast<std::size_t>(std::ceil((1.0 - alpha) * last))];
+}
+
+}  // namespace bench
+}  // namespace arti_profiling
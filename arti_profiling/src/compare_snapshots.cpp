@@ -0,0 +1,114 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/comparison.h>
+#include <arti_profiling/snapshot.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+/// Parses a number from a command-line argument; returns false unless all of it is a number within [min, max].
+static bool parseNumber(const char* argument, const double min, const double max, double& value)
+{
+  char* end = nullptr;
+  errno = 0;
+  const double result = std::strtod(argument, &end);
+  if (end == argument || *end != '\0' || errno == ERANGE || !(result >= min && result <= max))
+  {
+    return false;
+  }
+  value = result;
+  return true;
+}
+
+// Compares a profiling snapshot to a baseline and exits with status 1 if there are significant regressions.
+int main(int argc, char** argv)
+{
+  arti_profiling::ComparisonOptions options;
+  std::vector<std::string> file_names;
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string argument = argv[i];
+    if (argument == "--alpha" && i + 1 < argc)
+    {
+      // The bounds are excluded, as no p-value would be significant at 0 and every one at 1:
+      if (!parseNumber(argv[++i], std::numeric_limits<double>::min(), std::nextafter(1.0, 0.0), options.alpha))
+      {
+        std::cerr << "error: ALPHA must be a number between 0 and 1 (exclusive), got '" << argv[i] << "'" << std::endl;
+        return 2;
+      }
+    }
+    else if (argument == "--threshold" && i + 1 < argc)
+    {
+      if (!parseNumber(argv[++i], 0.0, std::numeric_limits<double>::max(), options.min_relative_change))
+      {
+        std::cerr << "error: THRESHOLD must be a non-negative number, got '" << argv[i] << "'" << std::endl;
+        return 2;
+      }
+    }
+    else if (argument == "--fail-untestable")
+    {
+      options.fail_untestable = true;
+    }
+    else
+    {
+      file_names.push_back(argument);
+    }
+  }
+
+  if (file_names.size() != 2)
+  {
+    std::cerr << "usage: " << argv[0] << " [--alpha ALPHA] [--threshold THRESHOLD] [--fail-untestable] BASELINE "
+                 "CURRENT" << std::endl
+              << "Compares the CURRENT profiling snapshot to the BASELINE one. Changes are significant if a test's "
+                 "p-value is below ALPHA (default: " << options.alpha << ") and the tested value changed by at "
+                 "least THRESHOLD (default: " << options.min_relative_change << "). Profiles with histograms are "
+                 "tested for changes of the median (Mann-Whitney U test) and the 99th percentile, others for "
+                 "changes of the average (Welch's test with variances bounded by the value ranges). Profiles with "
+                 "less than two values cannot be tested." << std::endl
+              << "Exits with status 1 if there are significant regressions, or with --fail-untestable, profiles "
+                 "that could not be tested." << std::endl;
+    return 2;
+  }
+
+  try
+  {
+    const std::vector<arti_profiling::ProfileComparison> comparisons = arti_profiling::compareSnapshots(
+      arti_profiling::loadSnapshot(file_names[0]), arti_profiling::loadSnapshot(file_names[1]), options);
+    arti_profiling::printComparisons(std::cout, comparisons);
+    return arti_profiling::hasRegressions(comparisons, options) ? 1 : 0;
+  }
+  catch (const std::exception& ex)
+  {
+    std::cerr << "error: " << ex.what() << std::endl;
+    return 2;
+  }
+}
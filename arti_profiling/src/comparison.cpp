@@ -0,0 +1,426 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/comparison.h>
+#include <algorithm>
+#include <boost/format.hpp>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <ostream>
+
+namespace arti_profiling
+{
+
+double mannWhitneyTest(const Histogram& a, const Histogram& b, double* z)
+{
+  if (z != nullptr)
+  {
+    *z = 0.0;
+  }
+
+  const double n_a = a.getCount();
+  const double n_b = b.getCount();
+  const double n = n_a + n_b;
+  if (n_a == 0.0 || n_b == 0.0)
+  {
+    return 1.0;
+  }
+
+  // Collect the counts of both histograms per bucket, in ascending order of the bucket values:
+  std::map<std::int32_t, std::pair<double, double>> buckets;
+  for (const auto& bucket : a.getBuckets())
+  {
+    buckets[bucket.first].first = bucket.second;
+  }
+  for (const auto& bucket : b.getBuckets())
+  {
+    buckets[bucket.first].second = bucket.second;
+  }
+
+  double rank_sum_b = 0.0;
+  double tie_correction = 0.0;
+  double values_below = 0.0;
+  for (const auto& bucket : buckets)
+  {
+    const double ties = bucket.second.first + bucket.second.second;
+    const double mid_rank = values_below + (ties + 1.0) / 2.0;
+    rank_sum_b += bucket.second.second * mid_rank;
+    tie_correction += ties * ties * ties - ties;
+    values_below += ties;
+  }
+
+  const double u_b = rank_sum_b - n_b * (n_b + 1.0) / 2.0;
+  const double mean_u = n_a * n_b / 2.0;
+  const double variance_u = n_a * n_b / 12.0 * ((n + 1.0) - tie_correction / (n * (n - 1.0)));
+  if (variance_u <= 0.0)
+  {
+    return 1.0;  // All values are ties
+  }
+
+  // Use a continuity correction of 0.5:
+  const double deviation = u_b - mean_u;
+  const double z_u = (deviation - std::copysign(std::min(0.5, std::abs(deviation)), deviation)) / std::sqrt(variance_u);
+  if (z != nullptr)
+  {
+    *z = z_u;
+  }
+  return std::erfc(std::abs(z_u) / std::sqrt(2.0));
+}
+
+double tailTest(const Histogram& a, const Histogram& b, const double quantile, double* z)
+{
+  if (z != nullptr)
+  {
+    *z = 0.0;
+  }
+
+  const double n_a = a.getCount();
+  const double n_b = b.getCount();
+  if (n_a == 0.0 || n_b == 0.0)
+  {
+    return 1.0;
+  }
+
+  const std::int32_t threshold = Histogram::getBucketIndex(a.getQuantile(quantile));
+  const auto countAbove = [threshold](const Histogram& histogram)
+  {
+    double count = 0.0;
+    for (auto bucket = histogram.getBuckets().upper_bound(threshold); bucket != histogram.getBuckets().end(); ++bucket)
+    {
+      count += bucket->second;
+    }
+    return count;
+  };
+  const double above_a = countAbove(a);
+  const double above_b = countAbove(b);
+
+  const double pooled = (above_a + above_b) / (n_a + n_b);
+  const double standard_error = std::sqrt(pooled * (1.0 - pooled) * (1.0 / n_a + 1.0 / n_b));
+  if (standard_error <= 0.0)
+  {
+    return 1.0;  // No values above the threshold, or only such values
+  }
+
+  const double z_p = (above_b / n_b - above_a / n_a) / standard_error;
+  if (z != nullptr)
+  {
+    *z = z_p;
+  }
+  return std::erfc(std::abs(z_p) / std::sqrt(2.0));
+}
+
+static double getMaxVariance(const ProfileSnapshot& profile)
+{
+  // Bound of the sample variance by Popoviciu's inequality:
+  const double n = profile.count;
+  const double range = std::max(0.0, profile.max.toDouble() - profile.min.toDouble());
+  return n / (n - 1.0) * range * range / 4.0;
+}
+
+double averageTest(const ProfileSnapshot& a, const ProfileSnapshot& b, double* z)
+{
+  if (z != nullptr)
+  {
+    *z = 0.0;
+  }
+
+  if (a.count < 2 || b.count < 2)
+  {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  const double difference = b.getAverage() - a.getAverage();
+  const double standard_error = std::sqrt(getMaxVariance(a) / a.count + getMaxVariance(b) / b.count);
+  if (standard_error <= 0.0)
+  {
+    // All values of each profile are equal:
+    if (z != nullptr && difference != 0.0)
+    {
+      *z = std::copysign(HUGE_VAL, difference);
+    }
+    return difference == 0.0 ? 1.0 : 0.0;
+  }
+
+  const double z_t = difference / standard_error;
+  if (z != nullptr)
+  {
+    *z = z_t;
+  }
+  return std::erfc(std::abs(z_t) / std::sqrt(2.0));
+}
+
+static ProfileComparison::Values getValues(const ProfileSnapshot& profile)
+{
+  ProfileComparison::Values values;
+  values.count = profile.count;
+  values.average = profile.getAverage();
+  if (profile.histogram.empty())
+  {
+    values.p50 = values.average;
+    values.p99 = values.average;
+  }
+  else
+  {
+    const double min = profile.min.toDouble();
+    const double max = profile.max.toDouble();
+    values.p50 = std::min(std::max(profile.histogram.getQuantile(0.5), min), max);
+    values.p99 = std::min(std::max(profile.histogram.getQuantile(0.99), min), max);
+  }
+  return values;
+}
+
+static double getRelativeChange(const double baseline, const double current)
+{
+  if (baseline == 0.0)
+  {
+    return current == 0.0 ? 0.0 : std::copysign(HUGE_VAL, current);
+  }
+  return (current - baseline) / std::abs(baseline);
+}
+
+static void compareProfiles(
+  const std::string& path, const ProfileSnapshot* baseline, const ProfileSnapshot* current,
+  const ComparisonOptions& options, std::vector<ProfileComparison>& comparisons)
+{
+  ProfileComparison comparison;
+  comparison.path = path;
+  comparison.type = current != nullptr ? current->type : baseline->type;
+  if (baseline == nullptr)
+  {
+    comparison.current = getValues(*current);
+    comparison.verdict = ProfileComparison::Verdict::ADDED;
+  }
+  else if (current == nullptr)
+  {
+    comparison.baseline = getValues(*baseline);
+    comparison.verdict = ProfileComparison::Verdict::MISSING;
+  }
+  else
+  {
+    comparison.baseline = getValues(*baseline);
+    comparison.current = getValues(*current);
+
+    const bool higher_is_better = comparison.type == "frequency";
+    bool regression = false;
+    bool improvement = false;
+    const auto evaluate = [&](const double p_value, const double z, const double change)
+    {
+      // Require the test and the change of the compared value to agree on the direction:
+      if (p_value < options.alpha && std::abs(change) >= options.min_relative_change && (z > 0.0) == (change > 0.0))
+      {
+        ((change > 0.0) != higher_is_better ? regression : improvement) = true;
+      }
+    };
+
+    comparison.histograms = !baseline->histogram.empty() && !current->histogram.empty();
+    if (comparison.histograms)
+    {
+      double z = 0.0;
+      comparison.p_value = mannWhitneyTest(baseline->histogram, current->histogram, &z);
+      evaluate(comparison.p_value, z, getRelativeChange(comparison.baseline.p50, comparison.current.p50));
+      comparison.p99_p_value = tailTest(baseline->histogram, current->histogram, 0.99, &z);
+      evaluate(comparison.p99_p_value, z, getRelativeChange(comparison.baseline.p99, comparison.current.p99));
+    }
+    else
+    {
+      double z = 0.0;
+      comparison.p_value = averageTest(*baseline, *current, &z);
+      evaluate(comparison.p_value, z, getRelativeChange(comparison.baseline.average, comparison.current.average));
+    }
+
+    if (std::isnan(comparison.p_value))
+    {
+      comparison.p_value = 1.0;
+      comparison.verdict = ProfileComparison::Verdict::NOT_TESTABLE;
+    }
+    else if (regression)
+    {
+      comparison.verdict = ProfileComparison::Verdict::REGRESSION;
+    }
+    else if (improvement)
+    {
+      comparison.verdict = ProfileComparison::Verdict::IMPROVEMENT;
+    }
+  }
+  comparisons.push_back(comparison);
+
+  // Compare labeled statistics as well:
+  static const ProfileSnapshot EMPTY;
+  std::map<std::string, std::pair<const ProfileSnapshot*, const ProfileSnapshot*>> labels;
+  for (const auto& label : (baseline != nullptr ? baseline : &EMPTY)->labels)
+  {
+    labels[label.first].first = &label.second;
+  }
+  for (const auto& label : (current != nullptr ? current : &EMPTY)->labels)
+  {
+    labels[label.first].second = &label.second;
+  }
+  for (const auto& label : labels)
+  {
+    compareProfiles(path + "{" + label.first + "}", label.second.first, label.second.second, options, comparisons);
+  }
+}
+
+static void compareProfilers(
+  const std::string& path, const ProfilerSnapshot* baseline, const ProfilerSnapshot* current,
+  const ComparisonOptions& options, std::vector<ProfileComparison>& comparisons)
+{
+  static const ProfilerSnapshot EMPTY;
+  const ProfilerSnapshot& existing_baseline = baseline != nullptr ? *baseline : EMPTY;
+  const ProfilerSnapshot& existing_current = current != nullptr ? *current : EMPTY;
+
+  std::map<std::string, std::pair<const ProfileSnapshot*, const ProfileSnapshot*>> profiles;
+  for (const auto& profile : existing_baseline.profiles)
+  {
+    profiles[profile.first].first = &profile.second;
+  }
+  for (const auto& profile : existing_current.profiles)
+  {
+    profiles[profile.first].second = &profile.second;
+  }
+  for (const auto& profile : profiles)
+  {
+    compareProfiles(path + profile.first, profile.second.first, profile.second.second, options, comparisons);
+  }
+
+  for (const ProfilerSnapshot& child : existing_baseline.children)
+  {
+    compareProfilers(path + child.name + "/", &child, existing_current.findChild(child.name), options, comparisons);
+  }
+  for (const ProfilerSnapshot& child : existing_current.children)
+  {
+    if (existing_baseline.findChild(child.name) == nullptr)
+    {
+      compareProfilers(path + child.name + "/", nullptr, &child, options, comparisons);
+    }
+  }
+}
+
+std::vector<ProfileComparison> compareSnapshots(
+  const ProfilerSnapshot& baseline, const ProfilerSnapshot& current, const ComparisonOptions& options)
+{
+  std::vector<ProfileComparison> comparisons;
+  compareProfilers(std::string(), &baseline, &current, options, comparisons);
+  return comparisons;
+}
+
+bool hasRegressions(const std::vector<ProfileComparison>& comparisons, const ComparisonOptions& options)
+{
+  return std::any_of(comparisons.begin(), comparisons.end(), [&options](const ProfileComparison& comparison)
+  {
+    return comparison.verdict == ProfileComparison::Verdict::REGRESSION
+      || (options.fail_untestable && comparison.verdict == ProfileComparison::Verdict::NOT_TESTABLE);
+  });
+}
+
+static std::string formatValue(const std::string& type, const double value)
+{
+  if (isDurationType(type))
+  {
+    const double abs_value = std::abs(value);
+    if (abs_value >= 1e9)
+    {
+      return (boost::format("%.3fs") % (value * 1e-9)).str();
+    }
+    if (abs_value >= 1e6)
+    {
+      return (boost::format("%.3fms") % (value * 1e-6)).str();
+    }
+    if (abs_value >= 1e3)
+    {
+      return (boost::format("%.3fus") % (value * 1e-3)).str();
+    }
+    return (boost::format("%.0fns") % value).str();
+  }
+  return (boost::format("%.4g") % value).str();
+}
+
+static std::string formatChange(
+  const std::string& type, const double baseline, const double current)
+{
+  return (boost::format("%s -> %s (%+.1f%%)") % formatValue(type, baseline) % formatValue(type, current)
+          % (100.0 * getRelativeChange(baseline, current))).str();
+}
+
+void printComparisons(std::ostream& out, const std::vector<ProfileComparison>& comparisons)
+{
+  for (const ProfileComparison& comparison : comparisons)
+  {
+    out << boost::format("%-12s %s") % toString(comparison.verdict) % comparison.path;
+    switch (comparison.verdict)
+    {
+      case ProfileComparison::Verdict::ADDED:
+        out << ": performed " << comparison.current.count << "x, avg: "
+            << formatValue(comparison.type, comparison.current.average);
+        break;
+      case ProfileComparison::Verdict::MISSING:
+        out << ": performed " << comparison.baseline.count << "x, avg: "
+            << formatValue(comparison.type, comparison.baseline.average);
+        break;
+      default:
+        out << ": performed " << comparison.baseline.count << "x -> " << comparison.current.count << "x, avg: "
+            << formatChange(comparison.type, comparison.baseline.average, comparison.current.average);
+        if (comparison.verdict == ProfileComparison::Verdict::NOT_TESTABLE)
+        {
+          break;
+        }
+        if (comparison.histograms)
+        {
+          out << ", p50: " << formatChange(comparison.type, comparison.baseline.p50, comparison.current.p50)
+              << ", p99: " << formatChange(comparison.type, comparison.baseline.p99, comparison.current.p99)
+              << boost::format(", p-values: %.3g, %.3g") % comparison.p_value % comparison.p99_p_value;
+        }
+        else
+        {
+          out << boost::format(", p-value: %.3g") % comparison.p_value;
+        }
+    }
+    out << std::endl;
+  }
+}
+
+const char* toString(const ProfileComparison::Verdict verdict)
+{
+  switch (verdict)
+  {
+    case ProfileComparison::Verdict::UNCHANGED:
+      return "unchanged";
+    case ProfileComparison::Verdict::IMPROVEMENT:
+      return "IMPROVEMENT";
+    case ProfileComparison::Verdict::REGRESSION:
+      return "REGRESSION";
+    case ProfileComparison::Verdict::NOT_TESTABLE:
+      return "untestable";
+    case ProfileComparison::Verdict::MISSING:
+      return "missing";
+    case ProfileComparison::Verdict::ADDED:
+      return "added";
+  }
+  return "unknown";
+}
+
+}  // namespace arti_profiling
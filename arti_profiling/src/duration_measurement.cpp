@@ -25,15 +25,29 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/flight_recorder.h>
+#include <arti_profiling/overhead.h>
 #include <arti_profiling/profile.h>
+#include <arti_profiling/sampling_profiler.h>
+#include "probes.h"
+#include <algorithm>
+#include <boost/format.hpp>
+#include <ratio>
 #include <ros/console.h>
+#include <type_traits>
 #include <utility>
 
 namespace arti_profiling
 {
 
+// Snapshots and everything reading them interpret durations as nanoseconds:
+static_assert(std::is_same<DurationMeasurement::Clock::period, std::nano>::value,
+              "DurationMeasurement::Clock must count nanoseconds");
+
 const DurationMeasurement::Clock::time_point DurationMeasurement::NEVER;
 
+const DurationMeasurement::Clock::duration DurationMeasurement::NO_BUDGET = DurationMeasurement::Clock::duration::max();
+
 const DurationMeasurement::Formatter DurationMeasurement::DEFAULT_FORMATTER(
   SimpleDurationFormatter<std::chrono::milliseconds>(5));
 
@@ -47,6 +61,28 @@ DurationMeasurement::DurationMeasurement(
   Profiler& profiler, std::string name, Formatter formatter, const Clock::time_point& start_time)
   : profiler_(&profiler), name_(std::move(name)), formatter_(std::move(formatter)), start_time_(start_time)
 {
+  start(start_time);
+}
+
+DurationMeasurement::DurationMeasurement(
+  Profiler& profiler, std::string name, LabelSet labels, const Clock::time_point& start_time)
+  : DurationMeasurement(profiler, std::move(name), std::move(labels), DEFAULT_FORMATTER, start_time)
+{
+}
+
+DurationMeasurement::DurationMeasurement(
+  Profiler& profiler, std::string name, LabelSet labels, Formatter formatter, const Clock::time_point& start_time)
+  : profiler_(&profiler), name_(std::move(name)), labels_(std::move(labels)), formatter_(std::move(formatter)),
+    start_time_(start_time)
+{
+  start(start_time);
+}
+
+DurationMeasurement::DurationMeasurement(
+  DurationStatistics& statistics, std::string name, const Clock::time_point& start_time)
+  : statistics_(&statistics), name_(std::move(name)), start_time_(start_time)
+{
+  start(start_time);
 }
 
 DurationMeasurement::~DurationMeasurement()
@@ -57,34 +93,245 @@ DurationMeasurement::~DurationMeasurement()
 void DurationMeasurement::start(const Clock::time_point& start_time)
 {
   start_time_ = start_time;
+  if (start_time_ == NEVER || isCalibratingOverhead())
+  {
+    return;
+  }
+  ARTI_PROFILING_PROBE1(duration_start, name_.c_str());
+  if (sampled_scope_ == 0)
+  {
+    sampled_scope_ = SamplingProfiler::enterScope(name_);
+  }
 }
 
 void DurationMeasurement::stop(const Clock::time_point& stop_time)
 {
+  if (sampled_scope_ != 0)
+  {
+    SamplingProfiler::leaveScope(sampled_scope_);
+    sampled_scope_ = 0;
+  }
   if (start_time_ != NEVER)
   {
-    commit(stop_time - start_time_);
+    Clock::duration measurement = stop_time - start_time_;
+    if (isOverheadCompensationEnabled())
+    {
+      const Clock::duration clock_read = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::nano>(getOverheadCalibration().clock_read));
+      measurement = std::max(measurement - clock_read, Clock::duration::zero());
+    }
+    if (!isCalibratingOverhead())
+    {
+      ARTI_PROFILING_PROBE2(
+        duration_stop, name_.c_str(), std::chrono::duration_cast<std::chrono::nanoseconds>(measurement).count());
+      FlightRecorder::recordDuration(name_, start_time_, measurement);
+    }
+    commit(measurement);
     start_time_ = NEVER;  // Invalidate measurement
   }
 }
 
+void DurationMeasurement::setBudget(const Clock::duration& budget, OverrunCallback overrun_callback)
+{
+  budget_ = budget;
+  overrun_callback_ = std::move(overrun_callback);
+}
+
+void DurationMeasurement::setTopSampleCount(const std::size_t count)
+{
+  top_sample_count_ = count;
+}
+
+void DurationMeasurement::setTag(std::string tag)
+{
+  tag_ = std::move(tag);
+}
+
+void DurationMeasurement::setHistogramEnabled(const bool enabled)
+{
+  histogram_enabled_ = enabled;
+}
+
 void DurationMeasurement::commit(const Clock::duration& measurement)
 {
-  Profiler::ProfileUpdate profile_update = profiler_->getProfile(name_);
-  if (!profile_update.profile)
+  const bool overrun = measurement > budget_;
+
+  if (statistics_ != nullptr)
   {
-    profile_update.profile = std::make_shared<Statistics<Clock::duration::rep>>(formatter_);
+    accumulate(*statistics_, measurement, overrun);
   }
-
-  using DurationMA = MeasurementAccumulator<Clock::duration::rep>;
-  std::shared_ptr<DurationMA> ma = std::dynamic_pointer_cast<DurationMA>(profile_update.profile);
-  if (ma)
+  else if (labels_.empty())
   {
-    ma->accumulate(measurement.count());
+    Profiler::ProfileUpdate profile_update = profiler_->getProfile(name_);
+    if (!profile_update.profile)
+    {
+      profile_update.profile = std::make_shared<DurationStatistics>(formatter_);
+    }
+
+    std::shared_ptr<DurationStatistics> ds = std::dynamic_pointer_cast<DurationStatistics>(profile_update.profile);
+    if (ds)
+    {
+      accumulate(*ds, measurement, overrun);
+    }
+    else
+    {
+      using DurationMA = MeasurementAccumulator<Clock::duration::rep>;
+      std::shared_ptr<DurationMA> ma = std::dynamic_pointer_cast<DurationMA>(profile_update.profile);
+      if (ma)
+      {
+        ma->accumulate(measurement.count());
+      }
+      else
+      {
+        ROS_WARN_NAMED("duration_measurement", "profiling measurement types do not match");
+      }
+    }
   }
   else
   {
-    ROS_WARN_NAMED("duration_measurement", "profiling measurement types do not match");
+    Profiler::ProfileUpdate profile_update = profiler_->getProfile(name_);
+    if (!profile_update.profile)
+    {
+      profile_update.profile
+        = std::make_shared<LabeledDurationStatistics>(formatter_, profiler_->getLabelCardinalityLimit());
+    }
+
+    std::shared_ptr<LabeledDurationStatistics> lds
+      = std::dynamic_pointer_cast<LabeledDurationStatistics>(profile_update.profile);
+    if (lds)
+    {
+      accumulate(*lds->getTotal(), measurement, overrun);
+      accumulate(*lds->getStatistics(labels_), measurement, overrun);
+    }
+    else
+    {
+      ROS_WARN_NAMED("duration_measurement", "profiling measurement types do not match");
+    }
+  }
+
+  // Call the callback without holding the profiler's lock, as it might take a while or measure something itself:
+  if (overrun)
+  {
+    ARTI_PROFILING_PROBE3(
+      duration_overrun, name_.c_str(), std::chrono::duration_cast<std::chrono::nanoseconds>(measurement).count(),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(budget_).count());
+    FlightRecorder::recordOverrun(name_);
+    if (overrun_callback_)
+    {
+      overrun_callback_(name_, measurement, budget_);
+    }
+  }
+}
+
+void DurationMeasurement::accumulate(
+  DurationStatistics& statistics, const Clock::duration& measurement, const bool overrun) const
+{
+  if (top_sample_count_ > statistics.getTopSampleCount())
+  {
+    statistics.setTopSampleCount(top_sample_count_);
+  }
+  if (histogram_enabled_ && !statistics.isHistogramEnabled())
+  {
+    statistics.setHistogramEnabled(true);
+  }
+  statistics.accumulate(measurement.count(), tag_);
+  if (overrun)
+  {
+    statistics.accumulateOverrun(measurement, budget_);
+  }
+}
+
+DurationStatistics::DurationStatistics(Formatter formatter)
+  : Statistics(std::move(formatter))
+{
+}
+
+void DurationStatistics::accumulateOverrun(
+  const DurationMeasurement::Clock::duration& measurement, const DurationMeasurement::Clock::duration& budget,
+  const WallClock::time_point& time)
+{
+  Lock lock(mutex_);
+
+  ++overrun_count_;
+  last_overrun_budget_ = budget;
+  last_overrun_ = measurement;
+  last_overrun_time_ = time;
+}
+
+std::size_t DurationStatistics::getOverrunCount() const
+{
+  Lock lock(mutex_);
+  return overrun_count_;
+}
+
+void DurationStatistics::merge(const DurationStatistics& other)
+{
+  Statistics::merge(other);
+
+  if (&other == this)
+  {
+    return;
+  }
+
+  Lock lock(mutex_, std::defer_lock);
+  Lock other_lock(other.mutex_, std::defer_lock);
+  std::lock(lock, other_lock);
+
+  overrun_count_ += other.overrun_count_;
+  if (other.last_overrun_time_ > last_overrun_time_)
+  {
+    last_overrun_budget_ = other.last_overrun_budget_;
+    last_overrun_ = other.last_overrun_;
+    last_overrun_time_ = other.last_overrun_time_;
+  }
+}
+
+bool DurationStatistics::merge(const Profile& other)
+{
+  const DurationStatistics* statistics = dynamic_cast<const DurationStatistics*>(&other);
+  if (statistics == nullptr)
+  {
+    return Statistics::merge(other);
+  }
+  merge(*statistics);
+  return true;
+}
+
+void DurationStatistics::clear()
+{
+  Lock lock(mutex_);
+
+  Statistics::clear();
+  overrun_count_ = 0;
+  last_overrun_budget_ = {};
+  last_overrun_ = {};
+  last_overrun_time_ = {};
+}
+
+bool DurationStatistics::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+
+  Statistics::takeSnapshot(snapshot);
+  snapshot.type = "duration";
+  snapshot.overrun_count = overrun_count_;
+  snapshot.last_overrun = std::chrono::duration_cast<std::chrono::nanoseconds>(last_overrun_).count();
+  snapshot.last_overrun_budget = std::chrono::duration_cast<std::chrono::nanoseconds>(last_overrun_budget_).count();
+  snapshot.last_overrun_time
+    = std::chrono::duration_cast<std::chrono::nanoseconds>(last_overrun_time_.time_since_epoch()).count();
+  return true;
+}
+
+void DurationStatistics::printAdditionalValues(std::ostream& out) const
+{
+  if (overrun_count_ > 0)
+  {
+    out << ", overruns: " << overrun_count_ << " (budget: ";
+    formatter_(out, last_overrun_budget_.count());
+    out << ", last: ";
+    formatter_(out, last_overrun_.count());
+    out << boost::format(" at %.3f)")
+           % std::chrono::duration_cast<std::chrono::duration<double>>(last_overrun_time_.time_since_epoch()).count();
   }
 }
 
@@ -0,0 +1,683 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/flight_recorder.h>
+#include <arti_profiling/real_time.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ros/console.h>
+#include <semaphore.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+
+namespace arti_profiling
+{
+
+const std::size_t FlightRecorder::DEFAULT_CAPACITY = 1024;
+const std::size_t FlightRecorder::MAX_NAME_LENGTH = 32;
+
+namespace
+{
+
+enum class EventType : std::uint32_t
+{
+  DURATION, COUNTER, MARKER, OVERRUN
+};
+
+const std::size_t NAME_WORDS = FlightRecorder::MAX_NAME_LENGTH / sizeof(std::uint64_t);
+
+/// A recorded event. All members are atomic, as dumps read them while the owning thread may overwrite them; the
+/// sequence is odd while the slot is written, and identifies the event otherwise.
+struct Slot
+{
+  std::atomic<std::uint64_t> sequence{0};
+  std::atomic<std::int64_t> time{0};  ///< Nanoseconds of the steady clock
+  std::atomic<std::uint64_t> value{0};  ///< Duration in nanoseconds, or counter value as bits of a double
+  std::atomic<std::uint32_t> type{0};
+  std::atomic<std::uint32_t> thread_id{0};  ///< Stored per event, as rings outlive their threads
+  std::atomic<std::uint64_t> name[NAME_WORDS];
+};
+
+/// The events of a thread. Rings are never freed, but reused by new threads after their thread exited, so that dumps
+/// (even from signal handlers) can walk them without locking.
+struct Ring
+{
+  explicit Ring(const std::size_t _capacity)
+    : capacity(_capacity), slots(new Slot[_capacity])
+  {
+  }
+
+  const std::size_t capacity;
+  std::unique_ptr<Slot[]> slots;
+  std::atomic<std::uint64_t> write_index{0};
+  std::atomic<bool> in_use{true};
+  std::uint32_t thread_id{0};  ///< Of the thread currently using the ring
+  Ring* next{nullptr};
+};
+
+std::atomic<bool> recording_enabled{true};
+std::atomic<std::size_t> ring_capacity{FlightRecorder::DEFAULT_CAPACITY};
+std::atomic<Ring*> rings{nullptr};
+
+/// Set when the thread's ring has been released, so that events recorded by destructors of other thread-local
+/// objects afterwards neither write to a ring that another thread may reuse nor allocate a new one. Trivially
+/// destructible, so it can still be read then.
+thread_local bool thread_ring_released = false;
+
+/// Releases the thread's ring for reuse when the thread exits.
+struct ThreadRing
+{
+  ~ThreadRing()
+  {
+    thread_ring_released = true;
+    if (ring != nullptr)
+    {
+      ring->in_use.store(false, std::memory_order_release);
+      ring = nullptr;
+    }
+  }
+
+  Ring* ring{nullptr};
+};
+
+thread_local ThreadRing thread_ring;
+
+std::mutex dump_mutex;  ///< Serializes dumps outside of signal handlers, and guards the members below
+char dump_prefix[PATH_MAX] = {0};  ///< Path of the dumped files without the suffix
+std::atomic<bool> dump_prefix_set{false};
+std::atomic<std::uint32_t> dump_count{0};
+
+std::atomic<bool> dump_on_overrun{false};
+std::atomic<FlightRecorder::Clock::rep> dump_on_overrun_interval{0};
+std::atomic<FlightRecorder::Clock::rep> last_overrun_dump{0};
+
+sem_t dump_semaphore;
+std::atomic<const char*> requested_dump_reason{nullptr};
+std::once_flag dump_thread_started;
+std::atomic<bool> dump_thread_running{false};
+
+const int CRASH_SIGNALS[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+const char* const CRASH_SIGNAL_NAMES[] = {"SIGSEGV", "SIGBUS", "SIGFPE", "SIGILL", "SIGABRT"};
+const std::size_t CRASH_SIGNAL_COUNT = sizeof(CRASH_SIGNALS) / sizeof(CRASH_SIGNALS[0]);
+struct sigaction previous_crash_actions[CRASH_SIGNAL_COUNT];
+
+/// Returns the calling thread's ring, or null if the thread is exiting.
+Ring* getThreadRing()
+{
+  if (thread_ring_released)
+  {
+    return nullptr;
+  }
+  if (thread_ring.ring != nullptr)
+  {
+    return thread_ring.ring;
+  }
+
+  checkRealTimeViolation("FlightRecorder::registerThread");
+  const std::size_t capacity = ring_capacity.load(std::memory_order_relaxed);
+  Ring* ring = rings.load(std::memory_order_acquire);
+  for (; ring != nullptr; ring = ring->next)
+  {
+    bool in_use = false;
+    if (ring->capacity == capacity && ring->in_use.compare_exchange_strong(in_use, true))
+    {
+      break;
+    }
+  }
+  if (ring == nullptr)
+  {
+    ring = new Ring(capacity);
+    ring->next = rings.load(std::memory_order_relaxed);
+    while (!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+  }
+  ring->thread_id = static_cast<std::uint32_t>(syscall(SYS_gettid));
+  thread_ring.ring = ring;
+  return ring;
+}
+
+void record(
+  const EventType type, const std::string& name, const FlightRecorder::Clock::time_point& time,
+  const std::uint64_t value) noexcept
+{
+  if (!recording_enabled.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+
+  Ring* ring;
+  try
+  {
+    ring = getThreadRing();
+  }
+  catch (const std::bad_alloc&)
+  {
+    return;
+  }
+  if (ring == nullptr)
+  {
+    return;
+  }
+
+  const std::uint64_t index = ring->write_index.load(std::memory_order_relaxed);
+  Slot& slot = ring->slots[index % ring->capacity];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.time.store(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count(), std::memory_order_relaxed);
+  slot.value.store(value, std::memory_order_relaxed);
+  slot.type.store(static_cast<std::uint32_t>(type), std::memory_order_relaxed);
+  slot.thread_id.store(ring->thread_id, std::memory_order_relaxed);
+  for (std::size_t i = 0; i < NAME_WORDS; ++i)
+  {
+    std::uint64_t word = 0;
+    if (i * sizeof(word) < name.size())
+    {
+      std::memcpy(&word, name.data() + i * sizeof(word), std::min(sizeof(word), name.size() - i * sizeof(word)));
+    }
+    slot.name[i].store(word, std::memory_order_relaxed);
+  }
+
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+  ring->write_index.store(index + 1, std::memory_order_release);
+}
+
+/// Writes JSON to a file descriptor through a fixed buffer, using async-signal-safe functions only.
+class TraceWriter
+{
+public:
+  explicit TraceWriter(const int fd)
+    : fd_(fd)
+  {
+  }
+
+  ~TraceWriter()
+  {
+    flush();
+  }
+
+  void write(const char* text)
+  {
+    write(text, std::strlen(text));
+  }
+
+  void write(const char* text, const std::size_t length)
+  {
+    for (std::size_t i = 0; i < length; ++i)
+    {
+      if (size_ == sizeof(buffer_))
+      {
+        flush();
+      }
+      buffer_[size_++] = text[i];
+    }
+  }
+
+  void writeInteger(std::uint64_t value)
+  {
+    char digits[20];
+    std::size_t count = 0;
+    do
+    {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    }
+    while (value > 0);
+    while (count > 0)
+    {
+      write(&digits[--count], 1);
+    }
+  }
+
+  void writeInteger(const std::int64_t value)
+  {
+    if (value < 0)
+    {
+      write("-", 1);
+      writeInteger(static_cast<std::uint64_t>(-(value + 1)) + 1);
+    }
+    else
+    {
+      writeInteger(static_cast<std::uint64_t>(value));
+    }
+  }
+
+  /// Writes nanoseconds as microseconds with three decimals, the unit of trace event times.
+  void writeMicroseconds(const std::int64_t nanoseconds)
+  {
+    const std::uint64_t value = nanoseconds < 0 ? 0 : static_cast<std::uint64_t>(nanoseconds);
+    writeInteger(value / 1000);
+    const char decimals[] = {'.', static_cast<char>('0' + value / 100 % 10), static_cast<char>('0' + value / 10 % 10),
+                             static_cast<char>('0' + value % 10)};
+    write(decimals, sizeof(decimals));
+  }
+
+  /// Writes a double with six decimals; enough for counter values, and snprintf isn't async-signal-safe.
+  void writeDouble(const double value)
+  {
+    if (!(value == value) || value > 9.2e12 || value < -9.2e12)
+    {
+      write("0");
+      return;
+    }
+    const std::int64_t micros = static_cast<std::int64_t>(value * 1e6 + (value < 0 ? -0.5 : 0.5));
+    const std::uint64_t magnitude = static_cast<std::uint64_t>(micros < 0 ? -micros : micros);
+    if (micros < 0)
+    {
+      write("-", 1);
+    }
+    writeInteger(magnitude / 1000000);
+    char decimals[7] = {'.'};
+    std::uint64_t fraction = magnitude % 1000000;
+    for (std::size_t i = 6; i > 0; --i)
+    {
+      decimals[i] = static_cast<char>('0' + fraction % 10);
+      fraction /= 10;
+    }
+    write(decimals, sizeof(decimals));
+  }
+
+  void writeString(const char* text, const std::size_t max_length)
+  {
+    write("\"", 1);
+    for (std::size_t i = 0; i < max_length && text[i] != '\0'; ++i)
+    {
+      if (text[i] == '"' || text[i] == '\\')
+      {
+        write("\\", 1);
+        write(&text[i], 1);
+      }
+      else if (static_cast<unsigned char>(text[i]) < 0x20)
+      {
+        write(" ", 1);
+      }
+      else
+      {
+        write(&text[i], 1);
+      }
+    }
+    write("\"", 1);
+  }
+
+  void flush()
+  {
+    std::size_t written = 0;
+    while (written < size_)
+    {
+      const ssize_t result = ::write(fd_, buffer_ + written, size_ - written);
+      if (result < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (result <= 0)
+      {
+        break;
+      }
+      written += static_cast<std::size_t>(result);
+    }
+    size_ = 0;
+  }
+
+protected:
+  int fd_;
+  char buffer_[4096];
+  std::size_t size_{0};
+};
+
+void writeTrace(const int fd, const char* reason)
+{
+  TraceWriter writer(fd);
+  const std::int64_t pid = getpid();
+  bool first = true;
+
+  writer.write("{\"traceEvents\":[\n");
+  for (Ring* ring = rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+  {
+    const std::uint64_t end = ring->write_index.load(std::memory_order_acquire);
+    for (std::uint64_t index = end > ring->capacity ? end - ring->capacity : 0; index < end; ++index)
+    {
+      const Slot& slot = ring->slots[index % ring->capacity];
+      const std::uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence != 2 * index + 2)
+      {
+        continue;
+      }
+      const std::int64_t time = slot.time.load(std::memory_order_relaxed);
+      const std::uint64_t value = slot.value.load(std::memory_order_relaxed);
+      const EventType type = static_cast<EventType>(slot.type.load(std::memory_order_relaxed));
+      const std::uint64_t thread_id = slot.thread_id.load(std::memory_order_relaxed);
+      char name[FlightRecorder::MAX_NAME_LENGTH];
+      for (std::size_t i = 0; i < NAME_WORDS; ++i)
+      {
+        const std::uint64_t word = slot.name[i].load(std::memory_order_relaxed);
+        std::memcpy(name + i * sizeof(word), &word, sizeof(word));
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.sequence.load(std::memory_order_relaxed) != sequence)
+      {
+        continue;  // Overwritten while reading
+      }
+
+      writer.write(first ? "{\"name\":" : ",\n{\"name\":");
+      first = false;
+      writer.writeString(name, sizeof(name));
+      switch (type)
+      {
+        case EventType::DURATION:
+          writer.write(",\"ph\":\"X\",\"dur\":");
+          writer.writeMicroseconds(static_cast<std::int64_t>(value));
+          break;
+        case EventType::COUNTER:
+        {
+          double counter;
+          std::memcpy(&counter, &value, sizeof(counter));
+          writer.write(",\"ph\":\"C\",\"args\":{\"value\":");
+          writer.writeDouble(counter);
+          writer.write("}");
+          break;
+        }
+        case EventType::MARKER:
+          writer.write(",\"ph\":\"i\",\"s\":\"t\"");
+          break;
+        case EventType::OVERRUN:
+          writer.write(",\"ph\":\"i\",\"s\":\"p\",\"cat\":\"overrun\"");
+          break;
+      }
+      writer.write(",\"ts\":");
+      writer.writeMicroseconds(time);
+      writer.write(",\"pid\":");
+      writer.writeInteger(pid);
+      writer.write(",\"tid\":");
+      writer.writeInteger(thread_id);
+      writer.write("}");
+    }
+  }
+  writer.write("\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"reason\":");
+  writer.writeString(reason, PATH_MAX);
+  writer.write(",\"dump_time\":");
+  writer.writeMicroseconds(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    FlightRecorder::Clock::now().time_since_epoch()).count());
+  writer.write("}}\n");
+}
+
+void setDumpPrefix(const std::string& directory)
+{
+  const std::string prefix = directory + "/flight_recorder_" + std::to_string(getpid()) + "_";
+  const std::size_t length = std::min(prefix.size(), sizeof(dump_prefix) - 1);
+  dump_prefix_set.store(false);
+  std::memcpy(dump_prefix, prefix.data(), length);
+  dump_prefix[length] = '\0';
+  dump_prefix_set.store(true);
+}
+
+void initializeDumpPrefix()
+{
+  if (dump_prefix_set.load())
+  {
+    return;
+  }
+
+  const char* ros_log_dir = std::getenv("ROS_LOG_DIR");
+  const char* ros_home = std::getenv("ROS_HOME");
+  const char* home = std::getenv("HOME");
+  if (ros_log_dir != nullptr)
+  {
+    setDumpPrefix(ros_log_dir);
+  }
+  else if (ros_home != nullptr)
+  {
+    setDumpPrefix(std::string(ros_home) + "/log");
+  }
+  else if (home != nullptr)
+  {
+    setDumpPrefix(std::string(home) + "/.ros/log");
+  }
+  else
+  {
+    setDumpPrefix("/tmp");
+  }
+}
+
+/// Writes a dump file named after the prefix and a counter into the given buffer; async-signal-safe.
+bool writeDumpFile(const char* reason, char (&file_name)[PATH_MAX + 32])
+{
+  if (!dump_prefix_set.load())
+  {
+    return false;
+  }
+
+  std::size_t length = strnlen(dump_prefix, PATH_MAX);
+  std::memcpy(file_name, dump_prefix, length);
+  char digits[10];
+  std::size_t digit_count = 0;
+  std::uint32_t number = dump_count.fetch_add(1);
+  do
+  {
+    digits[digit_count++] = static_cast<char>('0' + number % 10);
+    number /= 10;
+  }
+  while (number > 0);
+  while (digit_count > 0)
+  {
+    file_name[length++] = digits[--digit_count];
+  }
+  std::memcpy(file_name + length, ".json", sizeof(".json"));
+
+  const int fd = open(file_name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+  {
+    return false;
+  }
+  writeTrace(fd, reason);
+  close(fd);
+  return true;
+}
+
+void runDumpThread()
+{
+  while (true)
+  {
+    if (sem_wait(&dump_semaphore) != 0)
+    {
+      continue;  // Interrupted by a signal
+    }
+    const char* reason = requested_dump_reason.exchange(nullptr);
+    if (reason != nullptr)
+    {
+      FlightRecorder::dump(reason);
+    }
+  }
+}
+
+void startDumpThread()
+{
+  std::call_once(dump_thread_started, []()
+  {
+    sem_init(&dump_semaphore, 0, 0);
+    std::thread(&runDumpThread).detach();
+    dump_thread_running.store(true);
+  });
+}
+
+extern "C" void handleDumpSignal(int /*signal*/)
+{
+  FlightRecorder::requestDump("SIGUSR2");
+}
+
+extern "C" void handleCrashSignal(int signal)
+{
+  const int saved_errno = errno;
+  for (std::size_t i = 0; i < CRASH_SIGNAL_COUNT; ++i)
+  {
+    if (CRASH_SIGNALS[i] == signal)
+    {
+      char file_name[PATH_MAX + 32];
+      writeDumpFile(CRASH_SIGNAL_NAMES[i], file_name);
+
+      // Let the previous handler (or the default action) deal with the signal once this handler returns:
+      sigaction(signal, &previous_crash_actions[i], nullptr);
+      break;
+    }
+  }
+  errno = saved_errno;
+  raise(signal);
+}
+
+}  // namespace
+
+void FlightRecorder::setEnabled(const bool enabled)
+{
+  recording_enabled.store(enabled);
+}
+
+bool FlightRecorder::isEnabled()
+{
+  return recording_enabled.load();
+}
+
+void FlightRecorder::setCapacity(const std::size_t capacity)
+{
+  ring_capacity.store(std::max<std::size_t>(capacity, 1));
+}
+
+void FlightRecorder::registerThread()
+{
+  getThreadRing();
+}
+
+void FlightRecorder::recordDuration(
+  const std::string& name, const Clock::time_point& start_time, const Clock::duration& duration) noexcept
+{
+  record(EventType::DURATION, name, start_time, static_cast<std::uint64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(std::max(duration, Clock::duration::zero())).count()));
+}
+
+void FlightRecorder::recordCounter(const std::string& name, const double value) noexcept
+{
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  record(EventType::COUNTER, name, Clock::now(), bits);
+}
+
+void FlightRecorder::recordMarker(const std::string& name) noexcept
+{
+  record(EventType::MARKER, name, Clock::now(), 0);
+}
+
+void FlightRecorder::recordOverrun(const std::string& name) noexcept
+{
+  const Clock::time_point now = Clock::now();
+  record(EventType::OVERRUN, name, now, 0);
+
+  if (dump_on_overrun.load(std::memory_order_relaxed))
+  {
+    Clock::rep last_dump = last_overrun_dump.load(std::memory_order_relaxed);
+    if (now.time_since_epoch().count() - last_dump >= dump_on_overrun_interval.load(std::memory_order_relaxed)
+        && last_overrun_dump.compare_exchange_strong(last_dump, now.time_since_epoch().count()))
+    {
+      requestDump("deadline overrun");
+    }
+  }
+}
+
+void FlightRecorder::setDumpDirectory(const std::string& directory)
+{
+  std::lock_guard<std::mutex> lock(dump_mutex);
+  setDumpPrefix(directory);
+}
+
+std::string FlightRecorder::dump(const std::string& reason)
+{
+  std::lock_guard<std::mutex> lock(dump_mutex);
+  initializeDumpPrefix();
+
+  char file_name[PATH_MAX + 32];
+  if (!writeDumpFile(reason.c_str(), file_name))
+  {
+    ROS_WARN_NAMED("flight_recorder", "failed to write flight recorder dump to '%s': %s", file_name, strerror(errno));
+    return std::string();
+  }
+  ROS_INFO_NAMED("flight_recorder", "wrote flight recorder dump (%s) to '%s'", reason.c_str(), file_name);
+  return file_name;
+}
+
+void FlightRecorder::requestDump(const char* reason) noexcept
+{
+  if (dump_thread_running.load() && requested_dump_reason.exchange(reason) == nullptr)
+  {
+    sem_post(&dump_semaphore);
+  }
+}
+
+void FlightRecorder::setDumpOnOverrun(const bool enabled, const Clock::duration& min_interval)
+{
+  if (enabled)
+  {
+    startDumpThread();
+  }
+  dump_on_overrun_interval.store(min_interval.count());
+  last_overrun_dump.store(std::numeric_limits<Clock::rep>::min() / 2);
+  dump_on_overrun.store(enabled);
+}
+
+void FlightRecorder::installSignalHandlers(const bool dump_on_crash)
+{
+  {
+    std::lock_guard<std::mutex> lock(dump_mutex);
+    initializeDumpPrefix();
+  }
+  startDumpThread();
+
+  struct sigaction action{};
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  action.sa_handler = &handleDumpSignal;
+  sigaction(SIGUSR2, &action, nullptr);
+
+  if (dump_on_crash)
+  {
+    action.sa_flags = SA_ONSTACK;
+    action.sa_handler = &handleCrashSignal;
+    for (std::size_t i = 0; i < CRASH_SIGNAL_COUNT; ++i)
+    {
+      sigaction(CRASH_SIGNALS[i], &action, &previous_crash_actions[i]);
+    }
+  }
+}
+
+}  // namespace arti_profiling
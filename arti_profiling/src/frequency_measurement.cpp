@@ -25,7 +25,9 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <arti_profiling/frequency_measurement.h>
+#include <arti_profiling/flight_recorder.h>
 #include <arti_profiling/simple_formatter.h>
+#include "probes.h"
 #include <ros/console.h>
 #include <utility>
 
@@ -43,6 +45,9 @@ FrequencyMeasurement::FrequencyMeasurement(
   Profiler& profiler, const std::string& name, const Statistics<double>::Formatter& formatter,
   const Clock::time_point& time)
 {
+  ARTI_PROFILING_PROBE1(frequency, name.c_str());
+  FlightRecorder::recordMarker(name);
+
   Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
   if (!profile_update.profile)
   {
@@ -52,11 +57,7 @@ FrequencyMeasurement::FrequencyMeasurement(
   std::shared_ptr<FrequencyStatistics> fs = std::dynamic_pointer_cast<FrequencyStatistics>(profile_update.profile);
   if (fs)
   {
-    if (fs->last_time_ != Clock::time_point())
-    {
-      fs->accumulate(1.0 / std::chrono::duration_cast<std::chrono::duration<double>>(time - fs->last_time_).count());
-    }
-    fs->last_time_ = time;
+    fs->accumulateEvent(time);
   }
   else
   {
@@ -64,9 +65,34 @@ FrequencyMeasurement::FrequencyMeasurement(
   }
 }
 
+FrequencyMeasurement::FrequencyMeasurement(
+  FrequencyStatistics& statistics, const std::string& name, const Clock::time_point& time)
+{
+  ARTI_PROFILING_PROBE1(frequency, name.c_str());
+  FlightRecorder::recordMarker(name);
+  statistics.accumulateEvent(time);
+}
+
 FrequencyStatistics::FrequencyStatistics(Formatter formatter)
   : Statistics(std::move(formatter))
 {
 }
 
+void FrequencyStatistics::accumulateEvent(const FrequencyMeasurement::Clock::time_point& time)
+{
+  Lock lock(mutex_);
+  if (last_time_ != FrequencyMeasurement::Clock::time_point())
+  {
+    accumulate(1.0 / std::chrono::duration_cast<std::chrono::duration<double>>(time - last_time_).count());
+  }
+  last_time_ = time;
+}
+
+bool FrequencyStatistics::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Statistics::takeSnapshot(snapshot);
+  snapshot.type = "frequency";
+  return true;
+}
+
 }  // namespace arti_profiling
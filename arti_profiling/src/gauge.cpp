@@ -0,0 +1,108 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/gauge.h>
+#include <arti_profiling/flight_recorder.h>
+#include <arti_profiling/simple_formatter.h>
+#include "probes.h"
+#include <cmath>
+#include <cstdint>
+#include <ros/console.h>
+#include <utility>
+
+namespace arti_profiling
+{
+
+const GaugeMeasurement::Formatter GaugeMeasurement::DEFAULT_FORMATTER(SimpleFormatter<double>("", 8, 1));
+
+GaugeMeasurement::GaugeMeasurement(Profiler& profiler, const std::string& name, const double value)
+  : GaugeMeasurement(profiler, name, value, DEFAULT_FORMATTER)
+{
+}
+
+GaugeMeasurement::GaugeMeasurement(
+  Profiler& profiler, const std::string& name, const double value, const Formatter& formatter)
+{
+  ARTI_PROFILING_PROBE2(gauge, name.c_str(), static_cast<std::int64_t>(std::llround(value * 1000.0)));
+  FlightRecorder::recordCounter(name, value);
+
+  Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<GaugeStatistics>(formatter);
+  }
+
+  std::shared_ptr<GaugeStatistics> gs = std::dynamic_pointer_cast<GaugeStatistics>(profile_update.profile);
+  if (gs)
+  {
+    gs->accumulate(value);
+  }
+  else
+  {
+    ROS_WARN_NAMED("gauge", "profiling measurement types do not match");
+  }
+}
+
+GaugeStatistics::GaugeStatistics(Formatter formatter)
+  : Statistics(std::move(formatter))
+{
+}
+
+void GaugeStatistics::accumulate(const double& value)
+{
+  Lock lock(mutex_);
+  Statistics::accumulate(value);
+  last_value_ = value;
+}
+
+double GaugeStatistics::getLastValue() const
+{
+  Lock lock(mutex_);
+  return last_value_;
+}
+
+void GaugeStatistics::clear()
+{
+  Lock lock(mutex_);
+  Statistics::clear();
+  last_value_ = 0.0;
+}
+
+bool GaugeStatistics::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+  Statistics::takeSnapshot(snapshot);
+  snapshot.type = "gauge";
+  return true;
+}
+
+void GaugeStatistics::printAdditionalValues(std::ostream& out) const
+{
+  out << ", last: ";
+  formatter_(out, last_value_);
+}
+
+}  // namespace arti_profiling
@@ -0,0 +1,199 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/histogram.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace arti_profiling
+{
+
+// Offset added to binary exponents to keep the indices of all positive finite doubles positive:
+static const std::int32_t EXPONENT_OFFSET = 1100;
+
+void Histogram::add(const double value, const std::uint64_t count)
+{
+  if (std::isnan(value) || count == 0)
+  {
+    return;
+  }
+  buckets_[getBucketIndex(value)] += count;
+  count_ += count;
+}
+
+void Histogram::merge(const Histogram& other)
+{
+  for (const auto& bucket : other.buckets_)
+  {
+    buckets_[bucket.first] += bucket.second;
+  }
+  count_ += other.count_;
+}
+
+void Histogram::clear()
+{
+  buckets_.clear();
+  count_ = 0;
+}
+
+bool Histogram::empty() const
+{
+  return count_ == 0;
+}
+
+std::size_t Histogram::getMemoryUsage() const
+{
+  // Each bucket is a map node, which adds about four pointers to the value:
+  return sizeof(Histogram) + buckets_.size() * (sizeof(Buckets::value_type) + 4 * sizeof(void*));
+}
+
+std::uint64_t Histogram::getCount() const
+{
+  return count_;
+}
+
+const Histogram::Buckets& Histogram::getBuckets() const
+{
+  return buckets_;
+}
+
+void Histogram::setBucketCount(const std::int32_t index, const std::uint64_t count)
+{
+  std::uint64_t& bucket_count = buckets_[index];
+  count_ = count_ - bucket_count + count;
+  bucket_count = count;
+  if (count == 0)
+  {
+    buckets_.erase(index);
+  }
+}
+
+double Histogram::getQuantile(const double quantile) const
+{
+  if (buckets_.empty())
+  {
+    return 0.0;
+  }
+
+  const double rank = std::max(1.0, std::ceil(std::min(std::max(quantile, 0.0), 1.0) * count_));
+  std::uint64_t cumulative_count = 0;
+  for (const auto& bucket : buckets_)
+  {
+    cumulative_count += bucket.second;
+    if (cumulative_count >= rank)
+    {
+      return getBucketValue(bucket.first);
+    }
+  }
+  return getBucketValue(buckets_.rbegin()->first);
+}
+
+double Histogram::getMidRank(const std::int32_t index) const
+{
+  double rank = 0.0;
+  for (const auto& bucket : buckets_)
+  {
+    if (bucket.first >= index)
+    {
+      if (bucket.first == index)
+      {
+        rank += 0.5 * bucket.second;
+      }
+      break;
+    }
+    rank += bucket.second;
+  }
+  return rank;
+}
+
+std::int32_t Histogram::getBucketIndex(const double value)
+{
+  if (value == 0.0)
+  {
+    return 0;
+  }
+  if (value < 0.0)
+  {
+    return -getBucketIndex(-value);
+  }
+  if (std::isinf(value))
+  {
+    return getBucketIndex(std::numeric_limits<double>::max());
+  }
+
+  int exponent = 0;
+  const double mantissa = std::frexp(value, &exponent);  // 0.5 <= mantissa < 1
+  const std::int32_t sub_bucket
+    = std::min(SUB_BUCKET_COUNT - 1, static_cast<int>((mantissa - 0.5) * 2 * SUB_BUCKET_COUNT));
+  return (exponent + EXPONENT_OFFSET) * SUB_BUCKET_COUNT + sub_bucket + 1;
+}
+
+double Histogram::getBucketLowerBound(const std::int32_t index)
+{
+  if (index == 0)
+  {
+    return 0.0;
+  }
+  if (index < 0)
+  {
+    return -getBucketUpperBound(-index);
+  }
+
+  const std::int32_t exponent = (index - 1) / SUB_BUCKET_COUNT - EXPONENT_OFFSET;
+  const std::int32_t sub_bucket = (index - 1) % SUB_BUCKET_COUNT;
+  return std::ldexp(0.5 + 0.5 * sub_bucket / SUB_BUCKET_COUNT, exponent);
+}
+
+double Histogram::getBucketUpperBound(const std::int32_t index)
+{
+  if (index == 0)
+  {
+    return 0.0;
+  }
+  if (index < 0)
+  {
+    return -getBucketLowerBound(-index);
+  }
+  return getBucketLowerBound(index + 1);
+}
+
+double Histogram::getBucketValue(const std::int32_t index)
+{
+  return 0.5 * (getBucketLowerBound(index) + getBucketUpperBound(index));
+}
+
+bool Histogram::operator==(const Histogram& other) const
+{
+  return count_ == other.count_ && buckets_ == other.buckets_;
+}
+
+bool Histogram::operator!=(const Histogram& other) const
+{
+  return !(*this == other);
+}
+
+}  // namespace arti_profiling
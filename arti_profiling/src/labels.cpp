@@ -0,0 +1,134 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/labels.h>
+#include <algorithm>
+#include <boost/functional/hash.hpp>
+
+namespace arti_profiling
+{
+
+LabelSet::LabelSet() = default;
+
+LabelSet::LabelSet(std::initializer_list<Label> labels)
+  : LabelSet(std::vector<Label>(labels))
+{
+}
+
+LabelSet::LabelSet(std::vector<Label> labels)
+{
+  if (labels.empty())
+  {
+    return;
+  }
+
+  std::shared_ptr<Data> data = std::make_shared<Data>();
+  data->labels = std::move(labels);
+  std::sort(data->labels.begin(), data->labels.end());
+  data->labels.erase(
+    std::unique(data->labels.begin(), data->labels.end(),
+                [](const Label& a, const Label& b) { return a.first == b.first; }), data->labels.end());
+  for (const Label& label : data->labels)
+  {
+    boost::hash_combine(data->hash, label.first);
+    boost::hash_combine(data->hash, label.second);
+  }
+  data_ = std::move(data);
+}
+
+bool LabelSet::empty() const
+{
+  return !data_;
+}
+
+std::size_t LabelSet::getHash() const
+{
+  return data_ ? data_->hash : 0;
+}
+
+const std::vector<LabelSet::Label>& LabelSet::getLabels() const
+{
+  static const std::vector<Label> NO_LABELS;
+  return data_ ? data_->labels : NO_LABELS;
+}
+
+std::size_t LabelSet::getMemoryUsage() const
+{
+  std::size_t result = sizeof(LabelSet);
+  if (data_)
+  {
+    result += sizeof(Data) + data_->labels.capacity() * sizeof(Label);
+    for (const Label& label : data_->labels)
+    {
+      result += label.first.capacity() + label.second.capacity();
+    }
+  }
+  return result;
+}
+
+const std::string* LabelSet::find(const std::string& key) const
+{
+  for (const Label& label : getLabels())
+  {
+    if (label.first == key)
+    {
+      return &label.second;
+    }
+  }
+  return nullptr;
+}
+
+std::string LabelSet::toString() const
+{
+  std::string result;
+  for (const Label& label : getLabels())
+  {
+    if (!result.empty())
+    {
+      result += ',';
+    }
+    result += label.first;
+    result += '=';
+    result += label.second;
+  }
+  return result;
+}
+
+bool LabelSet::operator==(const LabelSet& other) const
+{
+  if (data_ == other.data_)
+  {
+    return true;
+  }
+  return getHash() == other.getHash() && getLabels() == other.getLabels();
+}
+
+bool LabelSet::operator!=(const LabelSet& other) const
+{
+  return !(*this == other);
+}
+
+}  // namespace arti_profiling
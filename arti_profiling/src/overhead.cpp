@@ -0,0 +1,158 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/overhead.h>
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profiler.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <mutex>
+
+namespace arti_profiling
+{
+
+namespace
+{
+
+using Clock = DurationMeasurement::Clock;
+
+const int CALIBRATION_ITERATIONS = 1000;
+const int CALIBRATION_RUNS = 5;  ///< The fastest run is taken, as the others were likely disturbed
+
+std::atomic<bool> overhead_compensation_enabled{false};
+
+thread_local bool calibrating = false;
+
+/// Marks the calling thread as calibrating while it exists.
+struct CalibratingScope
+{
+  CalibratingScope()
+  {
+    calibrating = true;
+  }
+
+  ~CalibratingScope()
+  {
+    calibrating = false;
+  }
+};
+
+/// A profiler outside of the tree of the root profiler, so that calibration doesn't show up in the statistics.
+class CalibrationProfiler : public Profiler
+{
+public:
+  CalibrationProfiler() = default;
+};
+
+/// Returns the minimum duration of the given function over several runs, divided by the iterations it performs.
+template<typename Function>
+double measureMinimum(const Function& function)
+{
+  double minimum = std::numeric_limits<double>::infinity();
+  for (int run = 0; run < CALIBRATION_RUNS; ++run)
+  {
+    const Clock::time_point start_time = Clock::now();
+    function();
+    const Clock::duration duration = Clock::now() - start_time;
+    minimum = std::min(minimum, std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(duration).count());
+  }
+  return minimum / CALIBRATION_ITERATIONS;
+}
+
+}  // namespace
+
+double OverheadCalibration::getMeasurementCost() const
+{
+  return 2.0 * clock_read + commit;
+}
+
+OverheadCalibration calibrateOverhead()
+{
+  const CalibratingScope calibrating_scope;
+  OverheadCalibration calibration;
+
+  calibration.clock_read = measureMinimum([]()
+  {
+    for (int i = 0; i < CALIBRATION_ITERATIONS; ++i)
+    {
+      volatile Clock::rep time = Clock::now().time_since_epoch().count();
+      (void) time;
+    }
+  });
+
+  std::recursive_mutex mutex;
+  calibration.lock = measureMinimum([&mutex]()
+  {
+    for (int i = 0; i < CALIBRATION_ITERATIONS; ++i)
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex);
+    }
+  });
+
+  CalibrationProfiler profiler;
+  const Clock::time_point time = Clock::now();
+  DurationMeasurement(profiler, "calibration", time).stop(time);  // Creates the profile
+  calibration.commit = measureMinimum([&profiler, &time]()
+  {
+    for (int i = 0; i < CALIBRATION_ITERATIONS; ++i)
+    {
+      DurationMeasurement measurement(profiler, "calibration", time);
+      measurement.stop(time);
+    }
+  });
+
+  return calibration;
+}
+
+bool isCalibratingOverhead()
+{
+  return calibrating;
+}
+
+const OverheadCalibration& getOverheadCalibration()
+{
+  // This is thread-safe according to paragraph 6.7 [stmt.dcl] p4:
+  static const OverheadCalibration calibration = calibrateOverhead();
+  return calibration;
+}
+
+void setOverheadCompensationEnabled(const bool enabled)
+{
+  if (enabled)
+  {
+    getOverheadCalibration();
+  }
+  overhead_compensation_enabled.store(enabled);
+}
+
+bool isOverheadCompensationEnabled()
+{
+  return overhead_compensation_enabled.load(std::memory_order_relaxed);
+}
+
+}  // namespace arti_profiling
@@ -0,0 +1,458 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/pipeline_profiler.h>
+#include <algorithm>
+#include <boost/format.hpp>
+#include <iomanip>
+#include <limits>
+#include <ros/console.h>
+
+namespace arti_profiling
+{
+
+const std::size_t PipelineProfile::DEFAULT_MAX_ITEMS_IN_FLIGHT = 1000;
+
+const std::size_t PipelineProfile::NO_STAGE = std::numeric_limits<std::size_t>::max();
+
+PipelineProfile::Stage::Stage(std::string name, const Formatter& formatter)
+  : name(std::move(name)), queue_times(formatter), service_times(formatter)
+{
+}
+
+PipelineProfile::PipelineProfile(const Formatter& formatter)
+  : formatter_(formatter), max_items_in_flight_(DEFAULT_MAX_ITEMS_IN_FLIGHT), latencies_(formatter),
+    interval_start_(Clock::now())
+{
+  latencies_.setHistogramEnabled(true);
+}
+
+void PipelineProfile::addStage(
+  const std::string& name, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs)
+{
+  Lock lock(mutex_);
+
+  std::size_t index = findStage(name);
+  if (index == NO_STAGE)
+  {
+    index = stages_.size();
+    stages_.emplace_back(new Stage(name, formatter_));
+    stage_indices_[name] = index;
+  }
+  stages_[index]->inputs = inputs;
+  stages_[index]->outputs = outputs;
+
+  // Stages might be declared in any order, so rebuild all connections:
+  for (const std::unique_ptr<Stage>& stage : stages_)
+  {
+    stage->upstream.clear();
+    stage->downstream.clear();
+  }
+  for (std::size_t producer = 0; producer < stages_.size(); ++producer)
+  {
+    for (std::size_t consumer = 0; consumer < stages_.size(); ++consumer)
+    {
+      const std::vector<std::string>& produced = stages_[producer]->outputs;
+      const std::vector<std::string>& consumed = stages_[consumer]->inputs;
+      if (producer != consumer && std::any_of(produced.begin(), produced.end(), [&consumed](const std::string& stream)
+      {
+        return std::find(consumed.begin(), consumed.end(), stream) != consumed.end();
+      }))
+      {
+        stages_[producer]->downstream.push_back(consumer);
+        stages_[consumer]->upstream.push_back(producer);
+      }
+    }
+  }
+}
+
+void PipelineProfile::setMaxItemsInFlight(const std::size_t count)
+{
+  Lock lock(mutex_);
+  max_items_in_flight_ = std::max<std::size_t>(count, 1);
+}
+
+void PipelineProfile::startItem(const ItemId id, const Clock::time_point& time)
+{
+  Lock lock(mutex_);
+  findItem(id, time)->second.start = time;
+}
+
+void PipelineProfile::beginStage(const std::string& stage, const ItemId id, const Clock::time_point& time)
+{
+  Lock lock(mutex_);
+
+  const std::size_t index = findStage(stage);
+  if (index == NO_STAGE)
+  {
+    ROS_WARN_ONCE_NAMED("pipeline_profiler", "pipeline stage '%s' was not declared", stage.c_str());
+    return;
+  }
+
+  Item& item = findItem(id, time)->second;
+  StageTiming& timing = item.stages[index];
+  if (timing.state == StageTiming::State::PENDING && timing.arrival != Clock::time_point())
+  {
+    --stages_[index]->backlog;
+  }
+  else if (timing.arrival == Clock::time_point())
+  {
+    // Items enter the pipeline at source stages; for other stages, the input wasn't seen, so don't assume a queue:
+    timing.arrival = stages_[index]->upstream.empty() ? std::min(item.start, time) : time;
+  }
+  timing.state = StageTiming::State::ACTIVE;
+  timing.begin = time;
+}
+
+void PipelineProfile::endStage(const std::string& stage, const ItemId id, const Clock::time_point& time)
+{
+  Lock lock(mutex_);
+
+  const std::size_t index = findStage(stage);
+  if (index == NO_STAGE)
+  {
+    ROS_WARN_ONCE_NAMED("pipeline_profiler", "pipeline stage '%s' was not declared", stage.c_str());
+    return;
+  }
+
+  const Items::iterator item = findItem(id, time);
+  StageTiming& timing = item->second.stages[index];
+  if (timing.state != StageTiming::State::ACTIVE)
+  {
+    beginStage(stage, id, time);  // Without begin, the stage's service time is unknown and taken as zero
+  }
+  timing.state = StageTiming::State::DONE;
+  timing.end = time;
+
+  Stage& s = *stages_[index];
+  s.queue_times.accumulate((timing.begin - timing.arrival).count());
+  s.service_times.accumulate((timing.end - timing.begin).count());
+  ++s.completed_count;
+
+  // The item is now available to all consumers; the last input finished determines when it arrived at a join:
+  for (const std::size_t consumer : s.downstream)
+  {
+    StageTiming& consumer_timing = item->second.stages[consumer];
+    if (consumer_timing.state != StageTiming::State::PENDING)
+    {
+      continue;
+    }
+    if (consumer_timing.arrival == Clock::time_point())
+    {
+      Stage& c = *stages_[consumer];
+      c.max_backlog = std::max(c.max_backlog, ++c.backlog);
+    }
+    if (consumer_timing.arrival <= time)
+    {
+      consumer_timing.arrival = time;
+      consumer_timing.critical_predecessor = index;
+    }
+  }
+
+  if (s.downstream.empty())
+  {
+    const bool unfinished = std::any_of(
+      item->second.stages.begin(), item->second.stages.end(),
+      [](const std::pair<const std::size_t, StageTiming>& entry)
+      {
+        return entry.second.state != StageTiming::State::DONE;
+      });
+    if (!unfinished)
+    {
+      completeItem(item, index);
+    }
+  }
+}
+
+void PipelineProfile::dropItem(const ItemId id)
+{
+  Lock lock(mutex_);
+
+  const Items::iterator item = items_.find(id);
+  if (item != items_.end())
+  {
+    eraseItem(item);
+    ++dropped_count_;
+  }
+}
+
+void PipelineProfile::print(std::ostream& out) const
+{
+  Lock lock(mutex_);
+
+  out << boost::format("%2d stages, %d items in flight, %d dropped, latency: ") % stages_.size() % items_.size()
+         % dropped_count_;
+  latencies_.print(out);
+}
+
+void PipelineProfile::printDetails(std::ostream& out, const int indent) const
+{
+  Lock lock(mutex_);
+
+  const double interval = std::chrono::duration_cast<std::chrono::duration<double>>(
+    Clock::now() - interval_start_).count();
+  const std::size_t item_count = latencies_.getCount();
+  for (const std::unique_ptr<Stage>& stage : stages_)
+  {
+    out << std::setw(indent) << "" << stage->name
+        << std::setw(28 - std::min(28, static_cast<int>(stage->name.size())) + 2) << std::left << ": " << std::right
+        << boost::format("%7.2f/s, backlog: %3d (max %3d), on critical path: %5.1f%%")
+           % (interval > 0.0 ? stage->completed_count / interval : 0.0) % stage->backlog % stage->max_backlog
+           % (item_count > 0 ? 100.0 * stage->critical_count / item_count : 0.0);
+    if (stage->critical_count > 0)
+    {
+      out << ", avg contribution: ";
+      formatter_(out, stage->critical_time.count() / static_cast<Clock::rep>(stage->critical_count));
+    }
+    out << std::endl;
+    out << std::setw(indent + 2) << "" << "queue:   ";
+    stage->queue_times.print(out);
+    out << std::setw(indent + 2) << "" << "service: ";
+    stage->service_times.print(out);
+  }
+
+  // The most frequent critical paths, most frequent first:
+  std::vector<std::pair<std::size_t, std::string>> paths;
+  for (const std::pair<const std::string, std::size_t>& path : critical_paths_)
+  {
+    paths.emplace_back(path.second, path.first);
+  }
+  std::sort(paths.rbegin(), paths.rend());
+  for (std::size_t i = 0; i < paths.size() && i < 3; ++i)
+  {
+    out << std::setw(indent) << "" << boost::format("critical path (%5.1f%%): ") % (100.0 * paths[i].first / item_count)
+        << paths[i].second << std::endl;
+  }
+}
+
+bool PipelineProfile::reset()
+{
+  Lock lock(mutex_);
+
+  for (const std::unique_ptr<Stage>& stage : stages_)
+  {
+    stage->queue_times.clear();
+    stage->service_times.clear();
+    stage->completed_count = 0;
+    stage->max_backlog = stage->backlog;
+    stage->critical_count = 0;
+    stage->critical_time = {};
+  }
+  latencies_.clear();
+  critical_paths_.clear();
+  dropped_count_ = 0;
+  interval_start_ = Clock::now();
+  return true;  // The declared stages and the items in flight must be kept
+}
+
+bool PipelineProfile::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+
+  latencies_.takeSnapshot(snapshot);
+  snapshot.type = "pipeline";
+  snapshot.counters["dropped"] = dropped_count_;
+  snapshot.counters["interval_ns"] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    Clock::now() - interval_start_).count();
+  for (const std::unique_ptr<Stage>& stage : stages_)
+  {
+    ProfileSnapshot& stage_snapshot = snapshot.labels["stage=" + stage->name];
+    stage->service_times.takeSnapshot(stage_snapshot);
+    stage->queue_times.takeSnapshot(stage_snapshot.labels["queue"]);
+    stage_snapshot.counters["max_backlog"] = stage->max_backlog;
+    stage_snapshot.counters["critical"] = stage->critical_count;
+    stage_snapshot.counters["critical_ns"] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      stage->critical_time).count();
+  }
+  return true;
+}
+
+std::size_t PipelineProfile::getMemoryUsage() const
+{
+  Lock lock(mutex_);
+
+  std::size_t result = sizeof(*this) - sizeof(DurationStatistics) + latencies_.getMemoryUsage()
+    + stages_.capacity() * sizeof(stages_.front()) + items_.bucket_count() * sizeof(void*);
+  for (const std::unique_ptr<Stage>& stage : stages_)
+  {
+    result += sizeof(Stage) - 2 * sizeof(DurationStatistics) + stage->queue_times.getMemoryUsage()
+      + stage->service_times.getMemoryUsage() + NODE_OVERHEAD + sizeof(*stage_indices_.begin())
+      + 2 * stage->name.capacity() + (stage->upstream.capacity() + stage->downstream.capacity()) * sizeof(std::size_t);
+    for (const std::string& stream : stage->inputs)
+    {
+      result += sizeof(stream) + stream.capacity();
+    }
+    for (const std::string& stream : stage->outputs)
+    {
+      result += sizeof(stream) + stream.capacity();
+    }
+  }
+  for (const Items::value_type& item : items_)
+  {
+    result += NODE_OVERHEAD + sizeof(item) + item.second.stages.size() * (NODE_OVERHEAD + sizeof(StageTiming));
+  }
+  for (const std::pair<const std::string, std::size_t>& path : critical_paths_)
+  {
+    result += NODE_OVERHEAD + sizeof(path) + path.first.capacity();
+  }
+  return result;
+}
+
+std::size_t PipelineProfile::findStage(const std::string& name) const
+{
+  const std::map<std::string, std::size_t>::const_iterator it = stage_indices_.find(name);
+  return it != stage_indices_.end() ? it->second : NO_STAGE;
+}
+
+PipelineProfile::Items::iterator PipelineProfile::findItem(const ItemId id, const Clock::time_point& time)
+{
+  Items::iterator item = items_.find(id);
+  if (item != items_.end())
+  {
+    return item;
+  }
+
+  if (items_.size() >= max_items_in_flight_)
+  {
+    // Items that are never finished, e.g. because a stage silently filtered them out, end up here:
+    const Items::iterator oldest = std::min_element(
+      items_.begin(), items_.end(), [](const Items::value_type& a, const Items::value_type& b)
+      {
+        return a.second.start < b.second.start;
+      });
+    eraseItem(oldest);
+    ++dropped_count_;
+  }
+
+  item = items_.emplace(id, Item()).first;
+  item->second.start = time;
+  return item;
+}
+
+void PipelineProfile::completeItem(const Items::iterator item, const std::size_t sink)
+{
+  latencies_.accumulate((item->second.stages[sink].end - item->second.start).count());
+
+  std::vector<std::size_t> path;
+  for (std::size_t index = sink; index != NO_STAGE; index = item->second.stages[index].critical_predecessor)
+  {
+    const StageTiming& timing = item->second.stages[index];
+    Stage& stage = *stages_[index];
+    ++stage.critical_count;
+    stage.critical_time += timing.end - timing.arrival;
+    path.push_back(index);
+  }
+
+  std::string path_string;
+  for (std::vector<std::size_t>::const_reverse_iterator it = path.rbegin(); it != path.rend(); ++it)
+  {
+    if (!path_string.empty())
+    {
+      path_string += " -> ";
+    }
+    path_string += stages_[*it]->name;
+  }
+  ++critical_paths_[path_string];
+
+  items_.erase(item);
+}
+
+void PipelineProfile::eraseItem(const Items::iterator item)
+{
+  for (const std::pair<const std::size_t, StageTiming>& entry : item->second.stages)
+  {
+    if (entry.second.state == StageTiming::State::PENDING && entry.second.arrival != Clock::time_point())
+    {
+      --stages_[entry.first]->backlog;
+    }
+  }
+  items_.erase(item);
+}
+
+PipelineProfiler::StageScope::StageScope(PipelineProfiler& pipeline, std::string stage, const ItemId id)
+  : pipeline_(pipeline), stage_(std::move(stage)), id_(id)
+{
+  pipeline_.beginStage(stage_, id_);
+}
+
+PipelineProfiler::StageScope::~StageScope()
+{
+  pipeline_.endStage(stage_, id_);
+}
+
+PipelineProfiler::PipelineProfiler(Profiler& profiler, const std::string& name)
+{
+  Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<PipelineProfile>();
+  }
+
+  profile_ = std::dynamic_pointer_cast<PipelineProfile>(profile_update.profile);
+  if (!profile_)
+  {
+    ROS_WARN_NAMED("pipeline_profiler", "profiling measurement types do not match");
+    profile_ = std::make_shared<PipelineProfile>();  // Keep the pipeline working, although not reported
+  }
+}
+
+void PipelineProfiler::addStage(
+  const std::string& name, const std::vector<std::string>& inputs, const std::vector<std::string>& outputs)
+{
+  profile_->addStage(name, inputs, outputs);
+}
+
+void PipelineProfiler::setMaxItemsInFlight(const std::size_t count)
+{
+  profile_->setMaxItemsInFlight(count);
+}
+
+void PipelineProfiler::startItem(const ItemId id, const Clock::time_point& time)
+{
+  profile_->startItem(id, time);
+}
+
+void PipelineProfiler::beginStage(const std::string& stage, const ItemId id, const Clock::time_point& time)
+{
+  profile_->beginStage(stage, id, time);
+}
+
+void PipelineProfiler::endStage(const std::string& stage, const ItemId id, const Clock::time_point& time)
+{
+  profile_->endStage(stage, id, time);
+}
+
+void PipelineProfiler::dropItem(const ItemId id)
+{
+  profile_->dropItem(id);
+}
+
+const std::shared_ptr<PipelineProfile>& PipelineProfiler::getProfile() const
+{
+  return profile_;
+}
+
+}  // namespace arti_profiling
@@ -0,0 +1,57 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#ifndef ARTI_PROFILING_PROBES_H
+#define ARTI_PROFILING_PROBES_H
+
+// USDT probes for external tracers like bpftrace or perf, enabled with the CMake option ARTI_PROFILING_USDT. Each probe
+// is a NOP until a tracer attaches to it; the probe arguments are evaluated regardless, so they must be cheap. E.g.:
+//   bpftrace -e 'usdt:/path/to/libarti_profiling.so:arti_profiling:duration_stop
+//                { @[str(arg0)] = hist(arg1); }' -p <pid>
+//
+// Probes (provider arti_profiling):
+//   duration_start(const char* name)
+//   duration_stop(const char* name, int64_t duration_ns)
+//   duration_overrun(const char* name, int64_t duration_ns, int64_t budget_ns)
+//   frequency(const char* name)
+//   gauge(const char* name, int64_t value_in_thousandths)
+//   value(const char* name, int64_t value_in_thousandths)
+//
+// This header is internal to the library, as the probes are defined in its translation units.
+
+#ifdef ARTI_PROFILING_USDT
+#include <sys/sdt.h>
+
+#define ARTI_PROFILING_PROBE1(name, arg1) DTRACE_PROBE1(arti_profiling, name, arg1)
+#define ARTI_PROFILING_PROBE2(name, arg1, arg2) DTRACE_PROBE2(arti_profiling, name, arg1, arg2)
+#define ARTI_PROFILING_PROBE3(name, arg1, arg2, arg3) DTRACE_PROBE3(arti_profiling, name, arg1, arg2, arg3)
+#else
+#define ARTI_PROFILING_PROBE1(name, arg1) do {} while (false)
+#define ARTI_PROFILING_PROBE2(name, arg1, arg2) do {} while (false)
+#define ARTI_PROFILING_PROBE3(name, arg1, arg2, arg3) do {} while (false)
+#endif
+
+#endif  // ARTI_PROFILING_PROBES_H
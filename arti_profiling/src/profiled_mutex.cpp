@@ -0,0 +1,237 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/profiled_mutex.h>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <ros/console.h>
+#include <sstream>
+
+namespace arti_profiling
+{
+
+namespace
+{
+
+/// Returns the tag of a wait for the given holder. Tags are formatted once per holder and waiting thread, so that
+/// contended acquisitions don't build strings.
+const std::string& getWaitTag(const std::thread::id& holder, const bool shared)
+{
+  static const std::string UNKNOWN_HOLDER_TAGS[2] = {"holder unknown", "shared, holder unknown"};
+  static const std::size_t MAX_CACHED_TAG_COUNT = 64;  // Threads come and go, so the cache must not grow forever
+  thread_local std::map<std::thread::id, std::string> cached_tags[2];
+
+  if (holder == std::thread::id())
+  {
+    return UNKNOWN_HOLDER_TAGS[shared];
+  }
+
+  std::map<std::thread::id, std::string>& tags = cached_tags[shared];
+  std::map<std::thread::id, std::string>::iterator tag = tags.find(holder);
+  if (tag == tags.end())
+  {
+    if (tags.size() >= MAX_CACHED_TAG_COUNT)
+    {
+      tags.clear();
+    }
+    std::ostringstream formatted_tag;
+    formatted_tag << (shared ? "shared, holder " : "holder ") << holder;
+    tag = tags.emplace(holder, formatted_tag.str()).first;
+  }
+  return tag->second;
+}
+
+}  // namespace
+
+const std::size_t LockStatistics::DEFAULT_TOP_WAIT_COUNT = 5;
+
+const LockStatistics::Formatter LockStatistics::DEFAULT_FORMATTER(
+  SimpleDurationFormatter<std::chrono::microseconds>(6));
+
+LockStatistics::LockStatistics(const Formatter& formatter)
+  : formatter_(formatter), hold_min_(std::numeric_limits<Clock::rep>::max()), wait_statistics_(formatter)
+{
+  wait_statistics_.setTopSampleCount(DEFAULT_TOP_WAIT_COUNT);
+  wait_statistics_.setHistogramEnabled(true);
+}
+
+std::shared_ptr<LockStatistics> LockStatistics::getStatistics(Profiler& profiler, const std::string& name)
+{
+  Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<LockStatistics>();
+  }
+
+  std::shared_ptr<LockStatistics> statistics = std::dynamic_pointer_cast<LockStatistics>(profile_update.profile);
+  if (!statistics)
+  {
+    ROS_WARN_NAMED("profiled_mutex", "profiling measurement types do not match");
+    statistics = std::make_shared<LockStatistics>();  // Keep the mutex working, although not reported
+  }
+  return statistics;
+}
+
+void LockStatistics::accumulateAcquisition(const bool shared)
+{
+  acquisition_count_.fetch_add(1, std::memory_order_relaxed);
+  if (shared)
+  {
+    shared_acquisition_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void LockStatistics::accumulateWait(const Clock::duration& wait, const std::thread::id& holder, const bool shared)
+{
+  contended_count_.fetch_add(1, std::memory_order_relaxed);
+  wait_statistics_.accumulate(wait.count(), getWaitTag(holder, shared));
+}
+
+void LockStatistics::accumulateHold(const Clock::duration& hold)
+{
+  hold_count_.fetch_add(1, std::memory_order_relaxed);
+  hold_sum_.fetch_add(hold.count(), std::memory_order_relaxed);
+  updateMinimum(hold_min_, hold.count());
+  updateMaximum(hold_max_, hold.count());
+}
+
+std::uint64_t LockStatistics::getAcquisitionCount() const
+{
+  return acquisition_count_.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LockStatistics::getContendedCount() const
+{
+  return contended_count_.load(std::memory_order_relaxed);
+}
+
+const DurationStatistics& LockStatistics::getWaitStatistics() const
+{
+  return wait_statistics_;
+}
+
+void LockStatistics::print(std::ostream& out) const
+{
+  const std::uint64_t acquisition_count = acquisition_count_.load(std::memory_order_relaxed);
+  if (acquisition_count == 0)
+  {
+    out << "not acquired" << std::endl;
+    return;
+  }
+
+  const std::uint64_t contended_count = contended_count_.load(std::memory_order_relaxed);
+  out << "acquired " << std::setw(6) << acquisition_count << "x";
+  const std::uint64_t shared_acquisition_count = shared_acquisition_count_.load(std::memory_order_relaxed);
+  if (shared_acquisition_count != 0)
+  {
+    out << " (" << shared_acquisition_count << "x shared)";
+  }
+  out << ", contended: " << std::fixed << std::setprecision(1) << std::setw(5)
+      << (100.0 * contended_count / acquisition_count) << "%";
+
+  const std::uint64_t hold_count = hold_count_.load(std::memory_order_relaxed);
+  if (hold_count != 0)
+  {
+    out << ", held min: ";
+    formatter_(out, hold_min_.load(std::memory_order_relaxed));
+    out << ", avg: ";
+    formatter_(out, hold_sum_.load(std::memory_order_relaxed) / static_cast<Clock::rep>(hold_count));
+    out << ", max: ";
+    formatter_(out, hold_max_.load(std::memory_order_relaxed));
+  }
+  out << std::endl;
+}
+
+void LockStatistics::printDetails(std::ostream& out, const int indent) const
+{
+  if (wait_statistics_.getCount() == 0)
+  {
+    return;
+  }
+
+  out << std::setw(indent) << "" << "waits: ";
+  wait_statistics_.print(out);
+  wait_statistics_.printDetails(out, indent + 2);
+}
+
+void LockStatistics::exportTopSamples(std::ostream& out, const std::string& prefix) const
+{
+  wait_statistics_.exportTopSamples(out, prefix);
+}
+
+bool LockStatistics::reset()
+{
+  acquisition_count_ = 0;
+  shared_acquisition_count_ = 0;
+  contended_count_ = 0;
+  hold_count_ = 0;
+  hold_sum_ = 0;
+  hold_min_ = std::numeric_limits<Clock::rep>::max();
+  hold_max_ = 0;
+  wait_statistics_.clear();
+  return true;  // The mutexes keep using this profile, so it has to stay
+}
+
+bool LockStatistics::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  snapshot.type = "lock";
+  snapshot.count = hold_count_.load(std::memory_order_relaxed);
+  if (snapshot.count != 0)
+  {
+    snapshot.sum = SnapshotValue::from(hold_sum_.load(std::memory_order_relaxed));
+    snapshot.min = SnapshotValue::from(hold_min_.load(std::memory_order_relaxed));
+    snapshot.max = SnapshotValue::from(hold_max_.load(std::memory_order_relaxed));
+  }
+  snapshot.counters["acquisitions"] = acquisition_count_.load(std::memory_order_relaxed);
+  snapshot.counters["shared_acquisitions"] = shared_acquisition_count_.load(std::memory_order_relaxed);
+  snapshot.counters["contended"] = contended_count_.load(std::memory_order_relaxed);
+  wait_statistics_.takeSnapshot(snapshot.labels["wait"]);
+  return true;
+}
+
+std::size_t LockStatistics::getMemoryUsage() const
+{
+  return sizeof(*this) - sizeof(DurationStatistics) + wait_statistics_.getMemoryUsage();
+}
+
+void LockStatistics::updateMaximum(std::atomic<Clock::rep>& maximum, const Clock::rep value)
+{
+  Clock::rep current = maximum.load(std::memory_order_relaxed);
+  while (value > current && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+void LockStatistics::updateMinimum(std::atomic<Clock::rep>& minimum, const Clock::rep value)
+{
+  Clock::rep current = minimum.load(std::memory_order_relaxed);
+  while (value < current && !minimum.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+}  // namespace arti_profiling
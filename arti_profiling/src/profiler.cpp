@@ -25,10 +25,22 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <arti_profiling/profiler.h>
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/labeled_statistics.h>
+#include <arti_profiling/overhead.h>
 #include <arti_profiling/profile.h>
+#include <arti_profiling/real_time.h>
+#include <arti_profiling/snapshot.h>
+#include <arti_profiling/top_samples.h>
 #include <algorithm>
+#include <boost/format.hpp>
+#include <chrono>
 #include <iomanip>
+#include <iterator>
+#include <ostream>
+#include <ros/console.h>
 #include <ros/this_node.h>
+#include <sstream>
 #include <utility>
 
 static const std::string HR(79, '-');
@@ -36,6 +48,80 @@ static const std::string HR(79, '-');
 namespace arti_profiling
 {
 
+namespace
+{
+
+/// Returns the total duration measured in the given profile in nanoseconds, or zero if it doesn't measure durations.
+double getMeasuredDuration(const Profile& profile)
+{
+  const LabeledDurationStatistics* labeled = dynamic_cast<const LabeledDurationStatistics*>(&profile);
+  const DurationStatistics* statistics
+    = labeled != nullptr ? labeled->getTotal().get() : dynamic_cast<const DurationStatistics*>(&profile);
+  if (statistics == nullptr)
+  {
+    return 0.0;
+  }
+  const std::size_t count = statistics->getCount();
+  if (count == 0)
+  {
+    return 0.0;
+  }
+  return std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(
+    DurationMeasurement::Clock::duration(statistics->getAverage())).count() * static_cast<double>(count);
+}
+
+/// Counts the updates of new profiles beyond the profile limit, whatever their type. Guarded by the profiler's mutex.
+class OverflowProfile : public Profile
+{
+public:
+  void accumulate()
+  {
+    ++count_;
+  }
+
+  void print(std::ostream& out) const override
+  {
+    out << "performed " << std::setw(6) << count_ << "x (updates of profiles beyond the limit)" << std::endl;
+  }
+
+  bool takeSnapshot(ProfileSnapshot& snapshot) const override
+  {
+    snapshot.type = "overflow";
+    snapshot.count = count_;
+    return true;
+  }
+
+  std::size_t getMemoryUsage() const override
+  {
+    return sizeof(*this);
+  }
+
+  std::size_t getMeasurementCount() const override
+  {
+    return count_;
+  }
+
+protected:
+  std::uint64_t count_{0};
+};
+
+void removeTopSamples(ProfileSnapshot& snapshot)
+{
+  snapshot.top_sample_capacity = 0;
+  snapshot.top_samples.clear();
+  for (auto& label : snapshot.labels)
+  {
+    removeTopSamples(label.second);
+  }
+}
+
+}  // namespace
+
+const std::size_t Profiler::DEFAULT_PROFILE_LIMIT = 1000;
+const std::size_t Profiler::DEFAULT_MEMORY_LIMIT = 16 * 1024 * 1024;
+const std::size_t Profiler::MEMORY_UPDATE_INTERVAL = 64;
+const char* const Profiler::OVERFLOW_PROFILE_NAME = "[overflow]";
+
 Profiler::Profiler() = default;
 
 Profiler::Profiler(std::string name)
@@ -71,26 +157,95 @@ Profiler& Profiler::getRootInstance()
 }
 
 void Profiler::printStatistics(std::ostream& out, const int indent) const
+{
+  // Calibrating on first use takes a few milliseconds, during which the profiler mustn't be locked:
+  getOverheadCalibration();
+  printStatistics(out, indent, std::string(), nullptr);
+}
+
+void Profiler::printStatistics(
+  std::ostream& out, const int indent, const std::string& label_grouping, const ProfilerSnapshot* rollup_snapshot) const
 {
   Lock lock(mutex_);
+  const std::string& grouping = label_grouping_.empty() ? label_grouping : label_grouping_;
+  ProfilerSnapshot own_rollup_snapshot;
+  if (rollup_snapshot == nullptr && rollup_enabled_ && !children_.empty())
+  {
+    takeSnapshot(own_rollup_snapshot);
+    own_rollup_snapshot.computeRollUp();
+    rollup_snapshot = &own_rollup_snapshot;
+  }
+
   if (parent_ == nullptr && indent <= 0)
   {
     out << HR << std::endl;
-    out << "Profiling statistics of " << ros::this_node::getName() << " node:" << std::endl;
+    out << "Profiling statistics of " << ros::this_node::getName() << " node ("
+        << (getMemoryUsage() + 1023) / 1024 << " KiB used for profiling):" << std::endl;
+    const std::uint64_t real_time_violation_count = getRealTimeViolationCount();
+    if (real_time_violation_count > 0)
+    {
+      out << "  " << real_time_violation_count << " real-time violations, last by " << getLastRealTimeViolation()
+          << std::endl;
+    }
+    const OverheadCalibration& calibration = getOverheadCalibration();
+    const std::size_t measurement_count = getMeasurementCount();
+    out << "  estimated profiling overhead: "
+        << boost::format("%.3fms in %u measurements (clock read: %.0fns, lock: %.0fns, commit: %.0fns)")
+           % (static_cast<double>(measurement_count) * calibration.getMeasurementCost() * 1e-6) % measurement_count
+           % calibration.clock_read % calibration.lock % calibration.commit;
+    if (isOverheadCompensationEnabled())
+    {
+      out << ", clock read subtracted from durations";
+    }
+    out << std::endl;
   }
   else
   {
     out << std::setw(indent + 2) << std::right << "- " << name_ << ":" << std::endl;
   }
+  if (evicted_count_ > 0 || overflow_count_ > 0)
+  {
+    out << std::setw(indent + 2 + 2) << "" << "profile limit reached (" << profiles_.size() << " profiles, "
+        << (getOwnMemoryUsage() + 1023) / 1024 << " KiB): " << evicted_count_ << " profiles evicted, "
+        << overflow_count_ << " updates of new profiles counted in " << OVERFLOW_PROFILE_NAME << std::endl;
+  }
   for (const auto& profile : profiles_)
   {
+    if (!profile.second.profile)
+    {
+      continue;
+    }
+
     out << std::setw(indent + 2 + 2) << std::right << "- " << profile.first
         << std::setw(30 - std::min(30, static_cast<int>(profile.first.size())) + 2) << std::left << ": " << std::right;
-    profile.second->print(out);
+    profile.second.profile->print(out);
+
+    const LabeledProfile* labeled_profile
+      = grouping.empty() ? nullptr : dynamic_cast<const LabeledProfile*>(profile.second.profile.get());
+    if (labeled_profile != nullptr)
+    {
+      labeled_profile->printGroupedBy(out, indent + 2 + 2 + 2, grouping);
+    }
+    else
+    {
+      profile.second.profile->printDetails(out, indent + 2 + 2 + 2);
+    }
+    printOverhead(out, indent + 2 + 2 + 2, *profile.second.profile);
   }
-  for (Profiler* child : children_)
+  if (rollup_snapshot != nullptr)
+  {
+    printRollUp(out, indent, *rollup_snapshot);
+  }
+  for (std::size_t i = 0; i < children_.size(); ++i)
   {
-    child->printStatistics(out, indent + 2);
+    // Children added after the snapshot was taken have no roll-up yet:
+    const ProfilerSnapshot* child_rollup_snapshot = nullptr;
+    if (rollup_snapshot != nullptr && i < rollup_snapshot->children.size()
+        && rollup_snapshot->children[i].name == children_[i]->name_)
+    {
+      child_rollup_snapshot = &rollup_snapshot->children[i];
+    }
+    children_[i]->printStatistics(out, indent + 2, grouping, child_rollup_snapshot);
   }
   if (parent_ == nullptr)
   {
@@ -98,14 +253,216 @@ void Profiler::printStatistics(std::ostream& out, const int indent) const
   }
 }
 
+void Profiler::printRollUp(std::ostream& out, const int indent, const ProfilerSnapshot& snapshot) const
+{
+  for (const auto& profile : snapshot.rollup)
+  {
+    // Only profiles that also occur below this profiler have a roll-up that differs from the profile itself:
+    const bool in_children = std::any_of(
+      snapshot.children.begin(), snapshot.children.end(),
+      [&](const ProfilerSnapshot& child) { return child.rollup.count(profile.first) > 0; });
+    if (!in_children)
+    {
+      continue;
+    }
+
+    const std::string label = profile.first + " (total)";
+    out << std::setw(indent + 2 + 2) << std::right << "- " << label
+        << std::setw(30 - std::min(30, static_cast<int>(label.size())) + 2) << std::left << ": " << std::right;
+    printSnapshot(out, profile.second);
+  }
+}
+
+void Profiler::exportTopSamples(std::ostream& out) const
+{
+  out << "profiler,profile,value,time,thread,tag\n";
+  exportTopSamples(out, std::string());
+}
+
+void Profiler::exportTopSamples(std::ostream& out, const std::string& path) const
+{
+  Lock lock(mutex_);
+  for (const auto& profile : profiles_)
+  {
+    std::ostringstream prefix;
+    TopSamples<int>::writeCsvField(prefix, path);
+    prefix << ',';
+    TopSamples<int>::writeCsvField(prefix, profile.first);
+    prefix << ',';
+    if (profile.second.profile)
+    {
+      profile.second.profile->exportTopSamples(out, prefix.str());
+    }
+  }
+  for (const Profiler* child : children_)
+  {
+    child->exportTopSamples(out, path.empty() ? child->name_ : path + "/" + child->name_);
+  }
+}
+
+ProfilerSnapshot Profiler::takeSnapshot() const
+{
+  ProfilerSnapshot snapshot;
+  takeSnapshot(snapshot);
+  if (parent_ == nullptr && snapshot.name.empty())
+  {
+    snapshot.name = ros::this_node::getName();
+  }
+  snapshot.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count();
+  return snapshot;
+}
+
+bool Profiler::takeSnapshot(const std::string& path, ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+  const Profiler* child = findChild(path);
+  if (child != nullptr)
+  {
+    return child->takeSnapshot(path.substr(child->name_.size() + 1), snapshot);
+  }
+
+  const auto it = profiles_.find(path);
+  return it != profiles_.end() && it->second.profile && it->second.profile->takeSnapshot(snapshot);
+}
+
+void Profiler::takeSnapshot(ProfilerSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+  snapshot.name = name_;
+  for (const auto& profile : profiles_)
+  {
+    ProfileSnapshot profile_snapshot;
+    if (profile.second.profile && profile.second.profile->takeSnapshot(profile_snapshot))
+    {
+      snapshot.profiles.emplace(profile.first, std::move(profile_snapshot));
+    }
+  }
+  snapshot.children.resize(children_.size());
+  for (std::size_t i = 0; i < children_.size(); ++i)
+  {
+    children_[i]->takeSnapshot(snapshot.children[i]);
+  }
+}
+
 void Profiler::clear()
+{
+  // All profilers in the tree use the same time, so that their histories can be assembled to snapshots of the tree:
+  clear(0, std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+void Profiler::clear(const std::size_t inherited_history_capacity, const std::int64_t time)
 {
   Lock lock(mutex_);
+  const std::size_t history_capacity = history_capacity_ != 0 ? history_capacity_ : inherited_history_capacity;
   for (Profiler* child : children_)
   {
-    child->clear();
+    child->clear(history_capacity, time);
+  }
+  recordHistory(history_capacity, time);
+  evicted_count_ = 0;
+  overflow_count_ = 0;
+  misses_until_memory_update_ = 0;
+  new_entry_ = profiles_.end();
+  for (auto it = profiles_.begin(); it != profiles_.end();)
+  {
+    if (it->second.profile && it->second.profile->reset())
+    {
+      ++it;
+    }
+    else
+    {
+      it = profiles_.erase(it);
+    }
   }
-  profiles_.clear();
+}
+
+void Profiler::recordHistory(const std::size_t capacity, const std::int64_t time)
+{
+  if (capacity > 0)
+  {
+    ProfilerSnapshot snapshot;
+    snapshot.name = parent_ == nullptr && name_.empty() ? ros::this_node::getName() : name_;
+    snapshot.time = time;
+    for (const auto& profile : profiles_)
+    {
+      ProfileSnapshot profile_snapshot;
+      if (profile.second.profile && profile.second.profile->takeSnapshot(profile_snapshot))
+      {
+        removeTopSamples(profile_snapshot);
+        snapshot.profiles.emplace(profile.first, std::move(profile_snapshot));
+      }
+    }
+    history_memory_usage_ += snapshot.getMemoryUsage();
+    history_.push_back(std::move(snapshot));
+  }
+  while (history_.size() > capacity)
+  {
+    history_memory_usage_ -= history_.front().getMemoryUsage();
+    history_.pop_front();
+  }
+}
+
+void Profiler::setHistoryCapacity(const std::size_t capacity)
+{
+  Lock lock(mutex_);
+  history_capacity_ = capacity;
+}
+
+std::vector<ProfilerSnapshot> Profiler::getHistory(const std::string& path) const
+{
+  Lock lock(mutex_);
+  if (path.empty())
+  {
+    return std::vector<ProfilerSnapshot>(history_.begin(), history_.end());
+  }
+
+  const Profiler* child = findChild(path + "/");
+  if (child == nullptr)
+  {
+    return {};
+  }
+  return child->getHistory(path.substr(std::min(child->name_.size() + 1, path.size())));
+}
+
+const Profiler* Profiler::findChild(const std::string& path) const
+{
+  // Child names may contain '/' themselves, like those of topic profilers, so the longest matching name is taken:
+  const Profiler* result = nullptr;
+  for (const Profiler* child : children_)
+  {
+    const std::string& name = child->name_;
+    if (path.size() > name.size() && path.compare(0, name.size(), name) == 0 && path[name.size()] == '/'
+        && (result == nullptr || name.size() > result->name_.size()))
+    {
+      result = child;
+    }
+  }
+  return result;
+}
+
+bool Profiler::getHistoricSnapshot(const std::int64_t time, ProfilerSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+  const auto it = std::upper_bound(
+    history_.begin(), history_.end(), time,
+    [](const std::int64_t t, const ProfilerSnapshot& interval) { return t < interval.time; });
+  if (it == history_.begin())
+  {
+    return false;
+  }
+
+  snapshot = *std::prev(it);
+  for (const Profiler* child : children_)
+  {
+    ProfilerSnapshot child_snapshot;
+    if (child->getHistoricSnapshot(time, child_snapshot))
+    {
+      snapshot.children.push_back(std::move(child_snapshot));
+    }
+  }
+  return true;
 }
 
 bool Profiler::hasChildren() const
@@ -114,14 +471,236 @@ bool Profiler::hasChildren() const
   return !children_.empty();
 }
 
+std::size_t Profiler::getLabelCardinalityLimit() const
+{
+  Lock lock(mutex_);
+  return label_cardinality_limit_;
+}
+
+void Profiler::setLabelCardinalityLimit(const std::size_t limit)
+{
+  Lock lock(mutex_);
+  label_cardinality_limit_ = limit;
+}
+
+void Profiler::setLabelGrouping(std::string key)
+{
+  Lock lock(mutex_);
+  label_grouping_ = std::move(key);
+}
+
+void Profiler::setRollUpEnabled(const bool enabled)
+{
+  Lock lock(mutex_);
+  rollup_enabled_ = enabled;
+}
+
+void Profiler::setProfileLimit(const std::size_t limit)
+{
+  Lock lock(mutex_);
+  profile_limit_ = limit;
+}
+
+void Profiler::setMemoryLimit(const std::size_t limit)
+{
+  Lock lock(mutex_);
+  memory_limit_ = limit;
+  misses_until_memory_update_ = 0;
+}
+
+void Profiler::setLimitPolicy(const LimitPolicy policy)
+{
+  Lock lock(mutex_);
+  limit_policy_ = policy;
+}
+
+std::size_t Profiler::getMemoryUsage() const
+{
+  Lock lock(mutex_);
+  // A deque stores its elements in blocks; the unused part of them is neglected:
+  std::size_t result = getOwnMemoryUsage() + history_memory_usage_;
+  for (const Profiler* child : children_)
+  {
+    result += child->getMemoryUsage();
+  }
+  return result;
+}
+
 Profiler::ProfileUpdate Profiler::getProfile(const std::string& name)
 {
+  // Profiles may be allocated here, and the lock is prone to priority inversion; real-time threads must use
+  // preallocated profiles like RealTimeDurationProfile instead:
+  checkRealTimeViolation("Profiler::getProfile");
+
   Lock lock(mutex_);
-  ProfileUpdate update(profiles_[name], mutex_);
+  ProfileEntries::iterator entry = profiles_.find(name);
+  if (entry == profiles_.end())
+  {
+    while (entry == profiles_.end() && isLimitReached())
+    {
+      if (limit_policy_ == LimitPolicy::EVICT_COLDEST && evictColdestProfile())
+      {
+        continue;
+      }
+
+      // Nothing can be evicted, so fall back to the overflow bucket:
+      if (overflow_count_++ == 0)
+      {
+        ROS_WARN_NAMED("profiler", "profile limit of profiler '%s' reached, counting new profiles in '%s'",
+                       name_.c_str(), OVERFLOW_PROFILE_NAME);
+      }
+      const std::pair<ProfileEntries::iterator, bool> overflow
+        = profiles_.emplace(OVERFLOW_PROFILE_NAME, ProfileEntry());
+      if (overflow.second)
+      {
+        overflow.first->second.profile = std::make_shared<OverflowProfile>();
+        addToMemoryEstimate(overflow.first);
+      }
+      overflow.first->second.last_use = ++use_count_;
+      OverflowProfile* const overflow_profile = dynamic_cast<OverflowProfile*>(overflow.first->second.profile.get());
+      if (overflow_profile != nullptr)  // Unless a profile was explicitly given that name
+      {
+        overflow_profile->accumulate();
+      }
+
+      // Profiles of any type overflow, so the caller updates a profile of its own, which is not kept:
+      overflow_scratch_.reset();
+      return ProfileUpdate(overflow_scratch_, mutex_);
+    }
+    if (entry == profiles_.end())
+    {
+      entry = profiles_.emplace(name, ProfileEntry()).first;
+      addToMemoryEstimate(entry);
+    }
+  }
+  entry->second.last_use = ++use_count_;
+  ProfileUpdate update(entry->second.profile, mutex_);
 
   return update;
 }
 
+std::size_t Profiler::getMeasurementCount() const
+{
+  Lock lock(mutex_);
+  std::size_t result = 0;
+  for (const auto& profile : profiles_)
+  {
+    if (profile.second.profile)
+    {
+      result += profile.second.profile->getMeasurementCount();
+    }
+  }
+  for (const Profiler* child : children_)
+  {
+    result += child->getMeasurementCount();
+  }
+  return result;
+}
+
+void Profiler::printOverhead(std::ostream& out, const int indent, const Profile& profile)
+{
+  // Only mention the overhead where it noticeably distorts the measured durations, to keep the output short:
+  static const double SIGNIFICANT_SHARE = 0.01;
+
+  const double measured_duration = getMeasuredDuration(profile);
+  if (measured_duration <= 0.0)
+  {
+    return;
+  }
+  const double cost = getOverheadCalibration().getMeasurementCost();
+  const double overhead = static_cast<double>(profile.getMeasurementCount()) * cost;
+  if (overhead >= SIGNIFICANT_SHARE * measured_duration)
+  {
+    out << std::setw(indent) << "" << "profiling overhead: "
+        << boost::format("%.0fns per measurement, %.1f%% of measured time") % cost
+           % (100.0 * overhead / measured_duration) << std::endl;
+  }
+}
+
+std::size_t Profiler::getOwnMemoryUsage() const
+{
+  std::size_t result = sizeof(*this) + name_.capacity() + label_grouping_.capacity()
+    + children_.capacity() * sizeof(Profiler*);
+  for (const auto& profile : profiles_)
+  {
+    result += getMemoryUsage(profile);
+  }
+  return result;
+}
+
+std::size_t Profiler::getMemoryUsage(const ProfileEntries::value_type& entry)
+{
+  // A map node holds about four pointers besides the value, a shared_ptr's control block about two more:
+  std::size_t result = 4 * sizeof(void*) + sizeof(entry) + entry.first.capacity();
+  if (entry.second.profile)
+  {
+    result += 2 * sizeof(void*) + entry.second.profile->getMemoryUsage();
+  }
+  return result;
+}
+
+void Profiler::addToMemoryEstimate(const ProfileEntries::iterator& entry)
+{
+  new_entry_ = entry;
+  new_entry_memory_usage_ = getMemoryUsage(*entry);
+  memory_estimate_ += new_entry_memory_usage_;
+}
+
+bool Profiler::isLimitReached()
+{
+  // By now, the caller of the previous getProfile() has created the profile of the entry added by it:
+  if (new_entry_ != profiles_.end())
+  {
+    memory_estimate_ += std::max(getMemoryUsage(*new_entry_), new_entry_memory_usage_) - new_entry_memory_usage_;
+    new_entry_ = profiles_.end();
+  }
+
+  if (profile_limit_ != 0 && profiles_.size() >= profile_limit_)
+  {
+    return true;
+  }
+  if (memory_limit_ == 0)
+  {
+    return false;
+  }
+
+  // Profiles grow after they have been created, which only a full update of the estimate takes into account:
+  if (misses_until_memory_update_ == 0)
+  {
+    memory_estimate_ = getOwnMemoryUsage();
+    misses_until_memory_update_ = MEMORY_UPDATE_INTERVAL;
+  }
+  --misses_until_memory_update_;
+  return memory_estimate_ >= memory_limit_;
+}
+
+bool Profiler::evictColdestProfile()
+{
+  // Profiles still referenced elsewhere (e.g. by a ProfiledMutex) would neither be freed nor be recreated, so they stay:
+  ProfileEntries::iterator coldest = profiles_.end();
+  for (ProfileEntries::iterator it = profiles_.begin(); it != profiles_.end(); ++it)
+  {
+    if (it->first != OVERFLOW_PROFILE_NAME && it->second.profile.use_count() <= 1
+        && (coldest == profiles_.end() || it->second.last_use < coldest->second.last_use))
+    {
+      coldest = it;
+    }
+  }
+  if (coldest == profiles_.end())
+  {
+    return false;
+  }
+
+  if (evicted_count_++ == 0)
+  {
+    ROS_WARN_NAMED("profiler", "profile limit of profiler '%s' reached, evicting least recently used profiles",
+                   name_.c_str());
+  }
+  memory_estimate_ -= std::min(memory_estimate_, getMemoryUsage(*coldest));
+  profiles_.erase(coldest);
+  return true;
+}
+
 void Profiler::addChild(Profiler* child)
 {
   Lock lock(mutex_);
@@ -0,0 +1,273 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/profiling_diagnostics.h>
+#include <algorithm>
+#include <boost/algorithm/string/join.hpp>
+#include <boost/format.hpp>
+#include <diagnostic_msgs/DiagnosticStatus.h>
+#include <ros/console.h>
+#include <utility>
+
+namespace arti_profiling
+{
+
+namespace
+{
+
+double getDouble(XmlRpc::XmlRpcValue& entry, const std::string& key)
+{
+  if (!entry.hasMember(key))
+  {
+    return 0.0;
+  }
+  XmlRpc::XmlRpcValue& value = entry[key];
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+  {
+    return static_cast<int>(value);
+  }
+  if (value.getType() == XmlRpc::XmlRpcValue::TypeDouble)
+  {
+    return static_cast<double>(value);
+  }
+  ROS_ERROR_STREAM_NAMED("profiling_diagnostics", "profiling diagnostics threshold " << key << " must be a number");
+  return 0.0;
+}
+
+/// Raises the level of the status to the higher one of the given levels whose threshold is exceeded, if any.
+void check(
+  unsigned char& level, std::vector<std::string>& problems, const bool error, const bool warning,
+  const std::string& problem)
+{
+  if (error)
+  {
+    level = std::max(level, static_cast<unsigned char>(diagnostic_msgs::DiagnosticStatus::ERROR));
+    problems.push_back(problem);
+  }
+  else if (warning)
+  {
+    level = std::max(level, static_cast<unsigned char>(diagnostic_msgs::DiagnosticStatus::WARN));
+    problems.push_back(problem);
+  }
+}
+
+}  // namespace
+
+ProfilingDiagnostics::ProfilingDiagnostics(
+  Profiler& profiler, diagnostic_updater::Updater& updater, const ros::NodeHandle& node_handle)
+  : profiler_(&profiler), updater_(&updater)
+{
+  loadParameters(node_handle);
+}
+
+ProfilingDiagnostics::~ProfilingDiagnostics()
+{
+  for (const std::unique_ptr<Task>& task : tasks_)
+  {
+    updater_->removeByName(task->name);
+  }
+}
+
+void ProfilingDiagnostics::addProfile(const std::string& path, const DiagnosticThresholds& thresholds)
+{
+  std::unique_ptr<Task> task(new Task);
+  task->name = "profiling " + path;
+  task->path = path;
+  task->thresholds = thresholds;
+  task->found = profiler_->takeSnapshot(path, task->previous);
+  task->previous_time = Clock::now();
+
+  Task* const task_pointer = task.get();
+  tasks_.push_back(std::move(task));
+  updater_->add(task_pointer->name, [this, task_pointer](diagnostic_updater::DiagnosticStatusWrapper& status)
+  {
+    evaluate(*task_pointer, status);
+  });
+}
+
+void ProfilingDiagnostics::loadParameters(const ros::NodeHandle& node_handle)
+{
+  XmlRpc::XmlRpcValue profiles;
+  if (!node_handle.getParam("diagnostics", profiles))
+  {
+    return;
+  }
+  if (profiles.getType() != XmlRpc::XmlRpcValue::TypeArray)
+  {
+    ROS_ERROR_NAMED("profiling_diagnostics", "parameter %s must be a list",
+                    node_handle.resolveName("diagnostics").c_str());
+    return;
+  }
+
+  for (int i = 0; i < profiles.size(); ++i)
+  {
+    XmlRpc::XmlRpcValue& entry = profiles[i];
+    if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct || !entry.hasMember("profile")
+        || entry["profile"].getType() != XmlRpc::XmlRpcValue::TypeString)
+    {
+      ROS_ERROR_NAMED("profiling_diagnostics", "entry %d of parameter %s has no profile name", i,
+                      node_handle.resolveName("diagnostics").c_str());
+      continue;
+    }
+
+    DiagnosticThresholds thresholds;
+    thresholds.min_frequency_warn = getDouble(entry, "min_frequency_warn");
+    thresholds.min_frequency_error = getDouble(entry, "min_frequency_error");
+    thresholds.max_p99_duration_warn = getDouble(entry, "max_p99_duration_warn");
+    thresholds.max_p99_duration_error = getDouble(entry, "max_p99_duration_error");
+    thresholds.overrun_count_warn = static_cast<std::uint64_t>(getDouble(entry, "overrun_count_warn"));
+    thresholds.overrun_count_error = static_cast<std::uint64_t>(getDouble(entry, "overrun_count_error"));
+    addProfile(static_cast<std::string>(entry["profile"]), thresholds);
+  }
+}
+
+void ProfilingDiagnostics::evaluate(Task& task, diagnostic_updater::DiagnosticStatusWrapper& status)
+{
+  const Clock::time_point time = Clock::now();
+  const DiagnosticThresholds& thresholds = task.thresholds;
+  ProfileSnapshot current;
+  // Profiles without measurements may not exist, e.g. frequency profiles after a reset:
+  task.found = profiler_->takeSnapshot(task.path, current) || task.found;
+  if (!task.found)
+  {
+    // Either nothing has been measured yet, or the path is wrong; evaluating an empty snapshot wouldn't tell:
+    task.previous_time = time;
+    unsigned char level = diagnostic_msgs::DiagnosticStatus::WARN;
+    std::vector<std::string> problems(1, "profile " + task.path + " not found");
+    check(level, problems, thresholds.min_frequency_error > 0.0, false, "no measurements");
+    status.summary(level, boost::algorithm::join(problems, ", "));
+    return;
+  }
+
+  const bool removed_by_reset = current.count == 0 && isReset(task.previous, current);
+  const ProfileSnapshot window = computeWindow(task.previous, current);
+  const double window_duration = std::chrono::duration_cast<std::chrono::duration<double>>(
+    time - task.previous_time).count();
+  task.previous = std::move(current);
+  task.previous_time = time;
+
+  unsigned char level = diagnostic_msgs::DiagnosticStatus::OK;
+  std::vector<std::string> problems;
+  status.add("measurements", window.count);
+
+  double frequency = 0.0;
+  if (window.type == "frequency")
+  {
+    frequency = window.count > 0 ? window.sum.toDouble() / static_cast<double>(window.count) : 0.0;
+  }
+  else if (window_duration > 0.0)
+  {
+    frequency = static_cast<double>(window.count) / window_duration;
+  }
+  // Right after a reset, the profile may not have been recreated yet even if the measurements continue:
+  if (!removed_by_reset)
+  {
+    status.addf("frequency", "%.1fHz", frequency);
+    check(level, problems, frequency < thresholds.min_frequency_error, frequency < thresholds.min_frequency_warn,
+          (boost::format("frequency %.1fHz too low") % frequency).str());
+  }
+
+  const bool has_duration_thresholds
+    = thresholds.max_p99_duration_warn > 0.0 || thresholds.max_p99_duration_error > 0.0;
+  if (window.count > 0 && !window.histogram.empty() && (isDurationType(window.type) || has_duration_thresholds))
+  {
+    const double duration = window.histogram.getQuantile(0.99) * 1e-9;
+    status.addf("p99 duration", "%.3fms", duration * 1e3);
+    check(level, problems,
+          thresholds.max_p99_duration_error > 0.0 && duration > thresholds.max_p99_duration_error,
+          thresholds.max_p99_duration_warn > 0.0 && duration > thresholds.max_p99_duration_warn,
+          (boost::format("p99 duration %.3fms too high") % (duration * 1e3)).str());
+  }
+  else if (window.count > 0 && (isDurationType(window.type) || has_duration_thresholds))
+  {
+    // The sum, and thus the average, is the only duration statistic that can be computed for the window:
+    status.addf("avg duration", "%.3fms", window.getAverage() * 1e-6);
+    check(level, problems, false, has_duration_thresholds, "p99 duration threshold requires a histogram");
+  }
+
+  status.add("overruns", window.overrun_count);
+  check(level, problems,
+        thresholds.overrun_count_error > 0 && window.overrun_count >= thresholds.overrun_count_error,
+        thresholds.overrun_count_warn > 0 && window.overrun_count >= thresholds.overrun_count_warn,
+        std::to_string(window.overrun_count) + " overruns");
+
+  status.summary(level, problems.empty() ? "OK" : boost::algorithm::join(problems, ", "));
+}
+
+ProfileSnapshot ProfilingDiagnostics::computeWindow(const ProfileSnapshot& previous, const ProfileSnapshot& current)
+{
+  if (isReset(previous, current))
+  {
+    return current;
+  }
+
+  // Minimum and maximum cannot be subtracted, so the window keeps those of the whole interval:
+  ProfileSnapshot window = current;
+  window.count -= previous.count;
+  if (window.sum.integral)
+  {
+    window.sum.integer -= previous.sum.integer;
+  }
+  else
+  {
+    window.sum.real -= previous.sum.toDouble();
+  }
+  window.overrun_count -= previous.overrun_count;
+  for (const auto& bucket : previous.histogram.getBuckets())
+  {
+    const auto it = current.histogram.getBuckets().find(bucket.first);
+    window.histogram.setBucketCount(bucket.first, it->second - bucket.second);
+  }
+  window.top_samples.clear();
+  window.labels.clear();
+  return window;
+}
+
+bool ProfilingDiagnostics::isReset(const ProfileSnapshot& previous, const ProfileSnapshot& current)
+{
+  // A reset cannot be detected directly, but it undoes the monotonic growth of counts and extrema, unless the new
+  // interval has already caught up with all of them:
+  if (previous.count == 0)
+  {
+    return false;
+  }
+  if (current.type != previous.type || current.count < previous.count || current.overrun_count < previous.overrun_count
+      || previous.min < current.min || current.max < previous.max)
+  {
+    return true;
+  }
+  for (const auto& bucket : previous.histogram.getBuckets())
+  {
+    const auto it = current.histogram.getBuckets().find(bucket.first);
+    if (it == current.histogram.getBuckets().end() || it->second < bucket.second)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace arti_profiling
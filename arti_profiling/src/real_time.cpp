@@ -0,0 +1,311 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/real_time.h>
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <pthread.h>
+#include <ros/console.h>
+#include <sched.h>
+#include <thread>
+
+namespace arti_profiling
+{
+
+namespace
+{
+
+enum class RealTimeState
+{
+  UNKNOWN, REAL_TIME, NOT_REAL_TIME
+};
+
+thread_local RealTimeState real_time_state = RealTimeState::UNKNOWN;
+
+std::atomic<std::uint64_t> real_time_violation_count{0};
+std::atomic<const char*> last_real_time_violation{nullptr};
+
+}  // namespace
+
+void setRealTimeThread(const bool real_time)
+{
+  real_time_state = real_time ? RealTimeState::REAL_TIME : RealTimeState::NOT_REAL_TIME;
+}
+
+bool isRealTimeThread()
+{
+  if (real_time_state == RealTimeState::UNKNOWN)
+  {
+    int policy = SCHED_OTHER;
+    sched_param parameters{};
+    const bool real_time = pthread_getschedparam(pthread_self(), &policy, &parameters) == 0
+      && (policy == SCHED_FIFO || policy == SCHED_RR);
+    real_time_state = real_time ? RealTimeState::REAL_TIME : RealTimeState::NOT_REAL_TIME;
+  }
+  return real_time_state == RealTimeState::REAL_TIME;
+}
+
+bool checkRealTimeViolation(const char* operation)
+{
+  if (!isRealTimeThread())
+  {
+    return false;
+  }
+
+  // No logging here, as that would be a violation itself; the count is printed with the statistics:
+  real_time_violation_count.fetch_add(1, std::memory_order_relaxed);
+  last_real_time_violation.store(operation, std::memory_order_relaxed);
+  return true;
+}
+
+std::uint64_t getRealTimeViolationCount()
+{
+  return real_time_violation_count.load(std::memory_order_relaxed);
+}
+
+const char* getLastRealTimeViolation()
+{
+  return last_real_time_violation.load(std::memory_order_relaxed);
+}
+
+const RealTimeDurationProfile::Clock::duration RealTimeDurationProfile::MAX_HISTOGRAM_DURATION
+  = std::chrono::hours(1);
+
+RealTimeDurationProfile::RealTimeDurationProfile(const Formatter& formatter)
+  : first_bucket_index_(Histogram::getBucketIndex(1.0)),
+    bucket_count_(Histogram::getBucketIndex(static_cast<double>(MAX_HISTOGRAM_DURATION.count()))
+                  - first_bucket_index_ + 2),  // Plus the bucket for zero
+    statistics_(formatter)
+{
+  buckets_.reset(new std::atomic<std::uint64_t>[bucket_count_]);
+  for (std::size_t i = 0; i < bucket_count_; ++i)
+  {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+  pulled_buckets_.resize(bucket_count_, 0);
+  current_buckets_.resize(bucket_count_, 0);
+  statistics_.setHistogramEnabled(true);
+}
+
+void RealTimeDurationProfile::commit(const Clock::duration& measurement) noexcept
+{
+  // A single compare-and-swap claims the buffer; if another thread holds it, the measurement is dropped instead of
+  // waiting, which keeps this wait-free:
+  std::uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+  if ((sequence & 1) != 0 || !sequence_.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed))
+  {
+    dropped_count_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const Clock::rep value = measurement.count();
+  const std::uint64_t reset_requested = reset_requested_.load(std::memory_order_relaxed);
+  if (reset_acknowledged_.load(std::memory_order_relaxed) != reset_requested
+      || count_.load(std::memory_order_relaxed) == 0)
+  {
+    min_.store(value, std::memory_order_relaxed);
+    max_.store(value, std::memory_order_relaxed);
+    reset_acknowledged_.store(reset_requested, std::memory_order_relaxed);
+  }
+  else
+  {
+    // Only this thread writes these, so neither read-modify-write operations nor loops are needed:
+    min_.store(std::min(min_.load(std::memory_order_relaxed), value), std::memory_order_relaxed);
+    max_.store(std::max(max_.load(std::memory_order_relaxed), value), std::memory_order_relaxed);
+  }
+  count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  sum_.store(sum_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  std::atomic<std::uint64_t>& bucket = buckets_[getBucketOffset(value)];
+  bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+  sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+std::uint64_t RealTimeDurationProfile::getDroppedCount() const
+{
+  return dropped_count_.load(std::memory_order_relaxed);
+}
+
+void RealTimeDurationProfile::print(std::ostream& out) const
+{
+  Lock lock(pull_mutex_);
+  pull();
+  statistics_.print(out);
+}
+
+void RealTimeDurationProfile::printDetails(std::ostream& out, const int indent) const
+{
+  const std::uint64_t dropped_count = getDroppedCount();
+  if (dropped_count > 0)
+  {
+    out << std::setw(indent) << "" << dropped_count << " measurements dropped, as they were committed concurrently"
+        << std::endl;
+  }
+}
+
+bool RealTimeDurationProfile::reset()
+{
+  Lock lock(pull_mutex_);
+  pull();
+  statistics_.clear();
+  reset_requested_.fetch_add(1, std::memory_order_relaxed);
+  return true;  // Measurements hold on to this profile, and it must not be recreated by them
+}
+
+bool RealTimeDurationProfile::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(pull_mutex_);
+  pull();
+  statistics_.takeSnapshot(snapshot);
+  snapshot.counters["dropped"] = getDroppedCount();
+  return true;
+}
+
+std::size_t RealTimeDurationProfile::getMemoryUsage() const
+{
+  return sizeof(*this) - sizeof(DurationStatistics) + statistics_.getMemoryUsage()
+    + bucket_count_ * (sizeof(std::atomic<std::uint64_t>) + 2 * sizeof(std::uint64_t));
+}
+
+void RealTimeDurationProfile::pull() const
+{
+  std::uint64_t count;
+  Clock::rep sum;
+  Clock::rep min;
+  Clock::rep max;
+  std::uint64_t reset_acknowledged;
+  while (true)
+  {
+    const std::uint64_t sequence = sequence_.load(std::memory_order_acquire);
+    if ((sequence & 1) != 0)
+    {
+      std::this_thread::yield();  // A commit is in progress
+      continue;
+    }
+
+    count = count_.load(std::memory_order_relaxed);
+    sum = sum_.load(std::memory_order_relaxed);
+    min = min_.load(std::memory_order_relaxed);
+    max = max_.load(std::memory_order_relaxed);
+    reset_acknowledged = reset_acknowledged_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < bucket_count_; ++i)
+    {
+      current_buckets_[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) == sequence)
+    {
+      break;
+    }
+  }
+
+  if (count == pulled_count_)
+  {
+    return;
+  }
+
+  Histogram histogram;
+  double histogram_min = std::numeric_limits<double>::max();
+  double histogram_max = 0.0;
+  for (std::size_t i = 0; i < bucket_count_; ++i)
+  {
+    if (current_buckets_[i] != pulled_buckets_[i])
+    {
+      const std::int32_t index = i == 0 ? 0 : first_bucket_index_ + static_cast<std::int32_t>(i) - 1;
+      histogram.setBucketCount(index, current_buckets_[i] - pulled_buckets_[i]);
+      histogram_min = std::min(histogram_min, Histogram::getBucketLowerBound(index));
+      histogram_max = std::max(histogram_max, Histogram::getBucketUpperBound(index));
+      pulled_buckets_[i] = current_buckets_[i];
+    }
+  }
+
+  // The extremes are the ones since the last reset, unless no commit happened since; then, fall back to the bounds of
+  // the histogram buckets:
+  if (reset_acknowledged != reset_requested_.load(std::memory_order_relaxed))
+  {
+    min = static_cast<Clock::rep>(histogram_min);
+    max = static_cast<Clock::rep>(histogram_max);
+  }
+  statistics_.accumulateAggregate(count - pulled_count_, sum - pulled_sum_, min, max, &histogram);
+  pulled_count_ = count;
+  pulled_sum_ = sum;
+}
+
+std::size_t RealTimeDurationProfile::getBucketOffset(const Clock::rep value) const noexcept
+{
+  if (value <= 0)
+  {
+    return 0;
+  }
+  const std::int32_t index = Histogram::getBucketIndex(static_cast<double>(value));
+  return std::min(static_cast<std::size_t>(std::max(index - first_bucket_index_ + 1, 1)), bucket_count_ - 1);
+}
+
+RealTimeDurationMeasurement::RealTimeDurationMeasurement(
+  Profiler& profiler, const std::string& name, const RealTimeDurationProfile::Formatter& formatter)
+{
+  Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<RealTimeDurationProfile>(formatter);
+  }
+
+  profile_ = std::dynamic_pointer_cast<RealTimeDurationProfile>(profile_update.profile);
+  if (!profile_)
+  {
+    ROS_WARN_NAMED("real_time", "profiling measurement types do not match");
+    profile_ = std::make_shared<RealTimeDurationProfile>(formatter);  // Keep measuring, although not reported
+  }
+}
+
+void RealTimeDurationMeasurement::start(const Clock::time_point& start_time) noexcept
+{
+  start_time_ = start_time;
+}
+
+void RealTimeDurationMeasurement::stop(const Clock::time_point& stop_time) noexcept
+{
+  if (start_time_ != DurationMeasurement::NEVER)
+  {
+    profile_->commit(stop_time - start_time_);
+    start_time_ = DurationMeasurement::NEVER;
+  }
+}
+
+void RealTimeDurationMeasurement::commit(const Clock::duration& measurement) noexcept
+{
+  profile_->commit(measurement);
+}
+
+const std::shared_ptr<RealTimeDurationProfile>& RealTimeDurationMeasurement::getProfile() const
+{
+  return profile_;
+}
+
+}  // namespace arti_profiling
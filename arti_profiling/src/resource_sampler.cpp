@@ -0,0 +1,189 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/resource_sampler.h>
+#include <arti_profiling/gauge.h>
+#include <arti_profiling/simple_formatter.h>
+#include <dirent.h>
+#include <fstream>
+#include <malloc.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace arti_profiling
+{
+
+static const GaugeMeasurement::Formatter MEBIBYTE_FORMATTER(SimpleFormatter<double>("MiB", 8, 1));
+static const GaugeMeasurement::Formatter COUNT_FORMATTER(SimpleFormatter<double>("", 8, 0));
+static const GaugeMeasurement::Formatter RATE_FORMATTER(SimpleFormatter<double>("/s", 8, 1));
+static const GaugeMeasurement::Formatter PERCENTAGE_FORMATTER(SimpleFormatter<double>("%", 6, 1));
+
+ResourceSampler::ResourceSampler(Profiler& profiler, const Clock::duration& period)
+  : profiler_(profiler, "resources"), period_(period)
+{
+  thread_ = std::thread(&ResourceSampler::run, this);
+}
+
+ResourceSampler::~ResourceSampler()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+  }
+  stop_condition_.notify_all();
+  thread_.join();
+}
+
+void ResourceSampler::sample()
+{
+  std::lock_guard<std::mutex> lock(sample_mutex_);
+  Counters counters;
+  counters.time = Clock::now();
+
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+  {
+    counters.cpu_time = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+      + 1e-6 * (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+    counters.voluntary_context_switches = usage.ru_nvcsw;
+    counters.involuntary_context_switches = usage.ru_nivcsw;
+    counters.major_page_faults = usage.ru_majflt;
+  }
+
+  // The resident set size from /proc/self/stat is given in pages:
+  std::int64_t resident_pages = 0;
+  std::int64_t thread_count = 0;
+  {
+    std::ifstream stat("/proc/self/stat");
+    std::string field;
+    if (std::getline(stat, field, ')'))  // Skip PID and command, which may contain spaces
+    {
+      for (int i = 3; i <= 24 && stat >> field; ++i)
+      {
+        if (i == 20)
+        {
+          thread_count = std::stoll(field);
+        }
+        else if (i == 24)
+        {
+          resident_pages = std::stoll(field);
+        }
+      }
+    }
+  }
+  GaugeMeasurement(profiler_, "resident memory", resident_pages * sysconf(_SC_PAGESIZE) / 1048576.0,
+                   MEBIBYTE_FORMATTER);
+  std::int64_t peak_resident_kb = 0;
+  if (readStatusValue("VmHWM", peak_resident_kb))
+  {
+    GaugeMeasurement(profiler_, "peak resident memory", peak_resident_kb / 1024.0, MEBIBYTE_FORMATTER);
+  }
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+  const struct mallinfo2 heap = mallinfo2();
+  GaugeMeasurement(profiler_, "heap in use", (heap.uordblks + heap.hblkhd) / 1048576.0, MEBIBYTE_FORMATTER);
+#elif defined(__GLIBC__)
+  const struct mallinfo heap = mallinfo();  // Its fields overflow beyond 2 GiB
+  GaugeMeasurement(profiler_, "heap in use", (static_cast<unsigned>(heap.uordblks) + static_cast<unsigned>(heap.hblkhd))
+                                             / 1048576.0, MEBIBYTE_FORMATTER);
+#endif
+
+  GaugeMeasurement(profiler_, "open fds", countOpenFileDescriptors(), COUNT_FORMATTER);
+  GaugeMeasurement(profiler_, "threads", thread_count, COUNT_FORMATTER);
+
+  if (last_counters_.time != Clock::time_point())
+  {
+    const double interval = std::chrono::duration_cast<std::chrono::duration<double>>(
+      counters.time - last_counters_.time).count();
+    if (interval > 0.0)
+    {
+      GaugeMeasurement(profiler_, "cpu usage", 100.0 * (counters.cpu_time - last_counters_.cpu_time) / interval,
+                       PERCENTAGE_FORMATTER);
+      GaugeMeasurement(
+        profiler_, "voluntary context switches",
+        (counters.voluntary_context_switches - last_counters_.voluntary_context_switches) / interval, RATE_FORMATTER);
+      GaugeMeasurement(
+        profiler_, "involuntary context switches",
+        (counters.involuntary_context_switches - last_counters_.involuntary_context_switches) / interval,
+        RATE_FORMATTER);
+      GaugeMeasurement(profiler_, "major page faults",
+                       (counters.major_page_faults - last_counters_.major_page_faults) / interval, RATE_FORMATTER);
+    }
+  }
+  last_counters_ = counters;
+}
+
+void ResourceSampler::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  Clock::time_point next_time = Clock::now();
+  while (!stopped_)
+  {
+    lock.unlock();
+    sample();
+    lock.lock();
+
+    next_time += period_;
+    stop_condition_.wait_until(lock, next_time, [this]() { return stopped_; });
+  }
+}
+
+std::size_t ResourceSampler::countOpenFileDescriptors()
+{
+  DIR* directory = opendir("/proc/self/fd");
+  if (directory == nullptr)
+  {
+    return 0;
+  }
+
+  std::size_t count = 0;
+  while (const dirent* entry = readdir(directory))
+  {
+    if (entry->d_name[0] != '.')
+    {
+      ++count;
+    }
+  }
+  closedir(directory);
+  return count - 1;  // Don't count the descriptor of the directory itself
+}
+
+bool ResourceSampler::readStatusValue(const std::string& key, std::int64_t& value)
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':')
+    {
+      value = std::stoll(line.substr(key.size() + 1));
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace arti_profiling
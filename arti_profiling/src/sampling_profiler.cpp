@@ -0,0 +1,421 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/sampling_profiler.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <sstream>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+namespace arti_profiling
+{
+
+const std::size_t SamplingProfiler::MAX_STACK_DEPTH = 64;
+const std::size_t SamplingProfiler::MAX_SCOPE_NAME_LENGTH = 32;
+
+namespace
+{
+
+// Frames of the signal handler and the kernel's signal trampoline, which are on top of every sampled stack:
+const int HANDLER_FRAME_COUNT = 2;
+
+const std::size_t MAX_SCOPE_DEPTH = 16;
+const std::size_t THREAD_NAME_LENGTH = 16;
+
+struct Sample
+{
+  std::atomic<bool> complete{false};
+  std::uint32_t thread_id{0};
+  char thread_name[THREAD_NAME_LENGTH];
+  char scope[SamplingProfiler::MAX_SCOPE_NAME_LENGTH + 1];
+  std::uint32_t depth{0};
+  void* frames[SamplingProfiler::MAX_STACK_DEPTH];
+};
+
+/// The names of the active measurements of a thread, innermost last. Fixed-size, so that the signal handler can read
+/// it; measurements nested deeper than MAX_SCOPE_DEPTH are counted, but attributed to the deepest stored one.
+struct ScopeStack
+{
+  std::atomic<std::size_t> depth{0};
+  char names[MAX_SCOPE_DEPTH][SamplingProfiler::MAX_SCOPE_NAME_LENGTH + 1];
+};
+
+/// The sampling timer of a registered thread, deleted when the thread exits.
+struct ThreadTimer
+{
+  ~ThreadTimer();
+
+  bool created{false};
+  timer_t timer{};
+  std::uint32_t thread_id{0};
+  char thread_name[THREAD_NAME_LENGTH] = {0};
+};
+
+std::mutex mutex;  ///< Guards the members below, which are not accessed by the signal handler
+std::vector<ThreadTimer*> thread_timers;
+std::chrono::microseconds sampling_interval{0};
+std::unique_ptr<Sample[]> samples_storage;
+
+// Accessed by the signal handler:
+std::atomic<bool> running{false};
+std::atomic<Sample*> samples{nullptr};
+std::atomic<std::size_t> active_handler_count{0};  ///< Of handlers that may be accessing the samples
+std::atomic<std::size_t> sample_capacity{0};
+std::atomic<std::size_t> write_index{0};
+std::atomic<std::size_t> dropped_count{0};
+
+thread_local ScopeStack scope_stack;
+thread_local ThreadTimer thread_timer;
+
+void armTimer(ThreadTimer& timer, const std::chrono::microseconds& interval)
+{
+  itimerspec spec{};
+  spec.it_interval.tv_sec = interval.count() / 1000000;
+  spec.it_interval.tv_nsec = interval.count() % 1000000 * 1000;
+  spec.it_value = spec.it_interval;
+  timer_settime(timer.timer, 0, &spec, nullptr);
+}
+
+ThreadTimer::~ThreadTimer()
+{
+  if (created)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    timer_delete(timer);
+    thread_timers.erase(std::remove(thread_timers.begin(), thread_timers.end(), this), thread_timers.end());
+  }
+}
+
+extern "C" void handleSamplingSignal(int /*signal*/)
+{
+  if (!running.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+
+  // Announces this handler before loading the buffer, so that replaceSamples() either waits for it or the handler
+  // sees no buffer (both sequentially consistent):
+  active_handler_count.fetch_add(1);
+  const int saved_errno = errno;
+  Sample* const buffer = samples.load();
+  const std::size_t index = write_index.fetch_add(1, std::memory_order_relaxed);
+  if (buffer == nullptr || index >= sample_capacity.load(std::memory_order_relaxed))
+  {
+    dropped_count.fetch_add(1, std::memory_order_relaxed);
+    errno = saved_errno;
+    active_handler_count.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+
+  Sample& sample = buffer[index];
+  void* frames[SamplingProfiler::MAX_STACK_DEPTH + HANDLER_FRAME_COUNT];
+  const int depth = std::max(0, backtrace(frames, SamplingProfiler::MAX_STACK_DEPTH + HANDLER_FRAME_COUNT)
+    - HANDLER_FRAME_COUNT);
+  std::memcpy(sample.frames, frames + HANDLER_FRAME_COUNT, depth * sizeof(void*));
+  sample.depth = static_cast<std::uint32_t>(depth);
+  sample.thread_id = thread_timer.thread_id;
+  std::memcpy(sample.thread_name, thread_timer.thread_name, sizeof(sample.thread_name));
+
+  const std::size_t scope_depth = scope_stack.depth.load(std::memory_order_relaxed);
+  if (scope_depth > 0)
+  {
+    std::memcpy(sample.scope, scope_stack.names[std::min(scope_depth, MAX_SCOPE_DEPTH) - 1], sizeof(sample.scope));
+  }
+  else
+  {
+    sample.scope[0] = '\0';
+  }
+
+  sample.complete.store(true, std::memory_order_release);
+  errno = saved_errno;
+  active_handler_count.fetch_sub(1, std::memory_order_release);
+}
+
+/// Hides the sample buffer from new handlers, which drop their samples meanwhile, and waits for the running ones (e.g.
+/// on other CPUs, even after stop()) to finish writing to it; the mutex must be locked. Returns the buffer.
+Sample* detachSamples()
+{
+  Sample* const buffer = samples.exchange(nullptr);
+  while (active_handler_count.load(std::memory_order_acquire) != 0)
+  {
+    std::this_thread::yield();
+  }
+  return buffer;
+}
+
+/// Replaces the sample buffer by a new one with the given capacity; the mutex must be locked.
+void replaceSamples(const std::size_t capacity)
+{
+  detachSamples();
+  samples_storage.reset(new Sample[capacity]);
+  sample_capacity.store(capacity);
+  write_index.store(0);
+  samples.store(samples_storage.get());
+}
+
+std::string symbolize(void* address, const bool return_address)
+{
+  // Return addresses point behind the call, which may already belong to the next function:
+  const char* lookup_address = static_cast<const char*>(address) - (return_address ? 1 : 0);
+
+  Dl_info info{};
+  if (dladdr(lookup_address, &info) == 0)
+  {
+    std::ostringstream result;
+    result << address;
+    return result.str();
+  }
+
+  std::string result;
+  if (info.dli_sname != nullptr)
+  {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+    result = status == 0 && demangled != nullptr ? demangled : info.dli_sname;
+    std::free(demangled);
+  }
+  else
+  {
+    const char* file_name = info.dli_fname != nullptr ? std::strrchr(info.dli_fname, '/') : nullptr;
+    std::ostringstream stream;
+    stream << (file_name != nullptr ? file_name + 1 : info.dli_fname != nullptr ? info.dli_fname : "?") << "+0x"
+           << std::hex << (lookup_address - static_cast<const char*>(info.dli_fbase));
+    result = stream.str();
+  }
+  std::replace(result.begin(), result.end(), ';', ':');  // Semicolons separate the frames
+  return result;
+}
+
+}  // namespace
+
+void SamplingProfiler::start(const std::chrono::microseconds& interval, const std::size_t capacity)
+{
+  registerThread();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (running.load())
+  {
+    return;
+  }
+
+  // The first call of backtrace() loads libgcc, which allocates, so it must not happen in the signal handler:
+  void* frames[1];
+  backtrace(frames, 1);
+
+  if (!samples_storage || sample_capacity.load() != std::max<std::size_t>(capacity, 1))
+  {
+    replaceSamples(std::max<std::size_t>(capacity, 1));
+  }
+
+  struct sigaction action{};
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  action.sa_handler = &handleSamplingSignal;
+  if (sigaction(SIGPROF, &action, nullptr) != 0)
+  {
+    throw std::runtime_error(std::string("cannot install SIGPROF handler: ") + std::strerror(errno));
+  }
+
+  sampling_interval = std::max(interval, std::chrono::microseconds(1));
+  running.store(true);
+  for (ThreadTimer* timer : thread_timers)
+  {
+    armTimer(*timer, sampling_interval);
+  }
+}
+
+void SamplingProfiler::stop()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  running.store(false);
+  for (ThreadTimer* timer : thread_timers)
+  {
+    armTimer(*timer, std::chrono::microseconds(0));
+  }
+}
+
+bool SamplingProfiler::isRunning()
+{
+  return running.load();
+}
+
+void SamplingProfiler::registerThread()
+{
+  if (thread_timer.created)
+  {
+    return;
+  }
+
+  thread_timer.thread_id = static_cast<std::uint32_t>(syscall(SYS_gettid));
+  pthread_getname_np(pthread_self(), thread_timer.thread_name, sizeof(thread_timer.thread_name));
+
+  sigevent event{};
+  event.sigev_notify = SIGEV_THREAD_ID;
+  event.sigev_signo = SIGPROF;
+  event.sigev_notify_thread_id = static_cast<pid_t>(thread_timer.thread_id);
+  if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &thread_timer.timer) != 0)
+  {
+    throw std::runtime_error(std::string("cannot create sampling timer: ") + std::strerror(errno));
+  }
+  thread_timer.created = true;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  thread_timers.push_back(&thread_timer);
+  if (running.load())
+  {
+    armTimer(thread_timer, sampling_interval);
+  }
+}
+
+void SamplingProfiler::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  // Handlers that already claimed an index would otherwise complete their sample after the reset:
+  Sample* const buffer = detachSamples();
+  const std::size_t count = std::min(write_index.load(), sample_capacity.load());
+  for (std::size_t i = 0; buffer != nullptr && i < count; ++i)
+  {
+    buffer[i].complete.store(false);
+  }
+  write_index.store(0);
+  dropped_count.store(0);
+  samples.store(buffer);
+}
+
+std::size_t SamplingProfiler::getSampleCount()
+{
+  return std::min(write_index.load(), sample_capacity.load());
+}
+
+std::size_t SamplingProfiler::getDroppedCount()
+{
+  return dropped_count.load();
+}
+
+void SamplingProfiler::writeFoldedStacks(std::ostream& out)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  Sample* const buffer = samples.load();
+  const std::size_t count = std::min(write_index.load(), sample_capacity.load());
+
+  std::map<void*, std::string> symbols;
+  std::map<std::string, std::size_t> stacks;
+  for (std::size_t i = 0; buffer != nullptr && i < count; ++i)
+  {
+    const Sample& sample = buffer[i];
+    if (!sample.complete.load(std::memory_order_acquire))
+    {
+      continue;
+    }
+
+    std::ostringstream stack;
+    if (sample.thread_name[0] != '\0')
+    {
+      stack << std::string(sample.thread_name, strnlen(sample.thread_name, sizeof(sample.thread_name))) << ' ';
+    }
+    stack << '[' << sample.thread_id << ']';
+    if (sample.scope[0] != '\0')
+    {
+      std::string scope(sample.scope, strnlen(sample.scope, sizeof(sample.scope)));
+      std::replace(scope.begin(), scope.end(), ';', ':');
+      stack << ";[" << scope << ']';
+    }
+    for (std::uint32_t frame = sample.depth; frame > 0; --frame)
+    {
+      void* address = sample.frames[frame - 1];
+      auto symbol = symbols.find(address);
+      if (symbol == symbols.end())
+      {
+        symbol = symbols.emplace(address, symbolize(address, frame > 1)).first;
+      }
+      stack << ';' << symbol->second;
+    }
+    ++stacks[stack.str()];
+  }
+
+  for (const auto& stack : stacks)
+  {
+    out << stack.first << ' ' << stack.second << '\n';
+  }
+}
+
+std::uintptr_t SamplingProfiler::enterScope(const std::string& name) noexcept
+{
+  if (!running.load(std::memory_order_relaxed))
+  {
+    return 0;
+  }
+
+  const std::size_t depth = scope_stack.depth.load(std::memory_order_relaxed);
+  if (depth >= 255)
+  {
+    return 0;
+  }
+  if (depth < MAX_SCOPE_DEPTH)
+  {
+    const std::size_t length = std::min(name.size(), MAX_SCOPE_NAME_LENGTH);
+    std::memcpy(scope_stack.names[depth], name.data(), length);
+    scope_stack.names[depth][length] = '\0';
+  }
+  // Make the name visible to the signal handler before the depth:
+  std::atomic_signal_fence(std::memory_order_release);
+  scope_stack.depth.store(depth + 1, std::memory_order_relaxed);
+
+  // Encode the depth in the address of the thread's stack, so that only its thread can leave the scope:
+  return reinterpret_cast<std::uintptr_t>(&scope_stack) + depth + 1;
+}
+
+void SamplingProfiler::leaveScope(const std::uintptr_t scope) noexcept
+{
+  const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(&scope_stack);
+  if (scope > base && scope - base <= 255)
+  {
+    // Also leaves the inner scopes that were not left properly:
+    scope_stack.depth.store(std::min<std::size_t>(scope - base - 1, scope_stack.depth.load()));
+  }
+}
+
+}  // namespace arti_profiling
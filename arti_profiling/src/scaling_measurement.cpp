@@ -0,0 +1,328 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/scaling_measurement.h>
+#include <algorithm>
+#include <boost/format.hpp>
+#include <cmath>
+#include <iomanip>
+#include <ros/console.h>
+#include <utility>
+
+namespace arti_profiling
+{
+
+const std::size_t ScalingStatistics::DEFAULT_RESERVOIR_SIZE = 1000;
+const double ScalingStatistics::MIN_SIZE_RATIO = 4.0;
+const double ScalingStatistics::MIN_R_SQUARED_MARGIN = 0.01;
+
+static const Complexity MODELS[] = {Complexity::LINEAR, Complexity::N_LOG_N, Complexity::QUADRATIC};
+
+const char* toString(const Complexity complexity)
+{
+  switch (complexity)
+  {
+    case Complexity::LINEAR:
+      return "n";
+    case Complexity::N_LOG_N:
+      return "n log n";
+    case Complexity::QUADRATIC:
+      return "n^2";
+    case Complexity::UNKNOWN:
+      break;
+  }
+  return "unknown";
+}
+
+/// Prints nanoseconds with a unit that keeps the number readable.
+static void printNanoseconds(std::ostream& out, const double nanoseconds)
+{
+  const double magnitude = std::abs(nanoseconds);
+  if (magnitude >= 1e6)
+  {
+    out << boost::format("%.3gms") % (nanoseconds * 1e-6);
+  }
+  else if (magnitude >= 1e3)
+  {
+    out << boost::format("%.3gus") % (nanoseconds * 1e-3);
+  }
+  else
+  {
+    out << boost::format("%.3gns") % nanoseconds;
+  }
+}
+
+ScalingStatistics::ScalingStatistics(Formatter formatter, const std::size_t reservoir_size)
+  : DurationStatistics(std::move(formatter)), reservoir_size_(std::max<std::size_t>(reservoir_size, 2))
+{
+}
+
+void ScalingStatistics::accumulateScaling(const std::size_t n, const DurationMeasurement::Clock::duration& duration)
+{
+  Lock lock(mutex_);
+  accumulate(duration.count());
+
+  // Reservoir sampling ("algorithm R"), which keeps each pair with the same probability:
+  const std::pair<double, double> pair(static_cast<double>(n), static_cast<double>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+  ++scaling_count_;
+  if (reservoir_.size() < reservoir_size_)
+  {
+    reservoir_.push_back(pair);
+  }
+  else
+  {
+    const std::uint64_t index = random_() % scaling_count_;
+    if (index < reservoir_size_)
+    {
+      reservoir_[index] = pair;
+    }
+  }
+}
+
+Complexity ScalingStatistics::getExpectedComplexity() const
+{
+  Lock lock(mutex_);
+  return expected_complexity_;
+}
+
+void ScalingStatistics::setExpectedComplexity(const Complexity complexity)
+{
+  Lock lock(mutex_);
+  expected_complexity_ = complexity;
+}
+
+std::vector<ScalingStatistics::Fit> ScalingStatistics::fit() const
+{
+  Lock lock(mutex_);
+  std::vector<Fit> fits;
+  if (reservoir_.size() < 3)
+  {
+    return fits;
+  }
+
+  const auto size_range = std::minmax_element(
+    reservoir_.begin(), reservoir_.end(),
+    [](const std::pair<double, double>& a, const std::pair<double, double>& b) { return a.first < b.first; });
+  if (size_range.second->first < MIN_SIZE_RATIO * std::max(size_range.first->first, 1.0))
+  {
+    return fits;
+  }
+
+  for (const Complexity complexity : MODELS)
+  {
+    double sum_x = 0.0, sum_y = 0.0, sum_xx = 0.0, sum_xy = 0.0, sum_yy = 0.0;
+    for (const std::pair<double, double>& pair : reservoir_)
+    {
+      const double x = evaluate(complexity, pair.first);
+      sum_x += x;
+      sum_y += pair.second;
+      sum_xx += x * x;
+      sum_xy += x * pair.second;
+      sum_yy += pair.second * pair.second;
+    }
+
+    const double count = static_cast<double>(reservoir_.size());
+    const double variance_x = sum_xx - sum_x * sum_x / count;
+    const double variance_y = sum_yy - sum_y * sum_y / count;
+    const double covariance = sum_xy - sum_x * sum_y / count;
+    if (variance_x <= 0.0)
+    {
+      continue;
+    }
+
+    Fit fit;
+    fit.complexity = complexity;
+    fit.factor = covariance / variance_x;
+    fit.offset = (sum_y - fit.factor * sum_x) / count;
+    fit.r_squared = variance_y > 0.0 ? covariance * covariance / (variance_x * variance_y) : 1.0;
+    fits.push_back(fit);
+  }
+  return fits;
+}
+
+ScalingStatistics::Fit ScalingStatistics::getBestFit() const
+{
+  return getBestFit(fit());
+}
+
+bool ScalingStatistics::exceedsExpectedComplexity() const
+{
+  const Fit best_fit = getBestFit();
+  Lock lock(mutex_);
+  return expected_complexity_ != Complexity::UNKNOWN && best_fit.complexity != Complexity::UNKNOWN
+    && static_cast<int>(best_fit.complexity) > static_cast<int>(expected_complexity_);
+}
+
+void ScalingStatistics::printDetails(std::ostream& out, const int indent) const
+{
+  Lock lock(mutex_);
+  DurationStatistics::printDetails(out, indent);
+  for (const Fit& fit : fit())
+  {
+    const std::string label = std::string("fit ") + toString(fit.complexity);
+    out << std::setw(indent) << "" << label << std::setw(28 - std::min(28, static_cast<int>(label.size())) + 2)
+        << std::left << ": " << std::right;
+    printNanoseconds(out, fit.factor);
+    out << " * " << toString(fit.complexity) << (fit.offset < 0.0 ? " - " : " + ");
+    printNanoseconds(out, std::abs(fit.offset));
+    out << boost::format(", R^2: %.3f") % fit.r_squared << std::endl;
+  }
+}
+
+void ScalingStatistics::clear()
+{
+  Lock lock(mutex_);
+  DurationStatistics::clear();
+  reservoir_.clear();
+  scaling_count_ = 0;
+}
+
+bool ScalingStatistics::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+  DurationStatistics::takeSnapshot(snapshot);
+  snapshot.type = "scaling";
+  const Fit best_fit = getBestFit();
+  if (best_fit.complexity != Complexity::UNKNOWN)
+  {
+    snapshot.counters["best_fit_complexity"] = static_cast<std::int64_t>(best_fit.complexity);
+    snapshot.counters["best_fit_factor_ps"] = std::llround(best_fit.factor * 1000.0);
+  }
+  if (expected_complexity_ != Complexity::UNKNOWN)
+  {
+    snapshot.counters["expected_complexity"] = static_cast<std::int64_t>(expected_complexity_);
+  }
+  return true;
+}
+
+std::size_t ScalingStatistics::getMemoryUsage() const
+{
+  Lock lock(mutex_);
+  return sizeof(*this) - sizeof(DurationStatistics) + DurationStatistics::getMemoryUsage()
+    + reservoir_.capacity() * sizeof(reservoir_.front());
+}
+
+double ScalingStatistics::evaluate(const Complexity complexity, const double n)
+{
+  switch (complexity)
+  {
+    case Complexity::LINEAR:
+      return n;
+    case Complexity::N_LOG_N:
+      return n > 1.0 ? n * std::log2(n) : 0.0;
+    case Complexity::QUADRATIC:
+      return n * n;
+    case Complexity::UNKNOWN:
+      break;
+  }
+  return 0.0;
+}
+
+ScalingStatistics::Fit ScalingStatistics::getBestFit(const std::vector<Fit>& fits)
+{
+  // The fits are ordered by growth, as fit() goes through MODELS in order:
+  Fit best_fit;
+  for (const Fit& fit : fits)
+  {
+    if (best_fit.complexity == Complexity::UNKNOWN || fit.r_squared > best_fit.r_squared + MIN_R_SQUARED_MARGIN)
+    {
+      best_fit = fit;
+    }
+  }
+  return best_fit;
+}
+
+void ScalingStatistics::printAdditionalValues(std::ostream& out) const
+{
+  DurationStatistics::printAdditionalValues(out);
+  const Fit best_fit = getBestFit();
+  if (best_fit.complexity != Complexity::UNKNOWN)
+  {
+    out << ", scales with " << toString(best_fit.complexity);
+    if (expected_complexity_ != Complexity::UNKNOWN
+        && static_cast<int>(best_fit.complexity) > static_cast<int>(expected_complexity_))
+    {
+      out << " (expected " << toString(expected_complexity_) << "!)";
+    }
+  }
+}
+
+ScalingMeasurement::ScalingMeasurement(
+  Profiler& profiler, std::string name, const std::size_t n, const Complexity expected_complexity,
+  const Clock::time_point& start_time)
+  : profiler_(&profiler), name_(std::move(name)), n_(n), expected_complexity_(expected_complexity),
+    start_time_(start_time)
+{
+}
+
+ScalingMeasurement::~ScalingMeasurement()
+{
+  stop();
+}
+
+void ScalingMeasurement::start(const Clock::time_point& start_time)
+{
+  start_time_ = start_time;
+}
+
+void ScalingMeasurement::stop(const Clock::time_point& stop_time)
+{
+  if (start_time_ == DurationMeasurement::NEVER)
+  {
+    return;
+  }
+  const Clock::duration duration = stop_time - start_time_;
+  start_time_ = DurationMeasurement::NEVER;
+
+  Profiler::ProfileUpdate profile_update = profiler_->getProfile(name_);
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<ScalingStatistics>();
+  }
+
+  std::shared_ptr<ScalingStatistics> statistics
+    = std::dynamic_pointer_cast<ScalingStatistics>(profile_update.profile);
+  if (statistics)
+  {
+    if (expected_complexity_ != Complexity::UNKNOWN)
+    {
+      statistics->setExpectedComplexity(expected_complexity_);
+    }
+    statistics->accumulateScaling(n_, duration);
+  }
+  else
+  {
+    ROS_WARN_NAMED("scaling_measurement", "profiling measurement types do not match");
+  }
+}
+
+void ScalingMeasurement::setSize(const std::size_t n)
+{
+  n_ = n;
+}
+
+}  // namespace arti_profiling
@@ -0,0 +1,927 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/snapshot.h>
+#include <algorithm>
+#include <cmath>
+#include <boost/format.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <ros/console.h>
+#include <stdexcept>
+
+namespace arti_profiling
+{
+
+const std::uint32_t ProfilerSnapshot::VERSION = 2;
+
+// Oldest version that can still be read; version 1 had no counters:
+static const std::uint32_t MIN_VERSION = 1;
+
+static const char BINARY_MAGIC[4] = {'A', 'P', 'S', 'N'};
+static const char* const JSON_FORMAT = "arti_profiling_snapshot";
+static const std::uint32_t MAX_BINARY_SIZE = 1u << 24;
+
+double SnapshotValue::toDouble() const
+{
+  return integral ? static_cast<double>(integer) : real;
+}
+
+SnapshotValue& SnapshotValue::operator+=(const SnapshotValue& other)
+{
+  if (integral && other.integral)
+  {
+    integer += other.integer;
+  }
+  else
+  {
+    real = toDouble() + other.toDouble();
+    integer = 0;
+    integral = false;
+  }
+  return *this;
+}
+
+bool SnapshotValue::operator<(const SnapshotValue& other) const
+{
+  if (integral && other.integral)
+  {
+    return integer < other.integer;
+  }
+  return toDouble() < other.toDouble();
+}
+
+bool SnapshotValue::operator==(const SnapshotValue& other) const
+{
+  return integral == other.integral && (integral ? integer == other.integer : real == other.real);
+}
+
+bool SnapshotValue::operator!=(const SnapshotValue& other) const
+{
+  return !(*this == other);
+}
+
+bool SampleSnapshot::operator==(const SampleSnapshot& other) const
+{
+  return value == other.value && time == other.time && thread == other.thread && tag == other.tag;
+}
+
+double ProfileSnapshot::getAverage() const
+{
+  return count > 0 ? sum.toDouble() / static_cast<double>(count) : 0.0;
+}
+
+// Like in Profiler, each map node is estimated to hold about four pointers besides the value:
+static std::size_t getMemoryUsage(const std::map<std::string, ProfileSnapshot>& profiles)
+{
+  std::size_t result = 0;
+  for (const auto& profile : profiles)
+  {
+    result += 4 * sizeof(void*) + profile.first.capacity() + profile.second.getMemoryUsage();
+  }
+  return result;
+}
+
+std::size_t ProfileSnapshot::getMemoryUsage() const
+{
+  std::size_t result = sizeof(*this) - sizeof(Histogram) + histogram.getMemoryUsage() + type.capacity()
+    + top_samples.capacity() * sizeof(SampleSnapshot);
+  for (const SampleSnapshot& sample : top_samples)
+  {
+    result += sample.thread.capacity() + sample.tag.capacity();
+  }
+  for (const auto& counter : counters)
+  {
+    result += 4 * sizeof(void*) + sizeof(counter) + counter.first.capacity();
+  }
+  return result + arti_profiling::getMemoryUsage(labels);
+}
+
+bool ProfileSnapshot::merge(const ProfileSnapshot& other)
+{
+  if (type.empty() && count == 0 && labels.empty())
+  {
+    *this = other;
+    return true;
+  }
+  if (type != other.type)
+  {
+    return false;
+  }
+
+  if (other.count > 0)
+  {
+    if (count == 0)
+    {
+      sum = other.sum;
+      min = other.min;
+      max = other.max;
+    }
+    else
+    {
+      sum += other.sum;
+      if (other.min < min)
+      {
+        min = other.min;
+      }
+      if (max < other.max)
+      {
+        max = other.max;
+      }
+    }
+    count += other.count;
+  }
+
+  histogram.merge(other.histogram);
+
+  top_sample_capacity = std::max(top_sample_capacity, other.top_sample_capacity);
+  top_samples.insert(top_samples.end(), other.top_samples.begin(), other.top_samples.end());
+  std::stable_sort(top_samples.begin(), top_samples.end(),
+                   [](const SampleSnapshot& a, const SampleSnapshot& b) { return b.value < a.value; });
+  if (top_samples.size() > top_sample_capacity)
+  {
+    top_samples.resize(top_sample_capacity);
+  }
+
+  overrun_count += other.overrun_count;
+  if (other.last_overrun_time > last_overrun_time)
+  {
+    last_overrun = other.last_overrun;
+    last_overrun_budget = other.last_overrun_budget;
+    last_overrun_time = other.last_overrun_time;
+  }
+
+  for (const auto& counter : other.counters)
+  {
+    counters[counter.first] += counter.second;
+  }
+
+  bool success = true;
+  for (const auto& label : other.labels)
+  {
+    success = labels[label.first].merge(label.second) && success;
+  }
+  return success;
+}
+
+bool ProfileSnapshot::operator==(const ProfileSnapshot& other) const
+{
+  return type == other.type && count == other.count && sum == other.sum && min == other.min && max == other.max
+         && histogram == other.histogram && top_sample_capacity == other.top_sample_capacity
+         && top_samples == other.top_samples && overrun_count == other.overrun_count
+         && last_overrun == other.last_overrun && last_overrun_budget == other.last_overrun_budget
+         && last_overrun_time == other.last_overrun_time && labels == other.labels && counters == other.counters;
+}
+
+bool ProfileSnapshot::operator!=(const ProfileSnapshot& other) const
+{
+  return !(*this == other);
+}
+
+ProfilerSnapshot* ProfilerSnapshot::findChild(const std::string& child_name)
+{
+  for (ProfilerSnapshot& child : children)
+  {
+    if (child.name == child_name)
+    {
+      return &child;
+    }
+  }
+  return nullptr;
+}
+
+const ProfilerSnapshot* ProfilerSnapshot::findChild(const std::string& child_name) const
+{
+  return const_cast<ProfilerSnapshot*>(this)->findChild(child_name);
+}
+
+void ProfilerSnapshot::merge(const ProfilerSnapshot& other)
+{
+  time = std::max(time, other.time);
+
+  for (const auto& profile : other.profiles)
+  {
+    if (!profiles[profile.first].merge(profile.second))
+    {
+      ROS_WARN_NAMED("snapshot", "cannot merge profile '%s' of different types", profile.first.c_str());
+    }
+  }
+
+  for (const ProfilerSnapshot& other_child : other.children)
+  {
+    ProfilerSnapshot* child = findChild(other_child.name);
+    if (child != nullptr)
+    {
+      child->merge(other_child);
+    }
+    else
+    {
+      children.push_back(other_child);
+    }
+  }
+}
+
+std::size_t ProfilerSnapshot::getMemoryUsage() const
+{
+  std::size_t result = sizeof(*this) + name.capacity() + arti_profiling::getMemoryUsage(profiles)
+    + arti_profiling::getMemoryUsage(rollup) + (children.capacity() - children.size()) * sizeof(ProfilerSnapshot);
+  for (const ProfilerSnapshot& child : children)
+  {
+    result += child.getMemoryUsage();
+  }
+  return result;
+}
+
+void ProfilerSnapshot::computeRollUp()
+{
+  rollup = profiles;
+  for (ProfilerSnapshot& child : children)
+  {
+    child.computeRollUp();
+    for (const auto& profile : child.rollup)
+    {
+      if (!rollup[profile.first].merge(profile.second))
+      {
+        ROS_WARN_NAMED("snapshot", "cannot roll up profile '%s' of different types", profile.first.c_str());
+      }
+    }
+  }
+}
+
+bool ProfilerSnapshot::operator==(const ProfilerSnapshot& other) const
+{
+  return name == other.name && time == other.time && profiles == other.profiles && children == other.children;
+}
+
+bool ProfilerSnapshot::operator!=(const ProfilerSnapshot& other) const
+{
+  return !(*this == other);
+}
+
+bool isDurationType(const std::string& type)
+{
+  return type == "duration" || type == "span" || type == "lock" || type == "timer_jitter" || type == "pipeline"
+    || type == "scaling";
+}
+
+static void printSnapshotValue(std::ostream& out, const std::string& type, const double value)
+{
+  if (isDurationType(type))
+  {
+    out << boost::format("%5.0fms") % (value * 1e-6);
+  }
+  else if (type == "frequency")
+  {
+    out << boost::format("%5.1fHz") % value;
+  }
+  else if (type == "message_size")
+  {
+    out << boost::format("%8.0fB") % value;
+  }
+  else
+  {
+    out << boost::format("%8.1f") % value;
+  }
+}
+
+void printSnapshot(std::ostream& out, const ProfileSnapshot& snapshot)
+{
+  if (snapshot.count == 0 || snapshot.type == "thread_pool")
+  {
+    out << "no calculations performed" << std::endl;
+    return;
+  }
+
+  out << "performed " << std::setw(6) << snapshot.count << "x, min: ";
+  printSnapshotValue(out, snapshot.type, snapshot.min.toDouble());
+  out << ", avg: ";
+  printSnapshotValue(out, snapshot.type, snapshot.getAverage());
+  out << ", max: ";
+  printSnapshotValue(out, snapshot.type, snapshot.max.toDouble());
+  if (!snapshot.histogram.empty())
+  {
+    const double min = snapshot.min.toDouble();
+    const double max = snapshot.max.toDouble();
+    out << ", p50: ";
+    printSnapshotValue(out, snapshot.type, std::min(std::max(snapshot.histogram.getQuantile(0.5), min), max));
+    out << ", p99: ";
+    printSnapshotValue(out, snapshot.type, std::min(std::max(snapshot.histogram.getQuantile(0.99), min), max));
+  }
+  if (snapshot.overrun_count > 0)
+  {
+    out << ", overruns: " << snapshot.overrun_count;
+  }
+  out << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Binary format: all numbers are stored in host byte order, strings and containers are prefixed with their size.
+
+template<typename T>
+static void writeRaw(std::ostream& out, const T& value)
+{
+  out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeRaw(std::ostream& out, const std::string& value)
+{
+  writeRaw(out, static_cast<std::uint32_t>(value.size()));
+  out.write(value.data(), value.size());
+}
+
+static void writeRaw(std::ostream& out, const SnapshotValue& value)
+{
+  if (value.integral)
+  {
+    writeRaw(out, value.integer);
+  }
+  else
+  {
+    writeRaw(out, value.real);
+  }
+}
+
+template<typename T>
+static T readRaw(std::istream& in)
+{
+  T value;
+  in.read(reinterpret_cast<char*>(&value), sizeof(value));
+  if (!in)
+  {
+    throw std::runtime_error("unexpected end of snapshot data");
+  }
+  return value;
+}
+
+static std::uint32_t readSize(std::istream& in)
+{
+  const std::uint32_t size = readRaw<std::uint32_t>(in);
+  if (size > MAX_BINARY_SIZE)
+  {
+    throw std::runtime_error("invalid size in snapshot data");
+  }
+  return size;
+}
+
+static std::string readString(std::istream& in)
+{
+  std::string value(readSize(in), '\0');
+  in.read(&value[0], value.size());
+  if (!in)
+  {
+    throw std::runtime_error("unexpected end of snapshot data");
+  }
+  return value;
+}
+
+static SnapshotValue readValue(std::istream& in, const bool integral)
+{
+  SnapshotValue value;
+  value.integral = integral;
+  if (integral)
+  {
+    value.integer = readRaw<std::int64_t>(in);
+  }
+  else
+  {
+    value.real = readRaw<double>(in);
+  }
+  return value;
+}
+
+static void writeProfile(std::ostream& out, const ProfileSnapshot& profile)
+{
+  writeRaw(out, profile.type);
+  writeRaw(out, static_cast<std::uint8_t>(profile.sum.integral));
+  writeRaw(out, profile.count);
+  writeRaw(out, profile.sum);
+  writeRaw(out, profile.min);
+  writeRaw(out, profile.max);
+
+  writeRaw(out, static_cast<std::uint32_t>(profile.histogram.getBuckets().size()));
+  for (const auto& bucket : profile.histogram.getBuckets())
+  {
+    writeRaw(out, bucket.first);
+    writeRaw(out, bucket.second);
+  }
+
+  writeRaw(out, profile.top_sample_capacity);
+  writeRaw(out, static_cast<std::uint32_t>(profile.top_samples.size()));
+  for (const SampleSnapshot& sample : profile.top_samples)
+  {
+    writeRaw(out, sample.value);
+    writeRaw(out, sample.time);
+    writeRaw(out, sample.thread);
+    writeRaw(out, sample.tag);
+  }
+
+  writeRaw(out, profile.overrun_count);
+  writeRaw(out, profile.last_overrun);
+  writeRaw(out, profile.last_overrun_budget);
+  writeRaw(out, profile.last_overrun_time);
+
+  writeRaw(out, static_cast<std::uint32_t>(profile.labels.size()));
+  for (const auto& label : profile.labels)
+  {
+    writeRaw(out, label.first);
+    writeProfile(out, label.second);
+  }
+
+  writeRaw(out, static_cast<std::uint32_t>(profile.counters.size()));
+  for (const auto& counter : profile.counters)
+  {
+    writeRaw(out, counter.first);
+    writeRaw(out, counter.second);
+  }
+}
+
+static ProfileSnapshot readProfile(std::istream& in, const std::uint32_t version)
+{
+  ProfileSnapshot profile;
+  profile.type = readString(in);
+  const bool integral = readRaw<std::uint8_t>(in) != 0;
+  profile.count = readRaw<std::uint64_t>(in);
+  profile.sum = readValue(in, integral);
+  profile.min = readValue(in, integral);
+  profile.max = readValue(in, integral);
+
+  for (std::uint32_t i = readSize(in); i > 0; --i)
+  {
+    const std::int32_t index = readRaw<std::int32_t>(in);
+    profile.histogram.setBucketCount(index, readRaw<std::uint64_t>(in));
+  }
+
+  profile.top_sample_capacity = readRaw<std::uint64_t>(in);
+  profile.top_samples.resize(readSize(in));
+  for (SampleSnapshot& sample : profile.top_samples)
+  {
+    sample.value = readValue(in, integral);
+    sample.time = readRaw<std::int64_t>(in);
+    sample.thread = readString(in);
+    sample.tag = readString(in);
+  }
+
+  profile.overrun_count = readRaw<std::uint64_t>(in);
+  profile.last_overrun = readRaw<std::int64_t>(in);
+  profile.last_overrun_budget = readRaw<std::int64_t>(in);
+  profile.last_overrun_time = readRaw<std::int64_t>(in);
+
+  for (std::uint32_t i = readSize(in); i > 0; --i)
+  {
+    std::string key = readString(in);
+    profile.labels[key] = readProfile(in, version);
+  }
+
+  if (version >= 2)
+  {
+    for (std::uint32_t i = readSize(in); i > 0; --i)
+    {
+      std::string key = readString(in);
+      profile.counters[key] = readRaw<std::int64_t>(in);
+    }
+  }
+  return profile;
+}
+
+static void writeProfiler(std::ostream& out, const ProfilerSnapshot& profiler)
+{
+  writeRaw(out, profiler.name);
+  writeRaw(out, profiler.time);
+  writeRaw(out, static_cast<std::uint32_t>(profiler.profiles.size()));
+  for (const auto& profile : profiler.profiles)
+  {
+    writeRaw(out, profile.first);
+    writeProfile(out, profile.second);
+  }
+  writeRaw(out, static_cast<std::uint32_t>(profiler.children.size()));
+  for (const ProfilerSnapshot& child : profiler.children)
+  {
+    writeProfiler(out, child);
+  }
+}
+
+static ProfilerSnapshot readProfiler(std::istream& in, const std::uint32_t version)
+{
+  ProfilerSnapshot profiler;
+  profiler.name = readString(in);
+  profiler.time = readRaw<std::int64_t>(in);
+  for (std::uint32_t i = readSize(in); i > 0; --i)
+  {
+    std::string name = readString(in);
+    profiler.profiles[name] = readProfile(in, version);
+  }
+  profiler.children.resize(readSize(in));
+  for (ProfilerSnapshot& child : profiler.children)
+  {
+    child = readProfiler(in, version);
+  }
+  return profiler;
+}
+
+void writeBinary(std::ostream& out, const ProfilerSnapshot& snapshot)
+{
+  out.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+  writeRaw(out, ProfilerSnapshot::VERSION);
+  writeProfiler(out, snapshot);
+}
+
+ProfilerSnapshot readBinary(std::istream& in)
+{
+  char magic[sizeof(BINARY_MAGIC)];
+  in.read(magic, sizeof(magic));
+  if (!in || !std::equal(magic, magic + sizeof(magic), BINARY_MAGIC))
+  {
+    throw std::runtime_error("not a binary profiling snapshot");
+  }
+  const std::uint32_t version = readRaw<std::uint32_t>(in);
+  if (version < MIN_VERSION || version > ProfilerSnapshot::VERSION)
+  {
+    throw std::runtime_error((boost::format("unsupported snapshot version %d") % version).str());
+  }
+  return readProfiler(in, version);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// JSON format: written directly, read with Boost's property tree parser.
+
+static void writeJsonString(std::ostream& out, const std::string& value)
+{
+  out << '"';
+  for (const char c : value)
+  {
+    switch (c)
+    {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      case '\t':
+        out << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          out << boost::format("\\u%04x") % static_cast<int>(c);
+        }
+        else
+        {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+}
+
+static void writeJsonValue(std::ostream& out, const SnapshotValue& value)
+{
+  if (value.integral)
+  {
+    out << value.integer;
+  }
+  else if (std::isnan(value.real))
+  {
+    out << "null";  // JSON has no NaN
+  }
+  else
+  {
+    // JSON has no infinity either, e.g. of a frequency measured between equal times, so clamp it:
+    const double real = std::max(std::min(value.real, std::numeric_limits<double>::max()),
+                                 std::numeric_limits<double>::lowest());
+    out << boost::format("%.17g") % real;
+  }
+}
+
+static void writeJsonProfile(std::ostream& out, const ProfileSnapshot& profile, const std::string& indent)
+{
+  const std::string inner = indent + "  ";
+  out << "{\n";
+  out << inner << "\"type\": ";
+  writeJsonString(out, profile.type);
+  out << ",\n" << inner << "\"integral\": " << (profile.sum.integral ? "true" : "false");
+  out << ",\n" << inner << "\"count\": " << profile.count;
+  out << ",\n" << inner << "\"sum\": ";
+  writeJsonValue(out, profile.sum);
+  out << ",\n" << inner << "\"min\": ";
+  writeJsonValue(out, profile.min);
+  out << ",\n" << inner << "\"max\": ";
+  writeJsonValue(out, profile.max);
+
+  if (!profile.histogram.empty())
+  {
+    out << ",\n" << inner << "\"histogram\": [";
+    bool first = true;
+    for (const auto& bucket : profile.histogram.getBuckets())
+    {
+      out << (first ? "" : ", ") << '[' << bucket.first << ", " << bucket.second << ']';
+      first = false;
+    }
+    out << ']';
+  }
+
+  if (profile.top_sample_capacity > 0)
+  {
+    out << ",\n" << inner << "\"top_sample_capacity\": " << profile.top_sample_capacity;
+    out << ",\n" << inner << "\"top_samples\": [";
+    for (std::size_t i = 0; i < profile.top_samples.size(); ++i)
+    {
+      const SampleSnapshot& sample = profile.top_samples[i];
+      out << (i > 0 ? "," : "") << '\n' << inner << "  {\"value\": ";
+      writeJsonValue(out, sample.value);
+      out << ", \"time\": " << sample.time << ", \"thread\": ";
+      writeJsonString(out, sample.thread);
+      out << ", \"tag\": ";
+      writeJsonString(out, sample.tag);
+      out << '}';
+    }
+    out << (profile.top_samples.empty() ? "]" : "\n" + inner + "]");
+  }
+
+  if (profile.overrun_count > 0)
+  {
+    out << ",\n" << inner << "\"overrun_count\": " << profile.overrun_count;
+    out << ",\n" << inner << "\"last_overrun\": " << profile.last_overrun;
+    out << ",\n" << inner << "\"last_overrun_budget\": " << profile.last_overrun_budget;
+    out << ",\n" << inner << "\"last_overrun_time\": " << profile.last_overrun_time;
+  }
+
+  if (!profile.labels.empty())
+  {
+    out << ",\n" << inner << "\"labels\": {";
+    bool first = true;
+    for (const auto& label : profile.labels)
+    {
+      out << (first ? "\n" : ",\n") << inner << "  ";
+      writeJsonString(out, label.first);
+      out << ": ";
+      writeJsonProfile(out, label.second, inner + "  ");
+      first = false;
+    }
+    out << '\n' << inner << '}';
+  }
+
+  if (!profile.counters.empty())
+  {
+    out << ",\n" << inner << "\"counters\": {";
+    bool first = true;
+    for (const auto& counter : profile.counters)
+    {
+      out << (first ? "" : ", ");
+      writeJsonString(out, counter.first);
+      out << ": " << counter.second;
+      first = false;
+    }
+    out << '}';
+  }
+
+  out << '\n' << indent << '}';
+}
+
+static void writeJsonProfiler(std::ostream& out, const ProfilerSnapshot& profiler, const std::string& indent)
+{
+  const std::string inner = indent + "  ";
+  out << "{\n";
+  if (indent.empty())
+  {
+    out << inner << "\"format\": \"" << JSON_FORMAT << "\",\n";
+    out << inner << "\"version\": " << ProfilerSnapshot::VERSION << ",\n";
+  }
+  out << inner << "\"name\": ";
+  writeJsonString(out, profiler.name);
+  out << ",\n" << inner << "\"time\": " << profiler.time;
+
+  out << ",\n" << inner << "\"profiles\": {";
+  bool first = true;
+  for (const auto& profile : profiler.profiles)
+  {
+    out << (first ? "\n" : ",\n") << inner << "  ";
+    writeJsonString(out, profile.first);
+    out << ": ";
+    writeJsonProfile(out, profile.second, inner + "  ");
+    first = false;
+  }
+  out << (profiler.profiles.empty() ? "}" : "\n" + inner + "}");
+
+  out << ",\n" << inner << "\"children\": [";
+  first = true;
+  for (const ProfilerSnapshot& child : profiler.children)
+  {
+    out << (first ? "\n" : ",\n") << inner << "  ";
+    writeJsonProfiler(out, child, inner + "  ");
+    first = false;
+  }
+  out << (profiler.children.empty() ? "]" : "\n" + inner + "]");
+
+  out << '\n' << indent << '}';
+}
+
+void writeJson(std::ostream& out, const ProfilerSnapshot& snapshot)
+{
+  writeJsonProfiler(out, snapshot, std::string());
+  out << '\n';
+}
+
+void writeJson(std::ostream& out, const std::vector<ProfilerSnapshot>& snapshots)
+{
+  out << '[';
+  bool first = true;
+  for (const ProfilerSnapshot& snapshot : snapshots)
+  {
+    out << (first ? "\n" : ",\n");
+    writeJsonProfiler(out, snapshot, std::string());
+    first = false;
+  }
+  out << (snapshots.empty() ? "]\n" : "\n]\n");
+}
+
+using PropertyTree = boost::property_tree::ptree;
+
+static const PropertyTree EMPTY_TREE;
+
+static SnapshotValue readJsonValue(const PropertyTree& tree, const bool integral)
+{
+  SnapshotValue value;
+  value.integral = integral;
+  if (integral)
+  {
+    value.integer = std::stoll(tree.data());
+  }
+  else if (tree.data() == "null")
+  {
+    value.real = std::numeric_limits<double>::quiet_NaN();
+  }
+  else
+  {
+    value.real = std::stod(tree.data());
+  }
+  return value;
+}
+
+static ProfileSnapshot readJsonProfile(const PropertyTree& tree)
+{
+  ProfileSnapshot profile;
+  profile.type = tree.get<std::string>("type");
+  const bool integral = tree.get<bool>("integral");
+  profile.count = tree.get<std::uint64_t>("count");
+  profile.sum = readJsonValue(tree.get_child("sum"), integral);
+  profile.min = readJsonValue(tree.get_child("min"), integral);
+  profile.max = readJsonValue(tree.get_child("max"), integral);
+
+  for (const auto& bucket : tree.get_child("histogram", EMPTY_TREE))
+  {
+    std::vector<std::string> fields;
+    for (const auto& field : bucket.second)
+    {
+      fields.push_back(field.second.data());
+    }
+    if (fields.size() != 2)
+    {
+      throw std::runtime_error("invalid histogram bucket in snapshot");
+    }
+    profile.histogram.setBucketCount(std::stoi(fields[0]), std::stoull(fields[1]));
+  }
+
+  profile.top_sample_capacity = tree.get<std::uint64_t>("top_sample_capacity", 0);
+  for (const auto& sample_tree : tree.get_child("top_samples", EMPTY_TREE))
+  {
+    SampleSnapshot sample;
+    sample.value = readJsonValue(sample_tree.second.get_child("value"), integral);
+    sample.time = sample_tree.second.get<std::int64_t>("time");
+    sample.thread = sample_tree.second.get<std::string>("thread", std::string());
+    sample.tag = sample_tree.second.get<std::string>("tag", std::string());
+    profile.top_samples.push_back(sample);
+  }
+
+  profile.overrun_count = tree.get<std::uint64_t>("overrun_count", 0);
+  profile.last_overrun = tree.get<std::int64_t>("last_overrun", 0);
+  profile.last_overrun_budget = tree.get<std::int64_t>("last_overrun_budget", 0);
+  profile.last_overrun_time = tree.get<std::int64_t>("last_overrun_time", 0);
+
+  for (const auto& label : tree.get_child("labels", EMPTY_TREE))
+  {
+    profile.labels[label.first] = readJsonProfile(label.second);
+  }
+
+  for (const auto& counter : tree.get_child("counters", EMPTY_TREE))
+  {
+    profile.counters[counter.first] = std::stoll(counter.second.data());
+  }
+  return profile;
+}
+
+static ProfilerSnapshot readJsonProfiler(const PropertyTree& tree)
+{
+  ProfilerSnapshot profiler;
+  profiler.name = tree.get<std::string>("name");
+  profiler.time = tree.get<std::int64_t>("time", 0);
+  for (const auto& profile : tree.get_child("profiles", EMPTY_TREE))
+  {
+    profiler.profiles[profile.first] = readJsonProfile(profile.second);
+  }
+  for (const auto& child : tree.get_child("children", EMPTY_TREE))
+  {
+    profiler.children.push_back(readJsonProfiler(child.second));
+  }
+  return profiler;
+}
+
+ProfilerSnapshot readJson(std::istream& in)
+{
+  try
+  {
+    PropertyTree tree;
+    boost::property_tree::read_json(in, tree);
+    if (tree.get<std::string>("format", std::string()) != JSON_FORMAT)
+    {
+      throw std::runtime_error("not a JSON profiling snapshot");
+    }
+    const std::uint32_t version = tree.get<std::uint32_t>("version");
+    if (version < MIN_VERSION || version > ProfilerSnapshot::VERSION)
+    {
+      throw std::runtime_error((boost::format("unsupported snapshot version %d") % version).str());
+    }
+    return readJsonProfiler(tree);
+  }
+  catch (const boost::property_tree::ptree_error& ex)
+  {
+    throw std::runtime_error(std::string("invalid JSON profiling snapshot: ") + ex.what());
+  }
+  catch (const std::logic_error& ex)  // Thrown by std::stoll etc.
+  {
+    throw std::runtime_error(std::string("invalid number in JSON profiling snapshot: ") + ex.what());
+  }
+}
+
+ProfilerSnapshot loadSnapshot(const std::string& file_name)
+{
+  std::ifstream in(file_name, std::ios::binary);
+  if (!in)
+  {
+    throw std::runtime_error("cannot open snapshot file '" + file_name + "'");
+  }
+
+  if (in.peek() == BINARY_MAGIC[0])
+  {
+    return readBinary(in);
+  }
+  return readJson(in);
+}
+
+void saveSnapshot(const std::string& file_name, const ProfilerSnapshot& snapshot)
+{
+  std::ofstream out(file_name, std::ios::binary);
+  if (!out)
+  {
+    throw std::runtime_error("cannot open snapshot file '" + file_name + "' for writing");
+  }
+
+  const std::string json_extension = ".json";
+  if (file_name.size() >= json_extension.size()
+      && file_name.compare(file_name.size() - json_extension.size(), json_extension.size(), json_extension) == 0)
+  {
+    writeJson(out, snapshot);
+  }
+  else
+  {
+    writeBinary(out, snapshot);
+  }
+
+  if (!out)
+  {
+    throw std::runtime_error("error writing snapshot file '" + file_name + "'");
+  }
+}
+
+}  // namespace arti_profiling
@@ -0,0 +1,427 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/span.h>
+#include <arti_profiling/flight_recorder.h>
+#include <algorithm>
+#include <iomanip>
+#include <ros/console.h>
+
+namespace arti_profiling
+{
+
+Span::Id Span::generateId()
+{
+  static std::atomic<Id> next_id{1};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+Span::Span(Profiler& profiler, std::string name, const Clock::time_point& start_time)
+  : Span(profiler, std::move(name), generateId(), start_time)
+{
+}
+
+Span::Span(Profiler& profiler, std::string name, const Id id, const Clock::time_point& start_time)
+  : profiler_(&profiler), name_(std::move(name)), id_(id), start_time_(start_time), last_time_(start_time)
+{
+}
+
+Span::Span(Span&& other) noexcept
+  : profiler_(other.profiler_), name_(std::move(other.name_)), id_(other.id_), start_time_(other.start_time_),
+    last_time_(other.last_time_)
+{
+  other.profiler_ = nullptr;
+}
+
+Span::~Span()
+{
+  abandon();
+}
+
+Span& Span::operator=(Span&& other) noexcept
+{
+  if (&other != this)
+  {
+    abandon();
+    profiler_ = other.profiler_;
+    name_ = std::move(other.name_);
+    id_ = other.id_;
+    start_time_ = other.start_time_;
+    last_time_ = other.last_time_;
+    other.profiler_ = nullptr;
+  }
+  return *this;
+}
+
+Span::Id Span::getId() const
+{
+  return id_;
+}
+
+bool Span::isActive() const
+{
+  return profiler_ != nullptr;
+}
+
+void Span::hop(const std::string& segment, const Clock::time_point& time)
+{
+  if (profiler_ != nullptr)
+  {
+    SpanStatistics::commit(*profiler_, name_, &segment, time - last_time_);
+    last_time_ = time;
+  }
+}
+
+void Span::finish(const std::string& last_segment, const Clock::time_point& time)
+{
+  if (profiler_ != nullptr)
+  {
+    if (!last_segment.empty())
+    {
+      SpanStatistics::commit(*profiler_, name_, &last_segment, time - last_time_);
+    }
+    SpanStatistics::commit(*profiler_, name_, nullptr, time - start_time_);
+    profiler_ = nullptr;
+  }
+}
+
+void Span::abandon()
+{
+  if (profiler_ != nullptr)
+  {
+    SpanStatistics::commitAbandoned(*profiler_, name_);
+    profiler_ = nullptr;
+  }
+}
+
+const std::size_t SpanTable::MAX_PROBES;
+constexpr SpanTable::Id SpanTable::PENDING;
+
+SpanTable::SpanTable(Profiler& profiler, std::string name, const std::size_t capacity)
+  : profiler_(&profiler), name_(std::move(name)), capacity_(std::max<std::size_t>(capacity, 1)),
+    slots_(new Slot[capacity_])
+{
+}
+
+bool SpanTable::start(const Id id, const Clock::time_point& time)
+{
+  if (id == 0 || (id & PENDING) != 0)
+  {
+    return false;
+  }
+
+  // Claim the first free slot by tagging it with the pending ID:
+  const std::size_t probe_count = getProbeCount();
+  std::size_t claimed = probe_count;
+  for (std::size_t i = 0; i < probe_count; ++i)
+  {
+    Slot& slot = slots_[(id + i) % capacity_];
+    Id expected = slot.id.load();
+    if (expected == id)
+    {
+      return false;
+    }
+    if (expected == 0 && slot.id.compare_exchange_strong(expected, id | PENDING))
+    {
+      claimed = i;
+      break;
+    }
+  }
+  if (claimed == probe_count)
+  {
+    ROS_WARN_NAMED("span", "span table '%s' is full, not tracking span %lu", name_.c_str(),
+                   static_cast<unsigned long>(id));
+    return false;
+  }
+  Slot& slot = slots_[(id + claimed) % capacity_];
+
+  // Resolve concurrent starts of the same ID: all claims and these loads are sequentially consistent, so of any two
+  // claimers at least one sees the other. A published span or an earlier claim wins, later claims are cancelled.
+  for (std::size_t i = 0; i < probe_count; ++i)
+  {
+    if (i == claimed)
+    {
+      continue;
+    }
+    Slot& other = slots_[(id + i) % capacity_];
+    Id other_id = other.id.load();
+    if (other_id == (id | PENDING) && i > claimed)
+    {
+      // Cancelled slots stay marked until their claimer notices, so that nobody else can claim them meanwhile:
+      other.id.compare_exchange_strong(other_id, PENDING);
+    }
+    if (other_id == id || (other_id == (id | PENDING) && i < claimed))
+    {
+      slot.id.store(0);
+      return false;
+    }
+  }
+
+  slot.start_time.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+  slot.last_time.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+  Id expected = id | PENDING;
+  if (!slot.id.compare_exchange_strong(expected, id, std::memory_order_release))
+  {
+    slot.id.store(0);  // Cancelled by a concurrent start of the same ID
+    return false;
+  }
+  return true;
+}
+
+bool SpanTable::hop(const Id id, const std::string& segment, const Clock::time_point& time)
+{
+  Slot* slot = find(id);
+  if (slot == nullptr)
+  {
+    return false;
+  }
+
+  Clock::rep time_count = time.time_since_epoch().count();
+  const Clock::rep last_time = slot->last_time.exchange(time_count, std::memory_order_acq_rel);
+  if (slot->id.load(std::memory_order_acquire) != id)
+  {
+    // The span was finished concurrently and the slot possibly reused, so undo the exchange if still possible:
+    slot->last_time.compare_exchange_strong(time_count, last_time, std::memory_order_acq_rel);
+    return false;
+  }
+  SpanStatistics::commit(*profiler_, name_, &segment, time - Clock::time_point(Clock::duration(last_time)));
+  return true;
+}
+
+bool SpanTable::finish(const Id id, const std::string& last_segment, const Clock::time_point& time)
+{
+  Slot* slot = find(id);
+  Id expected = id;
+  // Mark the slot as being released, so that it isn't reused before the times are read:
+  if (slot == nullptr || !slot->id.compare_exchange_strong(expected, PENDING, std::memory_order_acquire))
+  {
+    return false;  // Unknown, or finished concurrently by another thread
+  }
+
+  const Clock::time_point start_time(Clock::duration(slot->start_time.load(std::memory_order_relaxed)));
+  const Clock::time_point last_time(Clock::duration(slot->last_time.load(std::memory_order_relaxed)));
+  slot->id.store(0, std::memory_order_release);
+
+  if (!last_segment.empty())
+  {
+    SpanStatistics::commit(*profiler_, name_, &last_segment, time - last_time);
+  }
+  SpanStatistics::commit(*profiler_, name_, nullptr, time - start_time);
+  return true;
+}
+
+bool SpanTable::abandon(const Id id)
+{
+  Slot* slot = find(id);
+  Id expected = id;
+  if (slot == nullptr || !slot->id.compare_exchange_strong(expected, 0, std::memory_order_release))
+  {
+    return false;
+  }
+
+  SpanStatistics::commitAbandoned(*profiler_, name_);
+  return true;
+}
+
+SpanTable::Slot* SpanTable::find(const Id id)
+{
+  if (id == 0 || (id & PENDING) != 0)
+  {
+    return nullptr;
+  }
+
+  for (std::size_t i = 0; i < getProbeCount(); ++i)
+  {
+    Slot& slot = slots_[(id + i) % capacity_];
+    if (slot.id.load(std::memory_order_acquire) == id)
+    {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+std::size_t SpanTable::getProbeCount() const
+{
+  return std::min(MAX_PROBES, capacity_);
+}
+
+SpanStatistics::SpanStatistics(Formatter formatter)
+  : DurationStatistics(std::move(formatter))
+{
+}
+
+void SpanStatistics::printDetails(std::ostream& out, const int indent) const
+{
+  Lock lock(mutex_);
+  DurationStatistics::printDetails(out, indent);
+  for (const auto& segment : segments_)
+  {
+    const std::string label = "-> " + segment.first;
+    out << std::setw(indent) << "" << label << std::setw(28 - std::min(28, static_cast<int>(label.size())) + 2)
+        << std::left << ": " << std::right;
+    segment.second->print(out);
+  }
+}
+
+bool SpanStatistics::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+  DurationStatistics::takeSnapshot(snapshot);
+  snapshot.type = "span";
+  for (const auto& segment : segments_)
+  {
+    segment.second->takeSnapshot(snapshot.labels["segment=" + segment.first]);
+  }
+  if (abandoned_count_ > 0)
+  {
+    snapshot.counters["abandoned"] = abandoned_count_;
+  }
+  return true;
+}
+
+std::size_t SpanStatistics::getMemoryUsage() const
+{
+  Lock lock(mutex_);
+  std::size_t result = sizeof(*this) - sizeof(DurationStatistics) + DurationStatistics::getMemoryUsage()
+    + segments_.capacity() * sizeof(segments_.front());
+  for (const auto& segment : segments_)
+  {
+    result += segment.first.capacity() + segment.second->getMemoryUsage();
+  }
+  return result;
+}
+
+bool SpanStatistics::merge(const Profile& other)
+{
+  const SpanStatistics* statistics = dynamic_cast<const SpanStatistics*>(&other);
+  if (statistics == nullptr || statistics == this)
+  {
+    return DurationStatistics::merge(other);
+  }
+
+  DurationStatistics::merge(*statistics);
+
+  Lock lock(mutex_, std::defer_lock);
+  Lock other_lock(statistics->mutex_, std::defer_lock);
+  std::lock(lock, other_lock);
+
+  for (const auto& other_segment : statistics->segments_)
+  {
+    auto it = std::find_if(
+      segments_.begin(), segments_.end(),
+      [&](const std::pair<std::string, std::unique_ptr<DurationStatistics>>& segment)
+      {
+        return segment.first == other_segment.first;
+      });
+    if (it == segments_.end())
+    {
+      segments_.emplace_back(
+        other_segment.first, std::unique_ptr<DurationStatistics>(new DurationStatistics(formatter_)));
+      it = segments_.end() - 1;
+    }
+    it->second->merge(*other_segment.second);
+  }
+  abandoned_count_ += statistics->abandoned_count_;
+  return true;
+}
+
+void SpanStatistics::accumulateSegment(const std::string& segment, const DurationMeasurement::Clock::duration& duration)
+{
+  Lock lock(mutex_);
+  for (const auto& entry : segments_)
+  {
+    if (entry.first == segment)
+    {
+      entry.second->accumulate(duration.count());
+      return;
+    }
+  }
+  segments_.emplace_back(segment, std::unique_ptr<DurationStatistics>(new DurationStatistics(formatter_)));
+  segments_.back().second->accumulate(duration.count());
+}
+
+void SpanStatistics::accumulateAbandoned()
+{
+  Lock lock(mutex_);
+  ++abandoned_count_;
+}
+
+void SpanStatistics::commit(
+  Profiler& profiler, const std::string& name, const std::string* segment,
+  const DurationMeasurement::Clock::duration& duration)
+{
+  Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+  std::shared_ptr<SpanStatistics> statistics = getSpanStatistics(profile_update);
+  if (statistics)
+  {
+    if (segment != nullptr)
+    {
+      statistics->accumulateSegment(*segment, duration);
+    }
+    else
+    {
+      FlightRecorder::recordDuration(name, DurationMeasurement::Clock::now() - duration, duration);
+      statistics->accumulate(duration.count());
+    }
+  }
+}
+
+void SpanStatistics::commitAbandoned(Profiler& profiler, const std::string& name)
+{
+  Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+  std::shared_ptr<SpanStatistics> statistics = getSpanStatistics(profile_update);
+  if (statistics)
+  {
+    statistics->accumulateAbandoned();
+  }
+}
+
+void SpanStatistics::printAdditionalValues(std::ostream& out) const
+{
+  DurationStatistics::printAdditionalValues(out);
+  if (abandoned_count_ > 0)
+  {
+    out << ", abandoned: " << abandoned_count_;
+  }
+}
+
+std::shared_ptr<SpanStatistics> SpanStatistics::getSpanStatistics(Profiler::ProfileUpdate& profile_update)
+{
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<SpanStatistics>();
+  }
+
+  std::shared_ptr<SpanStatistics> statistics = std::dynamic_pointer_cast<SpanStatistics>(profile_update.profile);
+  if (!statistics)
+  {
+    ROS_WARN_NAMED("span", "profiling measurement types do not match");
+  }
+  return statistics;
+}
+
+}  // namespace arti_profiling
@@ -25,8 +25,19 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include <arti_profiling/statistics_printer.h>
+#include <arti_profiling/overhead.h>
+#include <arti_profiling/snapshot.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <ros/console.h>
+#include <ros/this_node.h>
+#include <sstream>
+#include <utility>
+#include <vector>
 
 namespace arti_profiling
 {
@@ -34,7 +45,10 @@ namespace arti_profiling
 StatisticsPrinter::StatisticsPrinter(Profiler& profiler, std::ostream& out, const ros::NodeHandle& node_handle)
   : profiler_(&profiler), out_(&out), node_handle_(node_handle), config_server_(node_handle_)
 {
+  // Calibrate now rather than when first printing, which would delay the first statistics:
+  getOverheadCalibration();
   config_server_.setCallback(std::bind(&StatisticsPrinter::reconfigure, this, std::placeholders::_1));
+  history_service_ = node_handle_.advertiseService("get_profiling_history", &StatisticsPrinter::getHistory, this);
 }
 
 StatisticsPrinter::StatisticsPrinter(Profiler& profiler, const ros::NodeHandle& node_handle)
@@ -46,8 +60,26 @@ StatisticsPrinter::~StatisticsPrinter() = default;
 
 void StatisticsPrinter::reconfigure(const StatisticsPrinterConfig& config)
 {
+  const bool sink_changed = !sink_ || config.sink != config_.sink || config.log_directory != config_.log_directory
+    || config.max_file_size != config_.max_file_size || config.max_file_age != config_.max_file_age
+    || config.max_file_count != config_.max_file_count || config.compress_log_files != config_.compress_log_files
+    || config.format != config_.format;
   config_ = config;
 
+  if (sink_changed)
+  {
+    std::unique_ptr<AsyncLogSink> sink = createSink(config_);
+    {
+      std::lock_guard<std::mutex> lock(sink_mutex_);
+      sink_.swap(sink);
+      json_format_ = config_.format == "json";
+    }
+    // The previous sink writes out its remaining records when destroyed here, without holding the lock.
+  }
+
+  setOverheadCompensationEnabled(config_.compensate_profiling_overhead);
+  profiler_->setHistoryCapacity(static_cast<std::size_t>(config_.history_length));
+
   if (config_.print_statistics)
   {
     timer_ = node_handle_.createWallTimer(ros::WallDuration(config_.print_statistics_interval),
@@ -60,10 +92,105 @@ void StatisticsPrinter::reconfigure(const StatisticsPrinterConfig& config)
   }
 }
 
+bool StatisticsPrinter::getHistory(
+  GetProfilingHistory::Request& request, GetProfilingHistory::Response& response)
+{
+  std::ostringstream json;
+  if (request.profile.empty())
+  {
+    // The stamp is wall-clock time, like the end times of the intervals (see GetProfilingHistory.srv):
+    const std::int64_t time = request.stamp.isZero()
+      ? std::numeric_limits<std::int64_t>::max() : static_cast<std::int64_t>(request.stamp.toNSec());
+    ProfilerSnapshot snapshot;
+    if (!profiler_->getHistoricSnapshot(time, snapshot))
+    {
+      response.message = "no interval recorded before the given stamp";
+      return true;
+    }
+
+    const ProfilerSnapshot* profiler = &snapshot;
+    std::istringstream path(request.profiler);
+    std::string child_name;
+    while (profiler != nullptr && std::getline(path, child_name, '/'))
+    {
+      profiler = profiler->findChild(child_name);
+    }
+    if (profiler == nullptr)
+    {
+      response.message = "no profiler '" + request.profiler + "' in the interval";
+      return true;
+    }
+    writeJson(json, *profiler);
+  }
+  else
+  {
+    std::vector<ProfilerSnapshot> time_series;
+    for (ProfilerSnapshot& interval : profiler_->getHistory(request.profiler))
+    {
+      const auto profile = interval.profiles.find(request.profile);
+      if (profile != interval.profiles.end())
+      {
+        ProfilerSnapshot entry;
+        entry.name = interval.name;
+        entry.time = interval.time;
+        entry.profiles.insert(*profile);
+        time_series.push_back(std::move(entry));
+      }
+    }
+    if (time_series.empty())
+    {
+      response.message = "no intervals recorded of profile '" + request.profile + "' in profiler '" + request.profiler
+        + "'";
+      return true;
+    }
+    writeJson(json, time_series);
+  }
+
+  response.success = true;
+  response.json = json.str();
+  return true;
+}
+
+std::unique_ptr<AsyncLogSink> StatisticsPrinter::createSink(const StatisticsPrinterConfig& config) const
+{
+  if (config.sink != "file")
+  {
+    return std::unique_ptr<AsyncLogSink>(new AsyncLogSink(*out_));
+  }
+
+  AsyncLogSink::FileOptions options;
+  options.directory = config.log_directory;
+  std::string node_name = ros::this_node::getName();
+  std::replace(node_name.begin(), node_name.end(), '/', '_');
+  options.base_name = "profiling" + node_name;
+  options.extension = config.format == "json" ? ".json" : ".log";
+  options.max_file_size = static_cast<std::size_t>(config.max_file_size) * 1024 * 1024;
+  options.max_file_age = std::chrono::seconds(static_cast<std::chrono::seconds::rep>(config.max_file_age));
+  options.max_file_count = static_cast<std::size_t>(config.max_file_count);
+  options.compress = config.compress_log_files;
+  return std::unique_ptr<AsyncLogSink>(new AsyncLogSink(std::move(options)));
+}
+
 void StatisticsPrinter::printStatistics(const ros::WallTimerEvent&)
 {
-  profiler_->printStatistics(*out_);
+  std::lock_guard<std::mutex> lock(sink_mutex_);
+
+  // Only formatting happens here, the sink's thread does the actual writing:
+  std::ostringstream record;
+  if (json_format_)
+  {
+    writeJson(record, profiler_->takeSnapshot());
+  }
+  else
+  {
+    profiler_->printStatistics(record);
+  }
   profiler_->clear();
+
+  if (!sink_->write(record.str()))
+  {
+    ROS_WARN_NAMED("statistics_printer", "dropped profiling statistics, as the previous ones are still being written");
+  }
 }
 
 }  // namespace arti_profiling
@@ -0,0 +1,325 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/thread_utilization.h>
+#include <algorithm>
+#include <boost/format.hpp>
+#include <iomanip>
+#include <pthread.h>
+#include <ros/console.h>
+
+namespace arti_profiling
+{
+
+static thread_local ThreadRegistration* current_registration = nullptr;
+static thread_local std::unique_ptr<ThreadRegistration> automatic_registration;
+
+ThreadPoolUtilization::ThreadState::ThreadState(std::string name)
+  : name(std::move(name)), cpu_clock(CLOCK_THREAD_CPUTIME_ID)
+{
+  if (pthread_getcpuclockid(pthread_self(), &cpu_clock) != 0)
+  {
+    cpu_clock = CLOCK_THREAD_CPUTIME_ID;
+  }
+  busy_periods.setHistogramEnabled(true);
+}
+
+std::shared_ptr<ThreadPoolUtilization> ThreadPoolUtilization::getPool(Profiler& profiler, const std::string& name)
+{
+  Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<ThreadPoolUtilization>();
+  }
+
+  std::shared_ptr<ThreadPoolUtilization> pool = std::dynamic_pointer_cast<ThreadPoolUtilization>(
+    profile_update.profile);
+  if (!pool)
+  {
+    ROS_WARN_NAMED("thread_utilization", "profiling measurement types do not match");
+    pool = std::make_shared<ThreadPoolUtilization>();  // Keep the registration working, although not reported
+  }
+  return pool;
+}
+
+ThreadPoolUtilization::ThreadPoolUtilization()
+  : interval_start_(Clock::now().time_since_epoch().count())
+{
+}
+
+void ThreadPoolUtilization::print(std::ostream& out) const
+{
+  Lock lock(mutex_);
+
+  if (threads_.empty())
+  {
+    out << "no threads registered" << std::endl;
+    return;
+  }
+
+  const Clock::time_point now = Clock::now();
+  double busy_sum = 0.0;
+  double busy_max = 0.0;
+  double cpu_sum = 0.0;
+  for (const ThreadStatePtr& thread : threads_)
+  {
+    const Utilization utilization = getUtilization(*thread, now);
+    busy_sum += utilization.busy;
+    busy_max = std::max(busy_max, utilization.busy);
+    cpu_sum += utilization.cpu;
+  }
+  const double busy_average = busy_sum / threads_.size();
+  out << boost::format("%2d threads, busy: avg %5.1f%%, max %5.1f%%, cpu: avg %5.1f%%, imbalance: %.2f")
+         % threads_.size() % (100.0 * busy_average) % (100.0 * busy_max) % (100.0 * cpu_sum / threads_.size())
+         % (busy_average > 0.0 ? busy_max / busy_average : 1.0) << std::endl;
+}
+
+void ThreadPoolUtilization::printDetails(std::ostream& out, const int indent) const
+{
+  Lock lock(mutex_);
+
+  const Clock::time_point now = Clock::now();
+  for (const ThreadStatePtr& thread : threads_)
+  {
+    const Utilization utilization = getUtilization(*thread, now);
+    out << std::setw(indent) << "" << thread->name
+        << std::setw(28 - std::min(28, static_cast<int>(thread->name.size())) + 2) << std::left << ": " << std::right
+        << boost::format("busy %5.1f%%, cpu %5.1f%%, busy periods: ") % (100.0 * utilization.busy)
+           % (100.0 * utilization.cpu);
+    thread->busy_periods.print(out);
+  }
+}
+
+bool ThreadPoolUtilization::reset()
+{
+  Lock lock(mutex_);
+
+  // The threads restart their busy time themselves, as they update it without locking:
+  interval_start_ = Clock::now().time_since_epoch().count();
+  for (const ThreadStatePtr& thread : threads_)
+  {
+    thread->cpu_time_at_interval_start = getCpuTime(*thread);
+    thread->busy_periods.clear();
+  }
+  return true;
+}
+
+bool ThreadPoolUtilization::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+
+  const Clock::time_point now = Clock::now();
+  const Clock::duration interval = now - Clock::time_point(Clock::duration(interval_start_));
+  snapshot.type = "thread_pool";
+  snapshot.count = threads_.size();
+  for (const ThreadStatePtr& thread : threads_)
+  {
+    const Utilization utilization = getUtilization(*thread, now);
+    const std::int64_t interval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(interval).count();
+
+    ProfileSnapshot& thread_snapshot = snapshot.labels["thread=" + thread->name];
+    thread->busy_periods.takeSnapshot(thread_snapshot);
+    thread_snapshot.counters["interval_ns"] = interval_ns;
+    thread_snapshot.counters["busy_ns"] = static_cast<std::int64_t>(utilization.busy * interval_ns);
+    thread_snapshot.counters["cpu_ns"] = static_cast<std::int64_t>(utilization.cpu * interval_ns);
+  }
+  return true;
+}
+
+std::size_t ThreadPoolUtilization::getMemoryUsage() const
+{
+  Lock lock(mutex_);
+
+  std::size_t result = sizeof(*this) + threads_.capacity() * sizeof(ThreadStatePtr);
+  for (const ThreadStatePtr& thread : threads_)
+  {
+    result += sizeof(ThreadState) - sizeof(DurationStatistics) + thread->name.capacity()
+      + thread->busy_periods.getMemoryUsage();
+  }
+  return result;
+}
+
+ThreadPoolUtilization::ThreadStatePtr ThreadPoolUtilization::addThread(std::string name)
+{
+  ThreadStatePtr thread = std::make_shared<ThreadState>(std::move(name));
+  thread->cpu_time_at_interval_start = getCpuTime(*thread);
+
+  Lock lock(mutex_);
+  threads_.push_back(thread);
+  return thread;
+}
+
+void ThreadPoolUtilization::removeThread(const ThreadStatePtr& thread)
+{
+  Lock lock(mutex_);
+  threads_.erase(std::remove(threads_.begin(), threads_.end(), thread), threads_.end());
+}
+
+std::size_t ThreadPoolUtilization::getThreadCount() const
+{
+  Lock lock(mutex_);
+  return threads_.size();
+}
+
+void ThreadPoolUtilization::beginBusy(ThreadState& thread, const Clock::time_point& time)
+{
+  thread.busy_since.store(time.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+void ThreadPoolUtilization::endBusy(ThreadState& thread, const Clock::time_point& time)
+{
+  const Clock::time_point busy_since(Clock::duration(thread.busy_since.exchange(0, std::memory_order_relaxed)));
+  const Clock::rep interval_start = interval_start_.load(std::memory_order_relaxed);
+
+  // Only this thread writes its busy time, so a concurrent reset() can neither lose the period nor leave time from
+  // before the interval in it. The busy time is stored before the interval it belongs to, so that readers seeing the
+  // current interval also see the busy time restarted in it:
+  Clock::rep busy_time = 0;
+  if (thread.busy_time_interval.load(std::memory_order_relaxed) == interval_start)
+  {
+    busy_time = thread.busy_time.load(std::memory_order_relaxed);
+  }
+  busy_time += (time - std::max(busy_since, Clock::time_point(Clock::duration(interval_start)))).count();
+  thread.busy_time.store(busy_time, std::memory_order_relaxed);
+  thread.busy_time_interval.store(interval_start, std::memory_order_release);
+  thread.busy_periods.accumulate((time - busy_since).count());
+}
+
+ThreadPoolUtilization::Utilization ThreadPoolUtilization::getUtilization(
+  const ThreadState& thread, const Clock::time_point& now) const
+{
+  Utilization utilization;
+  const Clock::time_point interval_start(Clock::duration(interval_start_.load(std::memory_order_relaxed)));
+  const double interval = std::chrono::duration_cast<std::chrono::duration<double>>(now - interval_start).count();
+  if (interval <= 0.0)
+  {
+    return utilization;
+  }
+
+  Clock::duration busy_time(0);
+  if (thread.busy_time_interval.load(std::memory_order_acquire) == interval_start.time_since_epoch().count())
+  {
+    busy_time = Clock::duration(thread.busy_time.load(std::memory_order_relaxed));
+  }
+  const Clock::rep busy_since = thread.busy_since.load(std::memory_order_relaxed);
+  if (busy_since != 0)
+  {
+    busy_time += now - std::max(Clock::time_point(Clock::duration(busy_since)), interval_start);
+  }
+  utilization.busy = std::chrono::duration_cast<std::chrono::duration<double>>(busy_time).count() / interval;
+  utilization.cpu = 1e-9 * (getCpuTime(thread) - thread.cpu_time_at_interval_start) / interval;
+  return utilization;
+}
+
+std::int64_t ThreadPoolUtilization::getCpuTime(const ThreadState& thread)
+{
+  timespec time{};
+  if (clock_gettime(thread.cpu_clock, &time) != 0)
+  {
+    return 0;
+  }
+  return static_cast<std::int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+ThreadRegistration::ThreadRegistration(Profiler& profiler, const std::string& pool_name, std::string thread_name)
+  : pool_(ThreadPoolUtilization::getPool(profiler, pool_name)), state_(pool_->addThread(std::move(thread_name))),
+    previous_(current_registration)
+{
+  current_registration = this;
+}
+
+ThreadRegistration::~ThreadRegistration()
+{
+  if (busy_depth_ > 0)
+  {
+    pool_->endBusy(*state_);
+  }
+  pool_->removeThread(state_);
+  current_registration = previous_;
+}
+
+ThreadRegistration* ThreadRegistration::getCurrent()
+{
+  return current_registration;
+}
+
+ThreadPoolUtilization& ThreadRegistration::getPool() const
+{
+  return *pool_;
+}
+
+ThreadPoolUtilization::ThreadState& ThreadRegistration::getState() const
+{
+  return *state_;
+}
+
+void ThreadRegistration::beginBusy()
+{
+  if (busy_depth_++ == 0)
+  {
+    pool_->beginBusy(*state_);
+  }
+}
+
+void ThreadRegistration::endBusy()
+{
+  if (busy_depth_ > 0 && --busy_depth_ == 0)
+  {
+    pool_->endBusy(*state_);
+  }
+}
+
+BusyScope::BusyScope()
+  : registration_(current_registration)
+{
+  if (registration_ != nullptr)
+  {
+    registration_->beginBusy();
+  }
+}
+
+BusyScope::BusyScope(Profiler& profiler, const std::string& pool_name)
+  : registration_(current_registration)
+{
+  if (registration_ == nullptr)
+  {
+    const std::shared_ptr<ThreadPoolUtilization> pool = ThreadPoolUtilization::getPool(profiler, pool_name);
+    automatic_registration.reset(new ThreadRegistration(
+      profiler, pool_name, pool_name + "_" + std::to_string(++pool->automatic_thread_count_)));
+    registration_ = automatic_registration.get();
+  }
+  registration_->beginBusy();
+}
+
+BusyScope::~BusyScope()
+{
+  if (registration_ != nullptr)
+  {
+    registration_->endBusy();
+  }
+}
+
+}  // namespace arti_profiling
@@ -0,0 +1,194 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/timer_jitter_measurement.h>
+#include <iomanip>
+#include <ros/console.h>
+#include <utility>
+
+namespace arti_profiling
+{
+
+TimerJitterStatistics::TimerJitterStatistics(Formatter formatter)
+  : DurationStatistics(formatter), period_errors_(formatter), callback_durations_(formatter)
+{
+  setHistogramEnabled(true);
+  period_errors_.setHistogramEnabled(true);
+  callback_durations_.setHistogramEnabled(true);
+}
+
+void TimerJitterStatistics::accumulateCall(
+  const DurationMeasurement::Clock::duration& lateness, const DurationMeasurement::Clock::duration* period_error)
+{
+  accumulate(lateness.count());
+  if (period_error != nullptr)
+  {
+    period_errors_.accumulate(period_error->count());
+  }
+}
+
+void TimerJitterStatistics::accumulateCallbackDuration(const DurationMeasurement::Clock::duration& duration)
+{
+  callback_durations_.accumulate(duration.count());
+}
+
+void TimerJitterStatistics::printDetails(std::ostream& out, const int indent) const
+{
+  DurationStatistics::printDetails(out, indent);
+  out << std::setw(indent) << "" << "period error: ";
+  period_errors_.print(out);
+  if (callback_durations_.getCount() > 0)
+  {
+    out << std::setw(indent) << "" << "callback:     ";
+    callback_durations_.print(out);
+  }
+}
+
+void TimerJitterStatistics::clear()
+{
+  Lock lock(mutex_);
+  DurationStatistics::clear();
+  period_errors_.clear();
+  callback_durations_.clear();
+}
+
+bool TimerJitterStatistics::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+  DurationStatistics::takeSnapshot(snapshot);
+  snapshot.type = "timer_jitter";
+  period_errors_.takeSnapshot(snapshot.labels["period_error"]);
+  if (callback_durations_.getCount() > 0)
+  {
+    callback_durations_.takeSnapshot(snapshot.labels["callback"]);
+  }
+  return true;
+}
+
+std::size_t TimerJitterStatistics::getMemoryUsage() const
+{
+  return DurationStatistics::getMemoryUsage() + period_errors_.getMemoryUsage()
+    + callback_durations_.getMemoryUsage();
+}
+
+const TimerJitterMeasurement::Formatter TimerJitterMeasurement::DEFAULT_FORMATTER(
+  SimpleDurationFormatter<std::chrono::microseconds>(6));
+
+TimerJitterMeasurement::TimerJitterMeasurement(Profiler& profiler, std::string name, Formatter formatter)
+  : profiler_(&profiler), name_(std::move(name)), formatter_(std::move(formatter))
+{
+}
+
+ros::TimerCallback TimerJitterMeasurement::wrap(ros::TimerCallback callback) const
+{
+  const TimerJitterMeasurement measurement(*this);
+  return [measurement, callback](const ros::TimerEvent& event)
+  {
+    measurement.record(event);
+    const Clock::time_point start_time = Clock::now();
+    callback(event);
+    measurement.recordCallbackDuration(Clock::now() - start_time);
+  };
+}
+
+ros::WallTimerCallback TimerJitterMeasurement::wrap(ros::WallTimerCallback callback) const
+{
+  const TimerJitterMeasurement measurement(*this);
+  return [measurement, callback](const ros::WallTimerEvent& event)
+  {
+    measurement.record(event);
+    const Clock::time_point start_time = Clock::now();
+    callback(event);
+    measurement.recordCallbackDuration(Clock::now() - start_time);
+  };
+}
+
+void TimerJitterMeasurement::record(const ros::TimerEvent& event) const
+{
+  const bool has_period = !event.last_expected.isZero() && !event.last_real.isZero();
+  record((event.current_real - event.current_expected).toNSec(), has_period,
+         has_period ? (event.current_real - event.last_real).toNSec()
+                      - (event.current_expected - event.last_expected).toNSec() : 0);
+}
+
+void TimerJitterMeasurement::record(const ros::WallTimerEvent& event) const
+{
+  const bool has_period = !event.last_expected.isZero() && !event.last_real.isZero();
+  record((event.current_real - event.current_expected).toNSec(), has_period,
+         has_period ? (event.current_real - event.last_real).toNSec()
+                      - (event.current_expected - event.last_expected).toNSec() : 0);
+}
+
+void TimerJitterMeasurement::record(const Clock::time_point& expected, const Clock::time_point& actual) const
+{
+  const std::shared_ptr<TimerJitterStatistics> statistics = getStatistics();
+  if (statistics)
+  {
+    statistics->accumulateCall(actual - expected, nullptr);
+  }
+}
+
+std::shared_ptr<TimerJitterStatistics> TimerJitterMeasurement::getStatistics() const
+{
+  Profiler::ProfileUpdate profile_update = profiler_->getProfile(name_);
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<TimerJitterStatistics>(formatter_);
+  }
+
+  std::shared_ptr<TimerJitterStatistics> statistics
+    = std::dynamic_pointer_cast<TimerJitterStatistics>(profile_update.profile);
+  if (!statistics)
+  {
+    ROS_WARN_NAMED("timer_jitter_measurement", "profiling measurement types do not match");
+  }
+  return statistics;
+}
+
+void TimerJitterMeasurement::record(
+  const std::int64_t lateness_ns, const bool has_period, const std::int64_t period_error_ns) const
+{
+  const std::shared_ptr<TimerJitterStatistics> statistics = getStatistics();
+  if (statistics)
+  {
+    const Clock::duration period_error
+      = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(period_error_ns));
+    statistics->accumulateCall(
+      std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(lateness_ns)),
+      has_period ? &period_error : nullptr);
+  }
+}
+
+void TimerJitterMeasurement::recordCallbackDuration(const Clock::duration& duration) const
+{
+  const std::shared_ptr<TimerJitterStatistics> statistics = getStatistics();
+  if (statistics)
+  {
+    statistics->accumulateCallbackDuration(duration);
+  }
+}
+
+}  // namespace arti_profiling
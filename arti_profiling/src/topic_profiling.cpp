@@ -0,0 +1,208 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/topic_profiling.h>
+#include <arti_profiling/simple_formatter.h>
+#include <boost/format.hpp>
+#include <map>
+#include <mutex>
+#include <ros/console.h>
+#include <utility>
+
+namespace arti_profiling
+{
+
+namespace
+{
+
+/// Statistics that stay in their profiler when it is cleared, as topic profilers keep using them.
+template<typename S>
+class TopicStatistics : public S
+{
+public:
+  using S::S;
+
+  bool reset() override
+  {
+    this->clear();
+    return true;
+  }
+};
+
+/// Returns the statistics with the given name in the given profiler, creating them if necessary.
+template<typename S>
+std::shared_ptr<S> getStatistics(Profiler& profiler, const std::string& name)
+{
+  Profiler::ProfileUpdate profile_update = profiler.getProfile(name);
+  if (!profile_update.profile)
+  {
+    profile_update.profile = std::make_shared<TopicStatistics<S>>();
+  }
+
+  std::shared_ptr<S> statistics = std::dynamic_pointer_cast<S>(profile_update.profile);
+  if (!statistics)
+  {
+    ROS_WARN_NAMED("topic_profiling", "profiling measurement types do not match");
+    statistics = std::make_shared<S>();  // Keep the topic working, although not reported
+  }
+  return statistics;
+}
+
+}  // namespace
+
+const MessageSizeStatistics::Formatter MessageSizeStatistics::DEFAULT_FORMATTER(SimpleFormatter<double>("B", 8));
+
+MessageSizeStatistics::MessageSizeStatistics(Formatter formatter)
+  : Statistics(std::move(formatter)), first_time_(Clock::now())
+{
+}
+
+void MessageSizeStatistics::clear()
+{
+  Lock lock(mutex_);
+  Statistics::clear();
+  first_time_ = Clock::now();
+}
+
+bool MessageSizeStatistics::takeSnapshot(ProfileSnapshot& snapshot) const
+{
+  Lock lock(mutex_);
+  Statistics::takeSnapshot(snapshot);
+  snapshot.type = "message_size";
+  snapshot.counters["interval_ns"] = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    Clock::now() - first_time_).count();
+  return true;
+}
+
+void MessageSizeStatistics::printAdditionalValues(std::ostream& out) const
+{
+  const double interval = std::chrono::duration_cast<std::chrono::duration<double>>(
+    Clock::now() - first_time_).count();
+  if (interval > 0.0)
+  {
+    out << boost::format(", %9.1f kB/s") % (sum_ / interval / 1000.0);
+  }
+}
+
+TopicProfiler::MessageProfiles::MessageProfiles(
+  Profiler& profiler, std::string rate_name, const std::string& size_name, std::string duration_name)
+  : rate_name(std::move(rate_name)), duration_name(std::move(duration_name)),
+    rate(getStatistics<FrequencyStatistics>(profiler, this->rate_name)),
+    size(getStatistics<MessageSizeStatistics>(profiler, size_name)),
+    duration(getStatistics<DurationStatistics>(profiler, this->duration_name))
+{
+}
+
+void TopicProfiler::MessageProfiles::accumulate(const std::size_t message_size) const
+{
+  FrequencyMeasurement(*rate, rate_name);
+  size->accumulate(static_cast<double>(message_size));
+}
+
+TopicProfiler::TopicProfiler(Profiler& parent, const std::string& topic)
+  : profiler_(parent, topic)
+{
+}
+
+std::shared_ptr<TopicProfiler> TopicProfiler::get(Profiler& parent, const std::string& topic)
+{
+  // Topic profilers are kept alive by their subscribers and publishers only:
+  static std::mutex mutex;
+  static std::map<std::pair<Profiler*, std::string>, std::weak_ptr<TopicProfiler>> topic_profilers;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::weak_ptr<TopicProfiler>& entry = topic_profilers[std::make_pair(&parent, topic)];
+  std::shared_ptr<TopicProfiler> topic_profiler = entry.lock();
+  if (!topic_profiler)
+  {
+    // Forget the topic profilers that expired meanwhile:
+    for (auto it = topic_profilers.begin(); it != topic_profilers.end();)
+    {
+      it = it->second.expired() && &it->second != &entry ? topic_profilers.erase(it) : std::next(it);
+    }
+
+    topic_profiler = std::make_shared<TopicProfiler>(parent, topic);
+    entry = topic_profiler;
+  }
+  return topic_profiler;
+}
+
+Profiler& TopicProfiler::getProfiler()
+{
+  return profiler_;
+}
+
+const TopicProfiler::MessageProfiles& TopicProfiler::getReceivedProfiles()
+{
+  std::call_once(received_profiles_flag_, [this]()
+  {
+    received_profiles_.reset(new MessageProfiles(profiler_, "receive rate", "received size", "callback"));
+  });
+  return *received_profiles_;
+}
+
+const TopicProfiler::MessageProfiles& TopicProfiler::getPublishedProfiles()
+{
+  std::call_once(published_profiles_flag_, [this]()
+  {
+    published_profiles_.reset(new MessageProfiles(profiler_, "publish rate", "published size", "publish"));
+  });
+  return *published_profiles_;
+}
+
+ProfiledPublisher::ProfiledPublisher(Profiler& profiler, ros::Publisher publisher)
+  : publisher_(std::move(publisher))
+{
+  if (publisher_)
+  {
+    topic_profiler_ = TopicProfiler::get(profiler, publisher_.getTopic());
+    profiles_ = &topic_profiler_->getPublishedProfiles();
+  }
+}
+
+const ros::Publisher& ProfiledPublisher::getPublisher() const
+{
+  return publisher_;
+}
+
+std::string ProfiledPublisher::getTopic() const
+{
+  return publisher_.getTopic();
+}
+
+std::uint32_t ProfiledPublisher::getNumSubscribers() const
+{
+  return publisher_.getNumSubscribers();
+}
+
+void ProfiledPublisher::shutdown()
+{
+  publisher_.shutdown();
+  profiles_ = nullptr;
+  topic_profiler_.reset();
+}
+
+}  // namespace arti_profiling
@@ -0,0 +1,106 @@
+/*
+ * This file is part of the software provided by the Graz University of Technology AIS group.
+ *
+ * Copyright (c) 2017, Alexander Buchegger
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted  provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ *    disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+ *    following disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote
+ *    products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <arti_profiling/wakeup_latency_probe.h>
+#include <arti_profiling/duration_measurement.h>
+#include <cstring>
+#include <ctime>
+#include <pthread.h>
+#include <ros/console.h>
+#include <sched.h>
+
+namespace arti_profiling
+{
+
+WakeupLatencyProbe::WakeupLatencyProbe(
+  Profiler& profiler, const std::string& name, const Clock::duration& interval, const int priority, const int cpu)
+  : profile_(RealTimeDurationMeasurement(profiler, name, SimpleDurationFormatter<std::chrono::microseconds>(6))
+               .getProfile()),
+    interval_(interval), priority_(priority), cpu_(cpu)
+{
+  thread_ = std::thread(&WakeupLatencyProbe::run, this);
+}
+
+WakeupLatencyProbe::~WakeupLatencyProbe()
+{
+  stopped_ = true;
+  thread_.join();
+}
+
+void WakeupLatencyProbe::run()
+{
+  if (cpu_ >= 0)
+  {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu_, &cpus);
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (result != 0)
+    {
+      ROS_WARN_NAMED("wakeup_latency_probe", "cannot pin wakeup latency probe to CPU %d: %s", cpu_,
+                     std::strerror(result));
+    }
+  }
+  if (priority_ > 0)
+  {
+    sched_param parameters{};
+    parameters.sched_priority = priority_;
+    const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+    if (result != 0)
+    {
+      ROS_WARN_NAMED("wakeup_latency_probe", "cannot run wakeup latency probe with real-time priority %d: %s",
+                     priority_, std::strerror(result));
+    }
+  }
+
+  // The steady clock is CLOCK_MONOTONIC on Linux, so its time points can be used for absolute sleeps directly:
+  const std::int64_t interval_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(interval_).count();
+  timespec next{};
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  while (!stopped_)
+  {
+    next.tv_nsec += interval_ns;
+    next.tv_sec += next.tv_nsec / 1000000000;
+    next.tv_nsec %= 1000000000;
+    if (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) != 0)
+    {
+      continue;  // Interrupted by a signal
+    }
+
+    timespec now{};
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const std::int64_t latency_ns = (now.tv_sec - next.tv_sec) * 1000000000 + (now.tv_nsec - next.tv_nsec);
+    profile_->commit(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(latency_ns)));
+
+    if (latency_ns > interval_ns)
+    {
+      // Don't try to catch up with missed wakeups, which would record a burst of bogus latencies:
+      next = now;
+    }
+  }
+}
+
+}  // namespace arti_profiling
@@ -0,0 +1,139 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/async_log_sink.h>
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_streambuf.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using arti_profiling::AsyncLogSink;
+
+static bool exists(const std::string& file_name)
+{
+  struct stat status{};
+  return ::stat(file_name.c_str(), &status) == 0;
+}
+
+static std::string readCompressed(const std::string& file_name)
+{
+  std::ifstream in(file_name, std::ios::in | std::ios::binary);
+  boost::iostreams::filtering_streambuf<boost::iostreams::input> decompressor;
+  decompressor.push(boost::iostreams::gzip_decompressor());
+  decompressor.push(in);
+  std::ostringstream out;
+  boost::iostreams::copy(decompressor, out);
+  return out.str();
+}
+
+class TestAsyncLogSink : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char directory[] = "/tmp/test_async_log_sink_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(directory));
+    directory_ = directory;
+  }
+
+  void TearDown() override
+  {
+    for (int i = 0; i < 10; ++i)
+    {
+      std::remove(getFileName(i).c_str());
+      std::remove((getFileName(i) + ".gz").c_str());
+    }
+    std::remove(directory_.c_str());
+  }
+
+  AsyncLogSink::FileOptions getFileOptions() const
+  {
+    AsyncLogSink::FileOptions options;
+    options.directory = directory_;
+    options.base_name = "test";
+    options.max_file_size = 10;
+    options.max_file_count = 3;
+    options.compress = true;
+    return options;
+  }
+
+  std::string getFileName(const int index) const
+  {
+    return directory_ + "/test_" + std::to_string(::getpid()) + "_" + std::to_string(index) + ".log";
+  }
+
+  /// Writes the records one by one, so that each after the first one rotates the file.
+  static void writeRecords(AsyncLogSink& sink, const int count)
+  {
+    for (int i = 0; i < count; ++i)
+    {
+      EXPECT_TRUE(sink.write("record " + std::to_string(i) + " of the test\n"));
+      sink.flush();
+    }
+  }
+
+  std::string directory_;
+};
+
+TEST_F(TestAsyncLogSink, testStream)
+{
+  std::ostringstream out;
+  {
+    AsyncLogSink sink(out, 16);
+    EXPECT_TRUE(sink.write("first\n"));
+    EXPECT_FALSE(sink.write("longer than the buffer\n"));
+    sink.flush();
+    EXPECT_EQ("first\n", out.str());
+    EXPECT_TRUE(sink.write("second\n"));
+    EXPECT_EQ(1u, sink.getDroppedCount());
+    EXPECT_TRUE(sink.getFileName().empty());
+  }
+  EXPECT_EQ("first\nsecond\n", out.str());
+}
+
+TEST_F(TestAsyncLogSink, testRotation)
+{
+  {
+    AsyncLogSink sink(getFileOptions());
+    writeRecords(sink, 5);
+    EXPECT_EQ(getFileName(4), sink.getFileName());
+  }
+
+  // Only the last files are kept, and all but the current one are compressed:
+  EXPECT_FALSE(exists(getFileName(0) + ".gz"));
+  EXPECT_FALSE(exists(getFileName(1) + ".gz"));
+  EXPECT_FALSE(exists(getFileName(2)));
+  EXPECT_EQ("record 2 of the test\n", readCompressed(getFileName(2) + ".gz"));
+  EXPECT_EQ("record 3 of the test\n", readCompressed(getFileName(3) + ".gz"));
+  EXPECT_TRUE(exists(getFileName(4)));
+}
+
+TEST_F(TestAsyncLogSink, testCompressionFailure)
+{
+  // A directory in place of the compressed file makes compressing fail:
+  const std::string blocked_file_name = getFileName(1) + ".gz";
+  ASSERT_EQ(0, ::mkdir(blocked_file_name.c_str(), 0700));
+  {
+    AsyncLogSink sink(getFileOptions());
+    writeRecords(sink, 4);
+  }
+
+  // The uncompressed file is kept instead, and is still counted:
+  std::ifstream file(getFileName(1));
+  std::stringstream content;
+  content << file.rdbuf();
+  EXPECT_EQ("record 1 of the test\n", content.str());
+  EXPECT_TRUE(exists(blocked_file_name));
+  EXPECT_FALSE(exists(getFileName(0) + ".gz"));
+  EXPECT_TRUE(exists(getFileName(2) + ".gz"));
+  EXPECT_TRUE(exists(getFileName(3)));
+  std::remove(blocked_file_name.c_str());
+}
@@ -0,0 +1,115 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/bench.h>
+#include <arti_profiling/snapshot.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using arti_profiling::bench::Result;
+using arti_profiling::bench::Runner;
+
+/// Makes the confidence interval computation accessible to tests.
+class TestableRunner : public Runner
+{
+public:
+  using Runner::Runner;
+  using Runner::computeConfidenceInterval;
+};
+
+static arti_profiling::bench::Options getFastOptions()
+{
+  arti_profiling::bench::Options options;
+  options.warmup_time = std::chrono::milliseconds(1);
+  options.min_repetition_time = std::chrono::milliseconds(2);
+  options.repetitions = 5;
+  return options;
+}
+
+TEST(TestBench, testRun)
+{
+  Runner runner(getFastOptions());
+  std::uint64_t call_count = 0;
+  const Result result = runner.run("increment", [&call_count]
+  {
+    ++call_count;
+    arti_profiling::bench::doNotOptimize(call_count);
+  });
+
+  EXPECT_EQ("increment", result.name);
+  EXPECT_GE(result.iterations, 1u);
+  ASSERT_EQ(5u, result.repetitions.size());
+  EXPECT_EQ(5u, result.histogram.getCount());
+  EXPECT_GT(call_count, 5 * result.iterations);  // Plus the warm-up and calibration
+  EXPECT_LE(result.ci_lower, result.mean);
+  EXPECT_GE(result.ci_upper, result.mean);
+
+  std::ostringstream out;
+  runner.print(out);
+  EXPECT_EQ(0u, out.str().find("increment"));
+  EXPECT_NE(std::string::npos, out.str().find("5 x "));
+}
+
+TEST(TestBench, testCalibration)
+{
+  Runner runner(getFastOptions());
+  const Result& result = runner.run("sleep", []
+  {
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  });
+
+  // Each repetition takes at least the minimum repetition time, with as few iterations as needed:
+  EXPECT_GE(result.mean, 2e5);
+  for (const double repetition : result.repetitions)
+  {
+    EXPECT_GE(repetition * result.iterations, 2e6);
+  }
+  EXPECT_LE(result.iterations, 10u);
+}
+
+TEST(TestBench, testConfidenceInterval)
+{
+  TestableRunner runner(getFastOptions());
+  Result result;
+  result.repetitions = {1.0, 2.0, 3.0, 4.0, 5.0};
+  runner.computeConfidenceInterval(result);
+  EXPECT_DOUBLE_EQ(3.0, result.mean);
+  EXPECT_GT(result.ci_lower, 1.0);
+  EXPECT_LT(result.ci_lower, 3.0);
+  EXPECT_GT(result.ci_upper, 3.0);
+  EXPECT_LT(result.ci_upper, 5.0);
+
+  // The fixed seed makes the interval reproducible:
+  Result same_result;
+  same_result.repetitions = result.repetitions;
+  runner.computeConfidenceInterval(same_result);
+  EXPECT_EQ(result.ci_lower, same_result.ci_lower);
+  EXPECT_EQ(result.ci_upper, same_result.ci_upper);
+
+  // A single repetition has no spread:
+  result.repetitions = {2.0};
+  runner.computeConfidenceInterval(result);
+  EXPECT_EQ(2.0, result.ci_lower);
+  EXPECT_EQ(2.0, result.ci_upper);
+}
+
+TEST(TestBench, testSnapshot)
+{
+  Runner runner(getFastOptions());
+  runner.run("first", [] {});
+  runner.run("second", [] {});
+
+  const arti_profiling::ProfilerSnapshot snapshot = runner.takeSnapshot();
+  EXPECT_EQ("benchmarks", snapshot.name);
+  ASSERT_EQ(2u, snapshot.profiles.size());
+  const arti_profiling::ProfileSnapshot& first = snapshot.profiles.at("first");
+  EXPECT_EQ("duration", first.type);
+  EXPECT_EQ(5u, first.count);
+  EXPECT_EQ(static_cast<std::int64_t>(runner.getResults().front().iterations), first.counters.at("iterations"));
+  EXPECT_LE(first.min.toDouble(), first.max.toDouble());
+  EXPECT_LE(first.counters.at("ci_lower_ns"), first.counters.at("ci_upper_ns"));
+}
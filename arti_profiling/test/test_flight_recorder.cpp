@@ -0,0 +1,145 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/flight_recorder.h>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using arti_profiling::FlightRecorder;
+
+class TestFlightRecorder : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char directory[] = "/tmp/test_flight_recorder_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(directory));
+    directory_ = directory;
+    FlightRecorder::setDumpDirectory(directory_);
+    FlightRecorder::setEnabled(true);
+  }
+
+  void TearDown() override
+  {
+    for (const std::string& file_name : file_names_)
+    {
+      std::remove(file_name.c_str());
+    }
+    std::remove(directory_.c_str());
+    FlightRecorder::setCapacity(FlightRecorder::DEFAULT_CAPACITY);
+  }
+
+  /// Dumps the events and returns those whose name starts with the given prefix, in the order of the dump.
+  std::vector<boost::property_tree::ptree> dump(const std::string& reason, const std::string& name_prefix)
+  {
+    const std::string file_name = FlightRecorder::dump(reason);
+    EXPECT_FALSE(file_name.empty());
+    file_names_.push_back(file_name);
+
+    boost::property_tree::ptree trace;
+    boost::property_tree::read_json(file_name, trace);
+    EXPECT_EQ(reason, trace.get<std::string>("otherData.reason"));
+
+    std::vector<boost::property_tree::ptree> events;
+    for (const auto& event : trace.get_child("traceEvents"))
+    {
+      if (event.second.get<std::string>("name").compare(0, name_prefix.size(), name_prefix) == 0)
+      {
+        events.push_back(event.second);
+      }
+    }
+    return events;
+  }
+
+  std::string directory_;
+  std::vector<std::string> file_names_;
+};
+
+TEST_F(TestFlightRecorder, testRoundTrip)
+{
+  std::thread([]
+  {
+    FlightRecorder::recordDuration("round trip \"duration\"", FlightRecorder::Clock::time_point(
+      std::chrono::microseconds(1000)), std::chrono::nanoseconds(2500));
+    FlightRecorder::recordCounter("round trip counter", -1.25);
+    FlightRecorder::recordMarker("round trip marker with a name longer than the maximum length");
+  }).join();
+
+  const std::vector<boost::property_tree::ptree> events = dump("round trip", "round trip");
+  ASSERT_EQ(3u, events.size());
+
+  EXPECT_EQ("round trip \"duration\"", events[0].get<std::string>("name"));
+  EXPECT_EQ("X", events[0].get<std::string>("ph"));
+  EXPECT_DOUBLE_EQ(1000.0, events[0].get<double>("ts"));
+  EXPECT_DOUBLE_EQ(2.5, events[0].get<double>("dur"));
+
+  EXPECT_EQ("C", events[1].get<std::string>("ph"));
+  EXPECT_DOUBLE_EQ(-1.25, events[1].get<double>("args.value"));
+
+  EXPECT_EQ(std::string("round trip marker with a name longer").substr(0, FlightRecorder::MAX_NAME_LENGTH),
+            events[2].get<std::string>("name"));
+  EXPECT_EQ("i", events[2].get<std::string>("ph"));
+  EXPECT_EQ(events[0].get<std::string>("tid"), events[2].get<std::string>("tid"));
+}
+
+TEST_F(TestFlightRecorder, testWrapAround)
+{
+  FlightRecorder::setCapacity(8);
+  std::thread([]
+  {
+    for (int i = 0; i < 20; ++i)
+    {
+      FlightRecorder::recordMarker("wrap around " + std::to_string(i));
+    }
+  }).join();
+
+  // Only the last events of the thread are kept, oldest first:
+  const std::vector<boost::property_tree::ptree> events = dump("wrap around", "wrap around ");
+  ASSERT_EQ(8u, events.size());
+  for (std::size_t i = 0; i < events.size(); ++i)
+  {
+    EXPECT_EQ("wrap around " + std::to_string(12 + i), events[i].get<std::string>("name"));
+  }
+}
+
+/// Records an event when destroyed, which happens after the flight recorder has released the thread's ring if it
+/// was constructed before the thread recorded its first event.
+struct RecordOnThreadExit
+{
+  ~RecordOnThreadExit()
+  {
+    FlightRecorder::recordMarker("thread exit");
+  }
+
+  void touch()
+  {
+  }
+};
+
+static thread_local RecordOnThreadExit record_on_thread_exit;  // Constructed in each thread on its first use
+
+TEST_F(TestFlightRecorder, testRecordAfterThreadExit)
+{
+  std::thread([]
+  {
+    record_on_thread_exit.touch();
+    FlightRecorder::recordMarker("thread start");
+  }).join();
+
+  // Another thread reuses the released ring:
+  std::thread([]
+  {
+    FlightRecorder::recordMarker("thread reusing the ring");
+  }).join();
+
+  EXPECT_EQ(1u, dump("thread exit", "thread start").size());
+  EXPECT_TRUE(dump("thread exit", "thread exit").empty());
+}
@@ -0,0 +1,72 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/flight_recorder.h>
+#include <arti_profiling/overhead.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+TEST(TestOverhead, testCalibration)
+{
+  EXPECT_FALSE(arti_profiling::isCalibratingOverhead());
+  const arti_profiling::OverheadCalibration calibration = arti_profiling::calibrateOverhead();
+  EXPECT_FALSE(arti_profiling::isCalibratingOverhead());
+
+  EXPECT_GT(calibration.clock_read, 0.0);
+  EXPECT_GT(calibration.lock, 0.0);
+  EXPECT_GT(calibration.commit, 0.0);
+  EXPECT_DOUBLE_EQ(2.0 * calibration.clock_read + calibration.commit, calibration.getMeasurementCost());
+  EXPECT_EQ(&arti_profiling::getOverheadCalibration(), &arti_profiling::getOverheadCalibration());
+}
+
+TEST(TestOverhead, testCalibrationIsNotTraced)
+{
+  char directory[] = "/tmp/test_overhead_XXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(directory));
+  arti_profiling::FlightRecorder::setDumpDirectory(directory);
+  arti_profiling::FlightRecorder::setEnabled(true);
+
+  arti_profiling::calibrateOverhead();
+  {
+    arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+    arti_profiling::DurationMeasurement measurement(profiler, "traced");
+  }
+
+  const std::string file_name = arti_profiling::FlightRecorder::dump("test");
+  ASSERT_FALSE(file_name.empty());
+  std::ifstream file(file_name);
+  std::stringstream trace;
+  trace << file.rdbuf();
+  EXPECT_NE(std::string::npos, trace.str().find("\"traced\""));
+  EXPECT_EQ(std::string::npos, trace.str().find("\"calibration\""));
+  std::remove(file_name.c_str());
+  std::remove(directory);
+}
+
+TEST(TestOverhead, testCompensation)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::setOverheadCompensationEnabled(true);
+  const arti_profiling::DurationMeasurement::Clock::time_point time = arti_profiling::DurationMeasurement::Clock::now();
+  arti_profiling::DurationMeasurement(profiler, "compensated", time).stop(time);
+  arti_profiling::setOverheadCompensationEnabled(false);
+  EXPECT_FALSE(arti_profiling::isOverheadCompensationEnabled());
+
+  // The clock read is subtracted, but durations don't become negative:
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("compensated", snapshot));
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_EQ(0, snapshot.max.to<std::int64_t>());
+
+  std::ostringstream statistics;
+  arti_profiling::Profiler::getRootInstance().printStatistics(statistics);
+  EXPECT_NE(std::string::npos, statistics.str().find("estimated profiling overhead"));
+}
@@ -0,0 +1,105 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/pipeline_profiler.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <chrono>
+#include <gtest/gtest.h>
+
+using arti_profiling::PipelineProfiler;
+using std::chrono::milliseconds;
+
+/// A diamond: the camera's images are processed by detect and segment in parallel, whose results fuse joins.
+class TestPipelineProfiler : public ::testing::Test
+{
+protected:
+  TestPipelineProfiler()
+    : profiler_(arti_profiling::Profiler::getRootInstance(), "test"), pipeline_(profiler_, "pipeline"),
+      start_(PipelineProfiler::Clock::now())
+  {
+    // Declared in another order than they run, to check that the connections don't depend on it:
+    pipeline_.addStage("fuse", {"objects", "segments"}, {});
+    pipeline_.addStage("camera", {}, {"images"});
+    pipeline_.addStage("detect", {"images"}, {"objects"});
+    pipeline_.addStage("segment", {"images"}, {"segments"});
+  }
+
+  void process(const std::string& stage, const PipelineProfiler::ItemId id, const int begin, const int end)
+  {
+    pipeline_.beginStage(stage, id, start_ + milliseconds(begin));
+    pipeline_.endStage(stage, id, start_ + milliseconds(end));
+  }
+
+  arti_profiling::ProfileSnapshot takeSnapshot()
+  {
+    arti_profiling::ProfileSnapshot snapshot;
+    EXPECT_TRUE(profiler_.takeSnapshot("pipeline", snapshot));
+    return snapshot;
+  }
+
+  arti_profiling::Profiler profiler_;
+  PipelineProfiler pipeline_;
+  PipelineProfiler::Clock::time_point start_;
+};
+
+TEST_F(TestPipelineProfiler, testCriticalPath)
+{
+  pipeline_.startItem(1, start_);
+  process("camera", 1, 0, 10);
+  process("segment", 1, 10, 40);
+  process("detect", 1, 12, 20);
+  process("fuse", 1, 45, 50);
+
+  arti_profiling::ProfileSnapshot snapshot = takeSnapshot();
+  EXPECT_EQ("pipeline", snapshot.type);
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_DOUBLE_EQ(50e6, snapshot.max.toDouble());
+
+  // The join waits for the input finished last, which puts segment on the critical path instead of detect:
+  EXPECT_EQ(1, snapshot.labels.at("stage=segment").counters.at("critical"));
+  EXPECT_EQ(30000000, snapshot.labels.at("stage=segment").counters.at("critical_ns"));
+  EXPECT_EQ(0, snapshot.labels.at("stage=detect").counters.at("critical"));
+  EXPECT_DOUBLE_EQ(2e6, snapshot.labels.at("stage=detect").labels.at("queue").max.toDouble());
+  EXPECT_DOUBLE_EQ(5e6, snapshot.labels.at("stage=fuse").labels.at("queue").max.toDouble());
+  EXPECT_DOUBLE_EQ(5e6, snapshot.labels.at("stage=fuse").max.toDouble());
+  EXPECT_EQ(1, snapshot.labels.at("stage=detect").counters.at("max_backlog"));
+}
+
+TEST_F(TestPipelineProfiler, testDroppedItems)
+{
+  pipeline_.setMaxItemsInFlight(2);
+  process("camera", 1, 0, 10);
+  process("camera", 2, 10, 20);
+  process("camera", 3, 20, 30);  // Drops the oldest item, which leaves the backlogs before this one enters them
+  pipeline_.dropItem(2);
+  pipeline_.dropItem(2);  // Unknown by now
+
+  arti_profiling::ProfileSnapshot snapshot = takeSnapshot();
+  EXPECT_EQ(2, snapshot.counters.at("dropped"));
+  EXPECT_EQ(0u, snapshot.count);
+  EXPECT_EQ(2, snapshot.labels.at("stage=detect").counters.at("max_backlog"));
+
+  // Dropped items left the backlogs, so only the remaining item is still waiting:
+  pipeline_.getProfile()->reset();
+  snapshot = takeSnapshot();
+  EXPECT_EQ(0, snapshot.counters.at("dropped"));
+  EXPECT_EQ(1, snapshot.labels.at("stage=detect").counters.at("max_backlog"));
+}
+
+TEST_F(TestPipelineProfiler, testItemsInFlightAcrossReset)
+{
+  process("camera", 1, 0, 10);
+  pipeline_.getProfile()->reset();
+  process("detect", 1, 10, 20);
+  process("segment", 1, 10, 30);
+  process("unknown", 1, 30, 40);
+  process("fuse", 1, 30, 40);
+
+  arti_profiling::ProfileSnapshot snapshot = takeSnapshot();
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_DOUBLE_EQ(40e6, snapshot.max.toDouble());
+  EXPECT_EQ(0u, snapshot.labels.at("stage=camera").count);
+  EXPECT_EQ(1, snapshot.labels.at("stage=camera").counters.at("critical"));
+}
@@ -0,0 +1,109 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/profiled_mutex.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <chrono>
+#include <condition_variable>
+#include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
+
+TEST(TestProfiledMutex, testUncontended)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ProfiledMutex mutex(profiler, "mutex");
+
+  for (int i = 0; i < 10; ++i)
+  {
+    std::lock_guard<arti_profiling::ProfiledMutex> lock(mutex);
+  }
+  ASSERT_TRUE(mutex.try_lock());
+  bool locked_elsewhere = true;
+  std::thread([&mutex, &locked_elsewhere] { locked_elsewhere = mutex.try_lock(); }).join();
+  EXPECT_FALSE(locked_elsewhere);
+  mutex.unlock();
+
+  EXPECT_EQ(11u, mutex.getStatistics()->getAcquisitionCount());
+  EXPECT_EQ(0u, mutex.getStatistics()->getContendedCount());
+
+  // Hold times are not recorded by default:
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("mutex", snapshot));
+  EXPECT_EQ("lock", snapshot.type);
+  EXPECT_EQ(0u, snapshot.count);
+  EXPECT_EQ(11u, snapshot.counters["acquisitions"]);
+}
+
+TEST(TestProfiledMutex, testHoldTimes)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ProfiledRecursiveMutex mutex(profiler, "mutex", true);
+
+  {
+    std::lock_guard<arti_profiling::ProfiledRecursiveMutex> lock(mutex);
+    std::lock_guard<arti_profiling::ProfiledRecursiveMutex> nested_lock(mutex);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  // Nested locks are neither counted nor timed:
+  EXPECT_EQ(1u, mutex.getStatistics()->getAcquisitionCount());
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("mutex", snapshot));
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_GE(snapshot.max.toDouble(), 2e6);
+}
+
+TEST(TestProfiledMutex, testContended)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ProfiledMutex mutex(profiler, "mutex");
+
+  std::unique_lock<arti_profiling::ProfiledMutex> lock(mutex);
+  std::thread waiter([&mutex]
+  {
+    std::lock_guard<arti_profiling::ProfiledMutex> waiter_lock(mutex);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));  // Let the waiter block
+  lock.unlock();
+  waiter.join();
+
+  EXPECT_EQ(2u, mutex.getStatistics()->getAcquisitionCount());
+  EXPECT_EQ(1u, mutex.getStatistics()->getContendedCount());
+  const auto top_waits = mutex.getStatistics()->getWaitStatistics().getTopSamples();
+  ASSERT_EQ(1u, top_waits.size());
+  EXPECT_EQ(0u, top_waits.front().tag.find("holder "));
+  EXPECT_EQ(std::string::npos, top_waits.front().tag.find("unknown"));
+}
+
+TEST(TestProfiledMutex, testSharedAndConditionVariable)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ProfiledSharedMutex mutex(profiler, "mutex");
+
+  mutex.lock_shared();
+  ASSERT_TRUE(mutex.try_lock_shared());
+  mutex.unlock_shared();
+  mutex.unlock_shared();
+
+  std::condition_variable_any condition;
+  bool ready = false;
+  std::thread notifier([&]
+  {
+    std::lock_guard<arti_profiling::ProfiledSharedMutex> lock(mutex);
+    ready = true;
+    condition.notify_one();
+  });
+  {
+    std::unique_lock<arti_profiling::ProfiledSharedMutex> lock(mutex);
+    condition.wait(lock, [&ready] { return ready; });
+  }
+  notifier.join();
+
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("mutex", snapshot));
+  EXPECT_EQ(2u, snapshot.counters["shared_acquisitions"]);
+  EXPECT_LE(4u, snapshot.counters["acquisitions"]);
+}
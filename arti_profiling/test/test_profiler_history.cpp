@@ -0,0 +1,103 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+static void measure(arti_profiling::Profiler& profiler, const std::string& name, const int count)
+{
+  for (int i = 0; i < count; ++i)
+  {
+    arti_profiling::DurationMeasurement measurement(profiler, name);
+  }
+}
+
+TEST(TestProfilerHistory, testHistory)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::Profiler child(profiler, "child");
+  profiler.setHistoryCapacity(2);
+
+  for (int interval = 1; interval <= 3; ++interval)
+  {
+    measure(profiler, "parent profile", interval);
+    measure(child, "child profile", 10 * interval);
+    profiler.clear();
+  }
+
+  const std::vector<arti_profiling::ProfilerSnapshot> history = profiler.getHistory();
+  ASSERT_EQ(2u, history.size());
+  EXPECT_LT(history[0].time, history[1].time);
+  EXPECT_EQ(2u, history[0].profiles.at("parent profile").count);
+  EXPECT_EQ(3u, history[1].profiles.at("parent profile").count);
+  EXPECT_TRUE(history[1].children.empty());
+  EXPECT_TRUE(history[1].profiles.at("parent profile").top_samples.empty());
+
+  // The children inherit the capacity:
+  const std::vector<arti_profiling::ProfilerSnapshot> child_history = profiler.getHistory("child");
+  ASSERT_EQ(2u, child_history.size());
+  EXPECT_EQ(30u, child_history[1].profiles.at("child profile").count);
+  EXPECT_TRUE(profiler.getHistory("unknown").empty());
+
+  arti_profiling::ProfilerSnapshot snapshot;
+  EXPECT_FALSE(profiler.getHistoricSnapshot(history[0].time - 1, snapshot));
+  ASSERT_TRUE(profiler.getHistoricSnapshot(history[1].time - 1, snapshot));
+  EXPECT_EQ(2u, snapshot.profiles.at("parent profile").count);
+  const arti_profiling::ProfilerSnapshot* child_snapshot = snapshot.findChild("child");
+  ASSERT_NE(nullptr, child_snapshot);
+  EXPECT_EQ(20u, child_snapshot->profiles.at("child profile").count);
+}
+
+TEST(TestProfilerHistory, testMemoryUsage)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  measure(profiler, "profile", 1);
+  profiler.clear();
+  const std::size_t memory_usage = profiler.getMemoryUsage();
+
+  profiler.setHistoryCapacity(10);
+  for (int interval = 0; interval < 10; ++interval)
+  {
+    measure(profiler, "profile", 1);
+    profiler.clear();
+  }
+  const std::vector<arti_profiling::ProfilerSnapshot> history = profiler.getHistory();
+  ASSERT_EQ(10u, history.size());
+  EXPECT_GE(profiler.getMemoryUsage(), memory_usage + 10 * history.front().getMemoryUsage());
+
+  profiler.setHistoryCapacity(1);
+  profiler.clear();
+  EXPECT_LT(profiler.getMemoryUsage(), memory_usage + 2 * history.front().getMemoryUsage());
+}
+
+TEST(TestProfilerHistory, testMemoryLimit)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  profiler.setProfileLimit(0);
+  const std::size_t empty_memory_usage = profiler.getMemoryUsage();
+  measure(profiler, "first", 1);
+  const std::size_t profile_memory_usage = profiler.getMemoryUsage() - empty_memory_usage;
+  profiler.setMemoryLimit(empty_memory_usage + 20 * profile_memory_usage);
+  profiler.setHistoryCapacity(100);
+
+  // The history soon exceeds the memory limit, but must not keep the live profiles from being created:
+  for (int interval = 0; interval < 100; ++interval)
+  {
+    for (int i = 0; i < 10; ++i)
+    {
+      measure(profiler, "profile " + std::to_string(i), 1);
+    }
+    profiler.clear();
+  }
+  EXPECT_GT(profiler.getMemoryUsage(), empty_memory_usage + 100 * profile_memory_usage);
+
+  const std::vector<arti_profiling::ProfilerSnapshot> history = profiler.getHistory();
+  ASSERT_EQ(100u, history.size());
+  EXPECT_EQ(10u, history.back().profiles.size());
+  EXPECT_EQ(0u, history.back().profiles.count(arti_profiling::Profiler::OVERFLOW_PROFILE_NAME));
+}
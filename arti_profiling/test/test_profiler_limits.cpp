@@ -0,0 +1,108 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/gauge.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <gtest/gtest.h>
+#include <string>
+
+static void measure(arti_profiling::Profiler& profiler, const std::string& name)
+{
+  arti_profiling::DurationMeasurement measurement(profiler, name);
+}
+
+static bool hasProfile(const arti_profiling::Profiler& profiler, const std::string& name)
+{
+  arti_profiling::ProfileSnapshot snapshot;
+  return profiler.takeSnapshot(name, snapshot);
+}
+
+TEST(TestProfilerLimits, testOverflowBucket)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  profiler.setProfileLimit(3);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    measure(profiler, "profile " + std::to_string(i));
+  }
+
+  const arti_profiling::ProfilerSnapshot snapshot = profiler.takeSnapshot();
+  ASSERT_EQ(4u, snapshot.profiles.size());
+  EXPECT_TRUE(hasProfile(profiler, "profile 2"));
+  EXPECT_FALSE(hasProfile(profiler, "profile 3"));
+  EXPECT_EQ(7u, snapshot.profiles.at(arti_profiling::Profiler::OVERFLOW_PROFILE_NAME).count);
+}
+
+TEST(TestProfilerLimits, testOverflowOfDifferentTypes)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  profiler.setProfileLimit(2);
+  measure(profiler, "duration");
+  arti_profiling::GaugeMeasurement(profiler, "gauge", 1.0);
+
+  // The overflow bucket counts the updates of new profiles of any type:
+  for (int i = 0; i < 5; ++i)
+  {
+    measure(profiler, "duration " + std::to_string(i));
+    arti_profiling::GaugeMeasurement(profiler, "gauge " + std::to_string(i), 1.0);
+  }
+
+  const arti_profiling::ProfilerSnapshot snapshot = profiler.takeSnapshot();
+  ASSERT_EQ(3u, snapshot.profiles.size());
+  const arti_profiling::ProfileSnapshot& overflow
+    = snapshot.profiles.at(arti_profiling::Profiler::OVERFLOW_PROFILE_NAME);
+  EXPECT_EQ("overflow", overflow.type);
+  EXPECT_EQ(10u, overflow.count);
+  EXPECT_EQ("duration", snapshot.profiles.at("duration").type);
+  EXPECT_EQ("gauge", snapshot.profiles.at("gauge").type);
+}
+
+TEST(TestProfilerLimits, testEvictColdest)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  profiler.setProfileLimit(3);
+  profiler.setLimitPolicy(arti_profiling::Profiler::LimitPolicy::EVICT_COLDEST);
+
+  measure(profiler, "a");
+  measure(profiler, "b");
+  measure(profiler, "c");
+  measure(profiler, "a");
+  measure(profiler, "d");
+
+  EXPECT_TRUE(hasProfile(profiler, "a"));
+  EXPECT_FALSE(hasProfile(profiler, "b"));
+  EXPECT_TRUE(hasProfile(profiler, "c"));
+  EXPECT_TRUE(hasProfile(profiler, "d"));
+  EXPECT_FALSE(hasProfile(profiler, arti_profiling::Profiler::OVERFLOW_PROFILE_NAME));
+}
+
+TEST(TestProfilerLimits, testMemoryLimit)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  profiler.setProfileLimit(0);
+  const std::size_t empty_memory_usage = profiler.getMemoryUsage();
+  measure(profiler, "first");
+  const std::size_t profile_memory_usage = profiler.getMemoryUsage() - empty_memory_usage;
+  profiler.setMemoryLimit(empty_memory_usage + 100 * profile_memory_usage);
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    measure(profiler, "profile " + std::to_string(i));
+  }
+
+  // The estimate is only fully updated every few new names, but adjusted for each one of them, so the limit holds
+  // within the growth of the profiles since their creation:
+  const std::size_t profile_count = profiler.takeSnapshot().profiles.size();
+  EXPECT_GT(profile_count, 50u);
+  EXPECT_LE(profile_count, 102u);
+  EXPECT_TRUE(hasProfile(profiler, arti_profiling::Profiler::OVERFLOW_PROFILE_NAME));
+
+  profiler.clear();
+  EXPECT_FALSE(hasProfile(profiler, "first"));
+  measure(profiler, "after clear");
+  EXPECT_TRUE(hasProfile(profiler, "after clear"));
+}
@@ -0,0 +1,141 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/profiling_diagnostics.h>
+#include <chrono>
+#include <diagnostic_msgs/DiagnosticStatus.h>
+#include <diagnostic_updater/diagnostic_updater.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <ros/init.h>
+#include <string>
+
+/// Evaluates the statuses directly, as the updater only publishes them.
+class TestableProfilingDiagnostics : public arti_profiling::ProfilingDiagnostics
+{
+public:
+  using ProfilingDiagnostics::ProfilingDiagnostics;
+
+  diagnostic_updater::DiagnosticStatusWrapper evaluate(const std::string& path)
+  {
+    diagnostic_updater::DiagnosticStatusWrapper status;
+    for (const std::unique_ptr<Task>& task : tasks_)
+    {
+      if (task->path == path)
+      {
+        ProfilingDiagnostics::evaluate(*task, status);
+      }
+    }
+    return status;
+  }
+};
+
+static bool hasValue(const diagnostic_updater::DiagnosticStatusWrapper& status, const std::string& key)
+{
+  for (const auto& value : status.values)
+  {
+    if (value.key == key)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void measure(
+  arti_profiling::Profiler& profiler, const std::string& name, const std::chrono::milliseconds& duration,
+  const bool histogram)
+{
+  const arti_profiling::DurationMeasurement::Clock::time_point time
+    = arti_profiling::DurationMeasurement::Clock::now();
+  arti_profiling::DurationMeasurement measurement(profiler, name, time);
+  measurement.setHistogramEnabled(histogram);
+  measurement.stop(time + duration);
+}
+
+class TestProfilingDiagnostics : public ::testing::Test
+{
+protected:
+  TestProfilingDiagnostics()
+    : profiler_(arti_profiling::Profiler::getRootInstance(), "test_profiling_diagnostics"),
+      diagnostics_(profiler_, updater_)
+  {
+  }
+
+  arti_profiling::Profiler profiler_;
+  diagnostic_updater::Updater updater_;
+  TestableProfilingDiagnostics diagnostics_;
+};
+
+TEST_F(TestProfilingDiagnostics, testMissingProfile)
+{
+  diagnostics_.addProfile("missing", arti_profiling::DiagnosticThresholds());
+  diagnostic_updater::DiagnosticStatusWrapper status = diagnostics_.evaluate("missing");
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::WARN, status.level);
+  EXPECT_NE(std::string::npos, status.message.find("not found"));
+
+  arti_profiling::DiagnosticThresholds thresholds;
+  thresholds.min_frequency_error = 1.0;
+  diagnostics_.addProfile("also missing", thresholds);
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::ERROR, diagnostics_.evaluate("also missing").level);
+
+  // Once it exists, it is evaluated:
+  measure(profiler_, "missing", std::chrono::milliseconds(1), false);
+  status = diagnostics_.evaluate("missing");
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::OK, status.level);
+  EXPECT_TRUE(hasValue(status, "frequency"));
+}
+
+TEST_F(TestProfilingDiagnostics, testDurationWithoutHistogram)
+{
+  measure(profiler_, "without threshold", std::chrono::milliseconds(10), false);
+  diagnostics_.addProfile("without threshold", arti_profiling::DiagnosticThresholds());
+  measure(profiler_, "without threshold", std::chrono::milliseconds(10), false);
+  diagnostic_updater::DiagnosticStatusWrapper status = diagnostics_.evaluate("without threshold");
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::OK, status.level);
+  EXPECT_TRUE(hasValue(status, "avg duration"));
+  EXPECT_FALSE(hasValue(status, "p99 duration"));
+
+  // The maximum would cover earlier windows, so a threshold on the percentile cannot be checked:
+  arti_profiling::DiagnosticThresholds thresholds;
+  thresholds.max_p99_duration_error = 0.001;
+  measure(profiler_, "with threshold", std::chrono::milliseconds(10), false);
+  diagnostics_.addProfile("with threshold", thresholds);
+  measure(profiler_, "with threshold", std::chrono::milliseconds(10), false);
+  status = diagnostics_.evaluate("with threshold");
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::WARN, status.level);
+  EXPECT_NE(std::string::npos, status.message.find("requires a histogram"));
+}
+
+TEST_F(TestProfilingDiagnostics, testPercentileWindow)
+{
+  arti_profiling::DiagnosticThresholds thresholds;
+  thresholds.max_p99_duration_warn = 0.01;
+  thresholds.max_p99_duration_error = 0.1;
+  diagnostics_.addProfile("duration", thresholds);
+
+  measure(profiler_, "duration", std::chrono::milliseconds(50), true);
+  diagnostic_updater::DiagnosticStatusWrapper status = diagnostics_.evaluate("duration");
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::WARN, status.level);
+  EXPECT_TRUE(hasValue(status, "p99 duration"));
+
+  // A slow measurement doesn't affect the following windows:
+  for (int i = 0; i < 10; ++i)
+  {
+    measure(profiler_, "duration", std::chrono::milliseconds(1), true);
+  }
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::OK, diagnostics_.evaluate("duration").level);
+
+  measure(profiler_, "duration", std::chrono::milliseconds(200), true);
+  EXPECT_EQ(diagnostic_msgs::DiagnosticStatus::ERROR, diagnostics_.evaluate("duration").level);
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_profiling_diagnostics");
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,129 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/real_time.h>
+#include <arti_profiling/snapshot.h>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+using arti_profiling::RealTimeDurationMeasurement;
+using arti_profiling::RealTimeDurationProfile;
+using std::chrono::milliseconds;
+
+/// Claims the buffer like a commit in progress does.
+class BlockingRealTimeDurationProfile : public RealTimeDurationProfile
+{
+public:
+  void beginCommit()
+  {
+    sequence_.fetch_add(1);
+  }
+
+  void endCommit()
+  {
+    sequence_.fetch_add(1);
+  }
+};
+
+TEST(TestRealTime, testViolations)
+{
+  std::thread([]
+  {
+    EXPECT_FALSE(arti_profiling::isRealTimeThread());
+    EXPECT_FALSE(arti_profiling::checkRealTimeViolation("not real-time"));
+
+    arti_profiling::setRealTimeThread(true);
+    const std::uint64_t violation_count = arti_profiling::getRealTimeViolationCount();
+    EXPECT_TRUE(arti_profiling::checkRealTimeViolation("real-time"));
+    EXPECT_EQ(violation_count + 1, arti_profiling::getRealTimeViolationCount());
+    EXPECT_STREQ("real-time", arti_profiling::getLastRealTimeViolation());
+
+    // Looking up profiles may allocate:
+    arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+    profiler.getProfile("allocating");
+    EXPECT_EQ(violation_count + 2, arti_profiling::getRealTimeViolationCount());
+    EXPECT_STREQ("Profiler::getProfile", arti_profiling::getLastRealTimeViolation());
+  }).join();
+}
+
+TEST(TestRealTime, testCommit)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  RealTimeDurationMeasurement measurement(profiler, "real-time");
+  const RealTimeDurationMeasurement::Clock::time_point start = RealTimeDurationMeasurement::Clock::now();
+  measurement.commit(milliseconds(1));
+  measurement.start(start);
+  measurement.stop(start + milliseconds(3));
+  measurement.stop(start + milliseconds(4));  // Not started again, so not committed
+  measurement.commit(milliseconds(2));
+
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("real-time", snapshot));
+  EXPECT_EQ(3u, snapshot.count);
+  EXPECT_DOUBLE_EQ(6e6, snapshot.sum.toDouble());
+  EXPECT_DOUBLE_EQ(1e6, snapshot.min.toDouble());
+  EXPECT_DOUBLE_EQ(3e6, snapshot.max.toDouble());
+  EXPECT_EQ(3u, snapshot.histogram.getCount());
+  EXPECT_EQ(0, snapshot.counters.at("dropped"));
+
+  // The extremes restart with the interval:
+  profiler.clear();
+  measurement.commit(milliseconds(2));
+  ASSERT_TRUE(profiler.takeSnapshot("real-time", snapshot));
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_DOUBLE_EQ(2e6, snapshot.min.toDouble());
+  EXPECT_DOUBLE_EQ(2e6, snapshot.max.toDouble());
+
+  profiler.clear();
+  ASSERT_TRUE(profiler.takeSnapshot("real-time", snapshot));
+  EXPECT_EQ(0u, snapshot.count);
+}
+
+TEST(TestRealTime, testOverlappingCommit)
+{
+  BlockingRealTimeDurationProfile profile;
+  profile.beginCommit();
+  profile.commit(milliseconds(1));
+  EXPECT_EQ(1u, profile.getDroppedCount());
+  profile.endCommit();
+
+  profile.commit(milliseconds(1));
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profile.takeSnapshot(snapshot));
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_EQ(1, snapshot.counters.at("dropped"));
+}
+
+TEST(TestRealTime, testConcurrentPulls)
+{
+  RealTimeDurationProfile profile;
+  const std::uint64_t commit_count = 200000;
+  std::atomic<bool> committing{true};
+  std::thread committer([&profile, &committing, commit_count]
+  {
+    for (std::uint64_t i = 0; i < commit_count; ++i)
+    {
+      profile.commit(std::chrono::nanoseconds(1000));
+    }
+    committing = false;
+  });
+
+  // Pulls must never see a commit partially, which would make the sum disagree with the count:
+  arti_profiling::ProfileSnapshot snapshot;
+  do
+  {
+    ASSERT_TRUE(profile.takeSnapshot(snapshot));
+    ASSERT_DOUBLE_EQ(1000.0 * snapshot.count, snapshot.sum.toDouble());
+    ASSERT_EQ(snapshot.count, snapshot.histogram.getCount());
+  }
+  while (committing);
+  committer.join();
+
+  ASSERT_TRUE(profile.takeSnapshot(snapshot));
+  EXPECT_EQ(commit_count, snapshot.count);
+  EXPECT_EQ(0u, profile.getDroppedCount());
+}
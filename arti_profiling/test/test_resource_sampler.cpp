@@ -0,0 +1,54 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/resource_sampler.h>
+#include <arti_profiling/snapshot.h>
+#include <chrono>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+static arti_profiling::ProfileSnapshot takeSnapshot(const arti_profiling::Profiler& profiler, const std::string& path)
+{
+  arti_profiling::ProfileSnapshot snapshot;
+  EXPECT_TRUE(profiler.takeSnapshot(path, snapshot)) << path;
+  return snapshot;
+}
+
+TEST(TestResourceSampler, testSample)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ResourceSampler sampler(profiler, std::chrono::hours(1));
+
+  // The sampling thread takes its first sample right away, but maybe not yet; rates need a second one:
+  sampler.sample();
+  sampler.sample();
+  EXPECT_EQ("gauge", takeSnapshot(profiler, "resources/threads").type);
+  EXPECT_GE(takeSnapshot(profiler, "resources/threads").min.toDouble(), 2.0);  // This one and the sampling thread
+  EXPECT_GT(takeSnapshot(profiler, "resources/resident memory").min.toDouble(), 0.0);
+  EXPECT_GE(takeSnapshot(profiler, "resources/cpu usage").min.toDouble(), 0.0);
+  EXPECT_GE(takeSnapshot(profiler, "resources/major page faults").min.toDouble(), 0.0);
+
+  const double open_fd_count = takeSnapshot(profiler, "resources/open fds").max.toDouble();
+  EXPECT_GE(open_fd_count, 3.0);  // At least the standard streams
+  std::ifstream file("/proc/self/stat");
+  sampler.sample();
+  EXPECT_EQ(open_fd_count + 1.0, takeSnapshot(profiler, "resources/open fds").max.toDouble());
+}
+
+TEST(TestResourceSampler, testPeriodicSampling)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ResourceSampler sampler(profiler, std::chrono::milliseconds(5));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // Samples from other threads don't disturb the sampling thread:
+  for (int i = 0; i < 10; ++i)
+  {
+    sampler.sample();
+  }
+  EXPECT_GE(takeSnapshot(profiler, "resources/threads").count, 12u);
+}
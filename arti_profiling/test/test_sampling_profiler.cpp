@@ -0,0 +1,113 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/sampling_profiler.h>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using arti_profiling::SamplingProfiler;
+
+/// Keeps the CPU busy for the given CPU time of the calling thread, which drives the sampling timers.
+static void spin(const std::chrono::milliseconds& duration)
+{
+  timespec start{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start);
+  volatile std::uint64_t value = 0;
+  while (true)
+  {
+    for (int i = 0; i < 10000; ++i)
+    {
+      value = value + i;
+    }
+    timespec now{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    if ((now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000 >= duration.count())
+    {
+      break;
+    }
+  }
+}
+
+TEST(TestSamplingProfiler, testScopes)
+{
+  EXPECT_EQ(0u, SamplingProfiler::enterScope("not running"));
+
+  SamplingProfiler::start(std::chrono::milliseconds(10), 100);
+  const std::uintptr_t outer = SamplingProfiler::enterScope("outer");
+  ASSERT_NE(0u, outer);
+  const std::uintptr_t inner = SamplingProfiler::enterScope("inner");
+  EXPECT_NE(outer, inner);
+
+  // Other threads cannot leave the scopes of this one:
+  std::thread([outer] { SamplingProfiler::leaveScope(outer); }).join();
+  const std::uintptr_t innermost = SamplingProfiler::enterScope("innermost");
+  EXPECT_NE(inner, innermost);
+  SamplingProfiler::leaveScope(innermost);
+
+  // Leaving a scope also leaves the ones inside it, so the next scope takes the place of the outer one:
+  SamplingProfiler::leaveScope(outer);
+  const std::uintptr_t next = SamplingProfiler::enterScope("next");
+  EXPECT_EQ(outer, next);
+  SamplingProfiler::leaveScope(next);
+  SamplingProfiler::stop();
+}
+
+TEST(TestSamplingProfiler, testFoldedStacks)
+{
+  SamplingProfiler::start(std::chrono::milliseconds(1), 1000);
+  SamplingProfiler::clear();
+  const std::uintptr_t scope = SamplingProfiler::enterScope("spinning;scope");
+  spin(std::chrono::milliseconds(100));
+  SamplingProfiler::leaveScope(scope);
+  SamplingProfiler::stop();
+
+  const std::size_t sample_count = SamplingProfiler::getSampleCount();
+  ASSERT_GT(sample_count, 0u);
+
+  std::ostringstream folded_stacks;
+  SamplingProfiler::writeFoldedStacks(folded_stacks);
+  std::istringstream lines(folded_stacks.str());
+  std::string line;
+  std::size_t total_count = 0;
+  std::size_t scope_count = 0;
+  while (std::getline(lines, line))
+  {
+    const std::size_t separator = line.rfind(' ');
+    ASSERT_NE(std::string::npos, separator) << line;
+    const std::size_t count = std::strtoul(line.c_str() + separator + 1, nullptr, 10);
+    EXPECT_GT(count, 0u) << line;
+    total_count += count;
+    EXPECT_TRUE(line[0] == '[' || line.find(" [") != std::string::npos) << line;  // Thread name, if any, then ID
+    if (line.find(";[spinning:scope];") != std::string::npos)
+    {
+      scope_count += count;
+    }
+  }
+  EXPECT_EQ(sample_count, total_count);
+  EXPECT_GT(scope_count, 0u);
+
+  SamplingProfiler::clear();
+  EXPECT_EQ(0u, SamplingProfiler::getSampleCount());
+}
+
+TEST(TestSamplingProfiler, testRestartWithOtherCapacity)
+{
+  SamplingProfiler::start(std::chrono::milliseconds(1), 2);
+  spin(std::chrono::milliseconds(20));
+  SamplingProfiler::stop();
+  EXPECT_EQ(2u, SamplingProfiler::getSampleCount());
+  EXPECT_GT(SamplingProfiler::getDroppedCount(), 0u);
+
+  // The buffer is replaced, which waits for handlers still writing to the old one:
+  SamplingProfiler::start(std::chrono::milliseconds(1), 50);
+  EXPECT_EQ(0u, SamplingProfiler::getSampleCount());
+  spin(std::chrono::milliseconds(20));
+  SamplingProfiler::stop();
+  EXPECT_GT(SamplingProfiler::getSampleCount(), 2u);
+}
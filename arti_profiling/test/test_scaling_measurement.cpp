@@ -0,0 +1,81 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/scaling_measurement.h>
+#include <chrono>
+#include <functional>
+#include <gtest/gtest.h>
+#include <random>
+
+using arti_profiling::Complexity;
+
+/// Accumulates durations computed from sizes between min_n and max_n with the given share of multiplicative noise.
+static void accumulate(
+  arti_profiling::ScalingStatistics& statistics, const std::size_t min_n, const std::size_t max_n,
+  const std::function<double(double)>& nanoseconds, const double noise_share = 0.05, const unsigned int seed = 42)
+{
+  std::minstd_rand random(seed);
+  std::uniform_int_distribution<std::size_t> size(min_n, max_n);
+  std::uniform_real_distribution<double> noise(1.0 - noise_share, 1.0 + noise_share);
+  for (int i = 0; i < 2000; ++i)
+  {
+    const std::size_t n = size(random);
+    statistics.accumulateScaling(n, std::chrono::nanoseconds(static_cast<std::int64_t>(
+      nanoseconds(static_cast<double>(n)) * noise(random))));
+  }
+}
+
+TEST(TestScalingMeasurement, testLinear)
+{
+  arti_profiling::ScalingStatistics statistics;
+  statistics.setExpectedComplexity(Complexity::LINEAR);
+  accumulate(statistics, 100, 10000, [](const double n) { return 1000.0 + 50.0 * n; });
+
+  const arti_profiling::ScalingStatistics::Fit best_fit = statistics.getBestFit();
+  EXPECT_EQ(Complexity::LINEAR, best_fit.complexity);
+  EXPECT_NEAR(50.0, best_fit.factor, 1.0);
+  EXPECT_GT(best_fit.r_squared, 0.99);
+  EXPECT_FALSE(statistics.exceedsExpectedComplexity());
+}
+
+TEST(TestScalingMeasurement, testNoisyLinear)
+{
+  // Over a narrow range of sizes, n log n is almost proportional to n, and noise alone can make it fit better:
+  for (unsigned int seed = 1; seed <= 20; ++seed)
+  {
+    arti_profiling::ScalingStatistics statistics;
+    statistics.setExpectedComplexity(Complexity::LINEAR);
+    accumulate(statistics, 1000, 8000, [](const double n) { return 1000.0 + 50.0 * n; }, 0.2, seed);
+
+    EXPECT_EQ(Complexity::LINEAR, statistics.getBestFit().complexity) << "seed " << seed;
+    EXPECT_FALSE(statistics.exceedsExpectedComplexity()) << "seed " << seed;
+  }
+}
+
+TEST(TestScalingMeasurement, testQuadratic)
+{
+  arti_profiling::ScalingStatistics statistics;
+  statistics.setExpectedComplexity(Complexity::LINEAR);
+  accumulate(statistics, 100, 10000, [](const double n) { return 1000.0 + 0.5 * n * n; });
+
+  const arti_profiling::ScalingStatistics::Fit best_fit = statistics.getBestFit();
+  EXPECT_EQ(Complexity::QUADRATIC, best_fit.complexity);
+  EXPECT_NEAR(0.5, best_fit.factor, 0.01);
+  EXPECT_TRUE(statistics.exceedsExpectedComplexity());
+
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(statistics.takeSnapshot(snapshot));
+  EXPECT_EQ("scaling", snapshot.type);
+  EXPECT_EQ(static_cast<std::int64_t>(Complexity::QUADRATIC), snapshot.counters.at("best_fit_complexity"));
+}
+
+TEST(TestScalingMeasurement, testSizesTooSimilar)
+{
+  arti_profiling::ScalingStatistics statistics;
+  accumulate(statistics, 1000, 2000, [](const double n) { return 0.5 * n * n; });
+
+  EXPECT_TRUE(statistics.fit().empty());
+  EXPECT_EQ(Complexity::UNKNOWN, statistics.getBestFit().complexity);
+  EXPECT_FALSE(statistics.exceedsExpectedComplexity());
+}
@@ -0,0 +1,242 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/comparison.h>
+#include <arti_profiling/duration_measurement.h>
+#include <arti_profiling/frequency_measurement.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <cmath>
+#include <gtest/gtest.h>
+#include <limits>
+#include <sstream>
+
+static arti_profiling::ProfilerSnapshot createSnapshot()
+{
+  using Clock = arti_profiling::DurationMeasurement::Clock;
+
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::Profiler child(profiler, "child \"quoted\"");
+  const Clock::time_point start = Clock::now();
+  for (int i = 1; i <= 10; ++i)
+  {
+    arti_profiling::DurationMeasurement measurement(profiler, "duration", start);
+    measurement.setBudget(std::chrono::microseconds(5));
+    measurement.setTopSampleCount(3);
+    measurement.setTag("seq " + std::to_string(i));
+    measurement.setHistogramEnabled(true);
+    measurement.stop(start + std::chrono::microseconds(i));
+
+    arti_profiling::DurationMeasurement labeled(
+      child, "labeled", arti_profiling::LabelSet{{"sensor", i % 2 == 0 ? "front" : "rear"}}, start);
+    labeled.stop(start + std::chrono::nanoseconds(i * 1001));
+
+    arti_profiling::FrequencyMeasurement(
+      child, "frequency", arti_profiling::FrequencyMeasurement::Clock::time_point(std::chrono::milliseconds(i * i)));
+  }
+  return profiler.takeSnapshot();
+}
+
+TEST(TestSnapshot, testBinaryRoundTrip)
+{
+  const arti_profiling::ProfilerSnapshot snapshot = createSnapshot();
+  std::stringstream data;
+  arti_profiling::writeBinary(data, snapshot);
+  EXPECT_EQ(snapshot, arti_profiling::readBinary(data));
+}
+
+TEST(TestSnapshot, testJsonRoundTrip)
+{
+  const arti_profiling::ProfilerSnapshot snapshot = createSnapshot();
+  std::stringstream data;
+  arti_profiling::writeJson(data, snapshot);
+  EXPECT_EQ(snapshot, arti_profiling::readJson(data));
+}
+
+TEST(TestSnapshot, testJsonNonFinite)
+{
+  arti_profiling::ProfilerSnapshot snapshot;
+  arti_profiling::ProfileSnapshot& profile = snapshot.profiles["frequency"];
+  profile.type = "frequency";
+  profile.count = 2;
+  profile.sum = arti_profiling::SnapshotValue::from(std::numeric_limits<double>::infinity());
+  profile.min = arti_profiling::SnapshotValue::from(std::numeric_limits<double>::quiet_NaN());
+  profile.max = profile.sum;
+
+  std::stringstream data;
+  arti_profiling::writeJson(data, snapshot);
+  EXPECT_EQ(std::string::npos, data.str().find("inf"));
+  EXPECT_EQ(std::string::npos, data.str().find("nan"));
+
+  const arti_profiling::ProfileSnapshot read = arti_profiling::readJson(data).profiles.at("frequency");
+  EXPECT_EQ(std::numeric_limits<double>::max(), read.sum.real);
+  EXPECT_TRUE(std::isnan(read.min.real));
+}
+
+TEST(TestSnapshot, testContent)
+{
+  const arti_profiling::ProfilerSnapshot snapshot = createSnapshot();
+  const arti_profiling::ProfileSnapshot& duration = snapshot.profiles.at("duration");
+  EXPECT_EQ("duration", duration.type);
+  EXPECT_EQ(10u, duration.count);
+  EXPECT_EQ(1000, duration.min.integer);
+  EXPECT_EQ(10000, duration.max.integer);
+  EXPECT_EQ(55000, duration.sum.integer);
+  EXPECT_EQ(5u, duration.overrun_count);
+  EXPECT_EQ(10u, duration.histogram.getCount());
+  ASSERT_EQ(3u, duration.top_samples.size());
+  EXPECT_EQ("seq 10", duration.top_samples.front().tag);
+
+  const arti_profiling::ProfilerSnapshot* child = snapshot.findChild("child \"quoted\"");
+  ASSERT_NE(nullptr, child);
+  EXPECT_EQ(2u, child->profiles.at("labeled").labels.size());
+  EXPECT_EQ(5u, child->profiles.at("labeled").labels.at("sensor=front").count);
+  EXPECT_EQ(9u, child->profiles.at("frequency").count);
+  EXPECT_FALSE(child->profiles.at("frequency").sum.integral);
+}
+
+TEST(TestSnapshot, testMerge)
+{
+  arti_profiling::ProfilerSnapshot merged = createSnapshot();
+  const arti_profiling::ProfilerSnapshot other = createSnapshot();
+  merged.merge(other);
+
+  const arti_profiling::ProfileSnapshot& duration = merged.profiles.at("duration");
+  EXPECT_EQ(20u, duration.count);
+  EXPECT_EQ(1000, duration.min.integer);
+  EXPECT_EQ(10000, duration.max.integer);
+  EXPECT_EQ(110000, duration.sum.integer);
+  EXPECT_EQ(10u, duration.overrun_count);
+  EXPECT_EQ(20u, duration.histogram.getCount());
+  EXPECT_EQ(3u, duration.top_samples.size());
+  ASSERT_EQ(1u, merged.children.size());
+  EXPECT_EQ(10u, merged.children.front().profiles.at("labeled").labels.at("sensor=rear").count);
+}
+
+TEST(TestSnapshot, testRollUp)
+{
+  arti_profiling::ProfilerSnapshot snapshot = createSnapshot();
+  snapshot.children.push_back(createSnapshot());
+  snapshot.computeRollUp();
+
+  EXPECT_EQ(20u, snapshot.rollup.at("duration").count);
+  EXPECT_EQ(20u, snapshot.rollup.at("labeled").count);
+  EXPECT_EQ(10u, snapshot.rollup.at("labeled").labels.at("sensor=front").count);
+  EXPECT_EQ(10u, snapshot.children.back().rollup.at("duration").count);
+  EXPECT_EQ(10u, snapshot.profiles.at("duration").count);
+}
+
+TEST(TestSnapshot, testHistogramQuantiles)
+{
+  arti_profiling::Histogram histogram;
+  for (int i = 1; i <= 1000; ++i)
+  {
+    histogram.add(i);
+  }
+  EXPECT_NEAR(500.0, histogram.getQuantile(0.5), 500.0 / arti_profiling::Histogram::SUB_BUCKET_COUNT);
+  EXPECT_NEAR(990.0, histogram.getQuantile(0.99), 990.0 / arti_profiling::Histogram::SUB_BUCKET_COUNT);
+  for (const double value : {1e-9, 0.3, 1.0, 7.5, 1e12})
+  {
+    const std::int32_t index = arti_profiling::Histogram::getBucketIndex(value);
+    EXPECT_LE(arti_profiling::Histogram::getBucketLowerBound(index), value);
+    EXPECT_GT(arti_profiling::Histogram::getBucketUpperBound(index), value);
+  }
+}
+
+static arti_profiling::ProfilerSnapshot createDistributionSnapshot(const double offset)
+{
+  arti_profiling::ProfilerSnapshot snapshot;
+  arti_profiling::ProfileSnapshot& profile = snapshot.profiles["duration"];
+  profile.type = "duration";
+  profile.min = arti_profiling::SnapshotValue::from(1e6 + offset);
+  profile.max = arti_profiling::SnapshotValue::from(2e6 + offset);
+  for (int i = 0; i < 1000; ++i)
+  {
+    const double value = 1e6 + offset + (i * 7919 % 1000) * 1e3;  // Uniformly distributed between 1ms and 2ms
+    profile.histogram.add(value);
+    profile.sum += arti_profiling::SnapshotValue::from(value);
+    ++profile.count;
+  }
+  return snapshot;
+}
+
+TEST(TestSnapshot, testComparison)
+{
+  const arti_profiling::ProfilerSnapshot baseline = createDistributionSnapshot(0.0);
+
+  std::vector<arti_profiling::ProfileComparison> comparisons
+    = arti_profiling::compareSnapshots(baseline, createDistributionSnapshot(0.0));
+  ASSERT_EQ(1u, comparisons.size());
+  EXPECT_EQ(arti_profiling::ProfileComparison::Verdict::UNCHANGED, comparisons.front().verdict);
+  EXPECT_FALSE(arti_profiling::hasRegressions(comparisons));
+
+  comparisons = arti_profiling::compareSnapshots(baseline, createDistributionSnapshot(2e5));
+  ASSERT_EQ(1u, comparisons.size());
+  EXPECT_EQ(arti_profiling::ProfileComparison::Verdict::REGRESSION, comparisons.front().verdict);
+  EXPECT_LT(comparisons.front().p_value, 1e-6);
+  EXPECT_TRUE(arti_profiling::hasRegressions(comparisons));
+
+  comparisons = arti_profiling::compareSnapshots(createDistributionSnapshot(2e5), baseline);
+  ASSERT_EQ(1u, comparisons.size());
+  EXPECT_EQ(arti_profiling::ProfileComparison::Verdict::IMPROVEMENT, comparisons.front().verdict);
+}
+
+TEST(TestSnapshot, testTailComparison)
+{
+  const arti_profiling::ProfilerSnapshot baseline = createDistributionSnapshot(0.0);
+
+  // Make 3% of the values take 10ms, which leaves the median unchanged:
+  arti_profiling::ProfilerSnapshot current;
+  arti_profiling::ProfileSnapshot& profile = current.profiles["duration"];
+  profile.type = "duration";
+  profile.min = arti_profiling::SnapshotValue::from(1e6);
+  profile.max = arti_profiling::SnapshotValue::from(1e7);
+  for (int i = 0; i < 1000; ++i)
+  {
+    const double value = i % 100 < 3 ? 1e7 : 1e6 + (i * 7919 % 1000) * 1e3;
+    profile.histogram.add(value);
+    profile.sum += arti_profiling::SnapshotValue::from(value);
+    ++profile.count;
+  }
+
+  const std::vector<arti_profiling::ProfileComparison> comparisons
+    = arti_profiling::compareSnapshots(baseline, current);
+  ASSERT_EQ(1u, comparisons.size());
+  EXPECT_EQ(arti_profiling::ProfileComparison::Verdict::REGRESSION, comparisons.front().verdict);
+  EXPECT_GT(comparisons.front().p_value, 0.01);
+  EXPECT_LT(comparisons.front().p99_p_value, 1e-3);
+}
+
+TEST(TestSnapshot, testComparisonWithoutHistograms)
+{
+  arti_profiling::ProfilerSnapshot baseline = createDistributionSnapshot(0.0);
+  baseline.profiles["duration"].histogram.clear();
+  arti_profiling::ProfilerSnapshot current = createDistributionSnapshot(0.0);
+  current.profiles["duration"].histogram.clear();
+
+  std::vector<arti_profiling::ProfileComparison> comparisons = arti_profiling::compareSnapshots(baseline, current);
+  ASSERT_EQ(1u, comparisons.size());
+  EXPECT_EQ(arti_profiling::ProfileComparison::Verdict::UNCHANGED, comparisons.front().verdict);
+
+  current = createDistributionSnapshot(2e5);
+  current.profiles["duration"].histogram.clear();
+  comparisons = arti_profiling::compareSnapshots(baseline, current);
+  ASSERT_EQ(1u, comparisons.size());
+  EXPECT_EQ(arti_profiling::ProfileComparison::Verdict::REGRESSION, comparisons.front().verdict);
+  EXPECT_LT(comparisons.front().p_value, 1e-6);
+  EXPECT_TRUE(arti_profiling::hasRegressions(comparisons));
+
+  // A single value gives no variance estimate:
+  arti_profiling::ProfileSnapshot& profile = current.profiles["duration"];
+  profile.count = 1;
+  profile.sum = profile.min = profile.max = arti_profiling::SnapshotValue::from(1e7);
+  comparisons = arti_profiling::compareSnapshots(baseline, current);
+  ASSERT_EQ(1u, comparisons.size());
+  EXPECT_EQ(arti_profiling::ProfileComparison::Verdict::NOT_TESTABLE, comparisons.front().verdict);
+  EXPECT_FALSE(arti_profiling::hasRegressions(comparisons));
+
+  arti_profiling::ComparisonOptions options;
+  options.fail_untestable = true;
+  EXPECT_TRUE(arti_profiling::hasRegressions(comparisons, options));
+}
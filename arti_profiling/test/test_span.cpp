@@ -0,0 +1,171 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/span.h>
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using Clock = arti_profiling::Span::Clock;
+
+TEST(TestSpan, testHopAndFinish)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test_span");
+  const Clock::time_point start(std::chrono::seconds(1));
+  {
+    arti_profiling::Span span(profiler, "span", start);
+    span.hop("queue", start + std::chrono::microseconds(1));
+    arti_profiling::Span moved(std::move(span));
+    EXPECT_FALSE(span.isActive());
+    moved.finish("process", start + std::chrono::microseconds(3));
+  }
+  {
+    arti_profiling::Span abandoned(profiler, "span", start);
+  }
+
+  const arti_profiling::ProfileSnapshot snapshot = profiler.takeSnapshot().profiles.at("span");
+  EXPECT_EQ("span", snapshot.type);
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_EQ(3000, snapshot.max.integer);
+  EXPECT_EQ(1000, snapshot.labels.at("segment=queue").max.integer);
+  EXPECT_EQ(2000, snapshot.labels.at("segment=process").max.integer);
+  EXPECT_EQ(1, snapshot.counters.at("abandoned"));
+}
+
+TEST(TestSpan, testTable)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test_span_table");
+  arti_profiling::SpanTable table(profiler, "span", 2);
+  const Clock::time_point start(std::chrono::seconds(1));
+  EXPECT_FALSE(table.start(0, start));
+  EXPECT_TRUE(table.start(1, start));
+  EXPECT_FALSE(table.start(1, start));
+  EXPECT_TRUE(table.start(2, start));
+  EXPECT_FALSE(table.start(3, start));  // Full
+  EXPECT_FALSE(table.hop(3, "hop", start));
+  EXPECT_TRUE(table.abandon(2));
+  EXPECT_FALSE(table.finish(2));
+  EXPECT_TRUE(table.start(3, start));
+  EXPECT_TRUE(table.finish(1, "last", start + std::chrono::microseconds(2)));
+
+  const arti_profiling::ProfileSnapshot snapshot = profiler.takeSnapshot().profiles.at("span");
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_EQ(2000, snapshot.max.integer);
+  EXPECT_EQ(1, snapshot.counters.at("abandoned"));
+}
+
+// Spans started, hopped and finished by different threads must see each other's times, even when slots are reused.
+TEST(TestSpan, testTableAcrossThreads)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test_span_threads");
+  arti_profiling::SpanTable table(profiler, "span", 8);
+  const int span_count = 20000;
+  std::atomic<int> started{0};
+  std::atomic<int> hopped{0};
+
+  // Times are derived from the ID, so that every segment and total has the same duration unless times get mixed up:
+  auto getTime = [](const int id, const int offset)
+  {
+    return Clock::time_point(std::chrono::microseconds(id * 10 + offset));
+  };
+
+  std::thread starter([&]()
+  {
+    for (int id = 1; id <= span_count; ++id)
+    {
+      while (id - hopped.load() > 4)  // Don't overfill the table
+      {
+        std::this_thread::yield();
+      }
+      ASSERT_TRUE(table.start(id, getTime(id, 0)));
+      started.store(id);
+    }
+  });
+  std::thread hopper([&]()
+  {
+    for (int id = 1; id <= span_count; ++id)
+    {
+      while (started.load() < id)
+      {
+        std::this_thread::yield();
+      }
+      EXPECT_TRUE(table.hop(id, "hop", getTime(id, 1)));
+      hopped.store(id);
+    }
+  });
+  std::thread finisher([&]()
+  {
+    for (int id = 1; id <= span_count; ++id)
+    {
+      while (hopped.load() < id)
+      {
+        std::this_thread::yield();
+      }
+      EXPECT_TRUE(table.finish(id, "finish", getTime(id, 3)));
+    }
+  });
+  starter.join();
+  hopper.join();
+  finisher.join();
+
+  const arti_profiling::ProfileSnapshot snapshot = profiler.takeSnapshot().profiles.at("span");
+  EXPECT_EQ(static_cast<std::uint64_t>(span_count), snapshot.count);
+  EXPECT_EQ(3000, snapshot.min.integer);
+  EXPECT_EQ(3000, snapshot.max.integer);
+  EXPECT_EQ(1000, snapshot.labels.at("segment=hop").min.integer);
+  EXPECT_EQ(1000, snapshot.labels.at("segment=hop").max.integer);
+  EXPECT_EQ(2000, snapshot.labels.at("segment=finish").min.integer);
+  EXPECT_EQ(2000, snapshot.labels.at("segment=finish").max.integer);
+}
+
+TEST(TestSpan, testConcurrentStartOfSameId)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test_span_same_id");
+  arti_profiling::SpanTable table(profiler, "span", 16);
+  const int thread_count = 4;
+
+  for (arti_profiling::Span::Id id = 1; id <= 500; ++id)
+  {
+    // Occupy the ID's first slot now and then, so that claims happen at different positions:
+    const bool blocked = id % 3 == 0;
+    if (blocked)
+    {
+      ASSERT_TRUE(table.start(id + 16));
+    }
+
+    std::atomic<int> ready{0};
+    std::atomic<int> successes{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; ++i)
+    {
+      threads.emplace_back([&, i]()
+      {
+        ready.fetch_add(1);
+        while (ready.load() < thread_count)
+        {
+          std::this_thread::yield();
+        }
+        if (i == 0 && blocked)
+        {
+          table.abandon(id + 16);
+        }
+        if (table.start(id))
+        {
+          successes.fetch_add(1);
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+    ASSERT_EQ(1, successes.load()) << "for ID " << id;
+    ASSERT_TRUE(table.finish(id));
+    ASSERT_FALSE(table.finish(id));
+  }
+}
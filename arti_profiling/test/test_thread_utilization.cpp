@@ -0,0 +1,114 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <arti_profiling/thread_utilization.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+using arti_profiling::BusyScope;
+using arti_profiling::ThreadPoolUtilization;
+using arti_profiling::ThreadRegistration;
+
+TEST(TestThreadUtilization, testBusyScopes)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  ThreadRegistration registration(profiler, "pool", "worker");
+  EXPECT_EQ(&registration, ThreadRegistration::getCurrent());
+  registration.getPool().reset();
+
+  {
+    BusyScope busy_scope;
+    BusyScope nested_busy_scope;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  // Nested scopes are a single busy period, and sleeping takes no CPU time:
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("pool", snapshot));
+  EXPECT_EQ("thread_pool", snapshot.type);
+  EXPECT_EQ(1u, snapshot.count);
+  const arti_profiling::ProfileSnapshot& thread_snapshot = snapshot.labels.at("thread=worker");
+  EXPECT_EQ(1u, thread_snapshot.count);
+  const std::int64_t interval_ns = thread_snapshot.counters.at("interval_ns");
+  EXPECT_GE(thread_snapshot.counters.at("busy_ns"), 20000000);
+  EXPECT_LE(thread_snapshot.counters.at("busy_ns"), interval_ns - 20000000);
+  EXPECT_LT(thread_snapshot.counters.at("cpu_ns"), interval_ns / 2);
+
+  // Busy periods count only in the interval they took place in:
+  registration.getPool().reset();
+  ASSERT_TRUE(profiler.takeSnapshot("pool", snapshot));
+  EXPECT_EQ(0u, snapshot.labels.at("thread=worker").count);
+  EXPECT_EQ(0, snapshot.labels.at("thread=worker").counters.at("busy_ns"));
+}
+
+TEST(TestThreadUtilization, testBusyPeriodAcrossReset)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  ThreadRegistration registration(profiler, "pool", "worker");
+  ThreadPoolUtilization& pool = registration.getPool();
+  ThreadPoolUtilization::ThreadState& state = registration.getState();
+
+  const ThreadPoolUtilization::Clock::time_point start = ThreadPoolUtilization::Clock::now();
+  pool.beginBusy(state, start - std::chrono::seconds(10));
+  pool.reset();
+  pool.endBusy(state, start + std::chrono::milliseconds(5));
+
+  // The whole period is a busy period, but only its part in the interval is busy time:
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("pool", snapshot));
+  const arti_profiling::ProfileSnapshot& thread_snapshot = snapshot.labels.at("thread=worker");
+  EXPECT_EQ(1u, thread_snapshot.count);
+  EXPECT_GE(thread_snapshot.max.toDouble(), 10e9);
+  EXPECT_LE(thread_snapshot.counters.at("busy_ns"), 5000000);
+}
+
+TEST(TestThreadUtilization, testBusyTimeRestartsAfterReset)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  ThreadRegistration registration(profiler, "pool", "worker");
+  ThreadPoolUtilization& pool = registration.getPool();
+  ThreadPoolUtilization::ThreadState& state = registration.getState();
+
+  const ThreadPoolUtilization::Clock::time_point start = ThreadPoolUtilization::Clock::now();
+  pool.beginBusy(state, start - std::chrono::seconds(1));
+  pool.endBusy(state, start);
+  pool.reset();
+
+  // The thread restarts its busy time with its first period in the new interval:
+  pool.beginBusy(state);
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  pool.endBusy(state);
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("pool", snapshot));
+  const arti_profiling::ProfileSnapshot& thread_snapshot = snapshot.labels.at("thread=worker");
+  EXPECT_GE(thread_snapshot.counters.at("busy_ns"), 2000000);
+  EXPECT_LE(thread_snapshot.counters.at("busy_ns"), thread_snapshot.counters.at("interval_ns"));
+}
+
+TEST(TestThreadUtilization, testUnregisteredThreads)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  std::shared_ptr<ThreadPoolUtilization> pool = ThreadPoolUtilization::getPool(profiler, "spinner");
+
+  std::thread([&profiler, &pool]
+  {
+    {
+      // Without a registration, plain scopes do nothing:
+      BusyScope busy_scope;
+      EXPECT_EQ(nullptr, ThreadRegistration::getCurrent());
+    }
+    BusyScope busy_scope(profiler, "spinner");
+    ASSERT_NE(nullptr, ThreadRegistration::getCurrent());
+    EXPECT_EQ("spinner_1", ThreadRegistration::getCurrent()->getState().name);
+    EXPECT_EQ(pool.get(), &ThreadRegistration::getCurrent()->getPool());
+    EXPECT_EQ(1u, pool->getThreadCount());
+  }).join();
+
+  // Automatic registrations end with their threads:
+  EXPECT_EQ(0u, pool->getThreadCount());
+}
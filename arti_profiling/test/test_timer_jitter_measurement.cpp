@@ -0,0 +1,78 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <arti_profiling/timer_jitter_measurement.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <ros/forwards.h>
+
+using arti_profiling::TimerJitterMeasurement;
+using std::chrono::milliseconds;
+
+TEST(TestTimerJitterMeasurement, testLoop)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  const TimerJitterMeasurement jitter(profiler, "loop");
+  const TimerJitterMeasurement::Clock::time_point start = TimerJitterMeasurement::Clock::now();
+  jitter.record(start, start + milliseconds(2));
+  jitter.record(start + milliseconds(100), start + milliseconds(104));
+
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("loop", snapshot));
+  EXPECT_EQ("timer_jitter", snapshot.type);
+  EXPECT_EQ(2u, snapshot.count);
+  EXPECT_DOUBLE_EQ(2e6, snapshot.min.toDouble());
+  EXPECT_DOUBLE_EQ(4e6, snapshot.max.toDouble());
+  EXPECT_EQ(0u, snapshot.labels.at("period_error").count);
+  EXPECT_EQ(0u, snapshot.labels.count("callback"));
+}
+
+TEST(TestTimerJitterMeasurement, testTimerEvents)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  const TimerJitterMeasurement jitter(profiler, "timer");
+
+  // The first call has no previous one, so its period is unknown:
+  ros::TimerEvent event;
+  event.current_expected = ros::Time(10, 0);
+  event.current_real = ros::Time(10, 2000000);
+  jitter.record(event);
+
+  event.last_expected = event.current_expected;
+  event.last_real = event.current_real;
+  event.current_expected = ros::Time(10, 100000000);
+  event.current_real = ros::Time(10, 105000000);
+  jitter.record(event);
+
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("timer", snapshot));
+  EXPECT_EQ(2u, snapshot.count);
+  EXPECT_DOUBLE_EQ(5e6, snapshot.max.toDouble());
+  const arti_profiling::ProfileSnapshot& period_errors = snapshot.labels.at("period_error");
+  EXPECT_EQ(1u, period_errors.count);
+  EXPECT_DOUBLE_EQ(3e6, period_errors.max.toDouble());
+}
+
+TEST(TestTimerJitterMeasurement, testWrap)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  int call_count = 0;
+  const ros::WallTimerCallback callback = TimerJitterMeasurement(profiler, "wall timer").wrap(
+    [&call_count](const ros::WallTimerEvent&) { ++call_count; });
+
+  ros::WallTimerEvent event;
+  event.current_expected = ros::WallTime(10, 0);
+  event.current_real = ros::WallTime(10, 1000000);
+  callback(event);
+  callback(event);
+  EXPECT_EQ(2, call_count);
+
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(profiler.takeSnapshot("wall timer", snapshot));
+  EXPECT_EQ(2u, snapshot.count);
+  EXPECT_DOUBLE_EQ(1e6, snapshot.max.toDouble());
+  EXPECT_EQ(2u, snapshot.labels.at("callback").count);
+}
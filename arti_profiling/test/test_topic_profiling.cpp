@@ -0,0 +1,130 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <arti_profiling/topic_profiling.h>
+#include <diagnostic_msgs/KeyValue.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <ros/init.h>
+#include <ros/node_handle.h>
+#include <ros/serialization.h>
+#include <string>
+
+static arti_profiling::ProfileSnapshot takeSnapshot(const arti_profiling::Profiler& profiler, const std::string& path)
+{
+  arti_profiling::ProfileSnapshot snapshot;
+  EXPECT_TRUE(profiler.takeSnapshot(path, snapshot)) << path;
+  return snapshot;
+}
+
+TEST(TestTopicProfiling, testMessageSizeStatistics)
+{
+  arti_profiling::MessageSizeStatistics statistics;
+  statistics.accumulate(100.0);
+  statistics.accumulate(300.0);
+
+  arti_profiling::ProfileSnapshot snapshot;
+  ASSERT_TRUE(statistics.takeSnapshot(snapshot));
+  EXPECT_EQ("message_size", snapshot.type);
+  EXPECT_EQ(2u, snapshot.count);
+  EXPECT_DOUBLE_EQ(400.0, snapshot.sum.toDouble());
+  EXPECT_DOUBLE_EQ(300.0, snapshot.max.toDouble());
+  EXPECT_GE(snapshot.counters.at("interval_ns"), 0);
+
+  statistics.clear();
+  ASSERT_TRUE(statistics.takeSnapshot(snapshot));
+  EXPECT_EQ(0u, snapshot.count);
+}
+
+TEST(TestTopicProfiling, testProfilesStayWhenCleared)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  const std::shared_ptr<arti_profiling::TopicProfiler> topic_profiler
+    = arti_profiling::TopicProfiler::get(profiler, "/robot/scan");
+  EXPECT_EQ(topic_profiler, arti_profiling::TopicProfiler::get(profiler, "/robot/scan"));
+  EXPECT_NE(topic_profiler, arti_profiling::TopicProfiler::get(profiler, "/robot/odom"));
+
+  const arti_profiling::TopicProfiler::MessageProfiles& profiles = topic_profiler->getReceivedProfiles();
+  EXPECT_EQ(&profiles, &topic_profiler->getReceivedProfiles());
+  profiles.accumulate(10);
+  profiles.accumulate(20);
+
+  // The topic profiler's name contains '/', which path lookups must handle:
+  EXPECT_EQ(2u, takeSnapshot(profiler, "/robot/scan/received size").count);
+  EXPECT_EQ(1u, takeSnapshot(profiler, "/robot/scan/receive rate").count);  // The rate of the interval between them
+
+  // The profiles are reset, but stay in the profiler, as the topic profiler keeps updating them:
+  profiler.clear();
+  EXPECT_EQ(0u, takeSnapshot(profiler, "/robot/scan/received size").count);
+  profiles.accumulate(30);
+  const arti_profiling::ProfileSnapshot snapshot = takeSnapshot(profiler, "/robot/scan/received size");
+  EXPECT_EQ(1u, snapshot.count);
+  EXPECT_DOUBLE_EQ(30.0, snapshot.sum.toDouble());
+}
+
+TEST(TestTopicProfiling, testHistoryOfTopic)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  profiler.setHistoryCapacity(2);
+  const std::shared_ptr<arti_profiling::TopicProfiler> topic_profiler
+    = arti_profiling::TopicProfiler::get(profiler, "/robot/scan");
+  topic_profiler->getPublishedProfiles().accumulate(10);
+  profiler.clear();
+
+  const std::vector<arti_profiling::ProfilerSnapshot> history = profiler.getHistory("/robot/scan");
+  ASSERT_EQ(1u, history.size());
+  EXPECT_EQ(1u, history.front().profiles.at("published size").count);
+}
+
+TEST(TestTopicProfiling, testSubscribeAndPublish)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  ros::NodeHandle node_handle("~");
+  const std::string topic = node_handle.resolveName("topic");
+
+  int received_count = 0;
+  const ros::Subscriber subscriber = arti_profiling::subscribe<diagnostic_msgs::KeyValue>(
+    profiler, node_handle, "topic", 10, boost::function<void(const diagnostic_msgs::KeyValueConstPtr&)>(
+      [&received_count](const diagnostic_msgs::KeyValueConstPtr&) { ++received_count; }));
+  arti_profiling::ProfiledPublisher publisher
+    = arti_profiling::advertise<diagnostic_msgs::KeyValue>(profiler, node_handle, "topic", 10);
+  EXPECT_EQ(topic, publisher.getTopic());
+
+  for (int i = 0; i < 50 && publisher.getNumSubscribers() == 0; ++i)
+  {
+    ros::WallDuration(0.1).sleep();
+  }
+  ASSERT_LT(0u, publisher.getNumSubscribers());
+
+  diagnostic_msgs::KeyValue message;
+  message.key = "key";
+  message.value = "value";
+  for (int i = 0; i < 3; ++i)
+  {
+    publisher.publish(message);
+  }
+  for (int i = 0; i < 50 && received_count < 3; ++i)
+  {
+    ros::WallDuration(0.1).sleep();
+    ros::spinOnce();
+  }
+  ASSERT_EQ(3, received_count);
+
+  const double message_size = ros::serialization::serializationLength(message);
+  EXPECT_EQ(3u, takeSnapshot(profiler, topic + "/publish").count);
+  EXPECT_EQ(2u, takeSnapshot(profiler, topic + "/publish rate").count);
+  EXPECT_DOUBLE_EQ(3 * message_size, takeSnapshot(profiler, topic + "/published size").sum.toDouble());
+  EXPECT_EQ(3u, takeSnapshot(profiler, topic + "/callback").count);
+  EXPECT_EQ(2u, takeSnapshot(profiler, topic + "/receive rate").count);
+  EXPECT_DOUBLE_EQ(3 * message_size, takeSnapshot(profiler, topic + "/received size").sum.toDouble());
+}
+
+int main(int argc, char** argv)
+{
+  testing::InitGoogleTest(&argc, argv);
+  ros::init(argc, argv, "test_topic_profiling");
+  return RUN_ALL_TESTS();
+}
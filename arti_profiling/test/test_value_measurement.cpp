@@ -0,0 +1,76 @@
+/// \file
+/// \author agent
+/// \date 2026-10-19
+/// \copyright ARTI - Autonomous Robot Technology GmbH. All rights reserved.
+#include <arti_profiling/profiler.h>
+#include <arti_profiling/snapshot.h>
+#include <arti_profiling/value_measurement.h>
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+
+static arti_profiling::ProfileSnapshot takeSnapshot(const arti_profiling::Profiler& profiler, const std::string& name)
+{
+  arti_profiling::ProfileSnapshot snapshot;
+  EXPECT_TRUE(profiler.takeSnapshot(name, snapshot)) << name;
+  return snapshot;
+}
+
+template<typename T>
+static std::string format(const T& value, const std::string& unit)
+{
+  std::ostringstream out;
+  arti_profiling::ValueMeasurement<T>::getFormatter(unit)(out, value);
+  return out.str();
+}
+
+TEST(TestValueMeasurement, testIntegralValues)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ValueMeasurement<int>(profiler, "points", 1000, "pts");
+  arti_profiling::ValueMeasurement<int>(profiler, "points", 3000, "pts");
+
+  const arti_profiling::ProfileSnapshot snapshot = takeSnapshot(profiler, "points");
+  EXPECT_EQ("value", snapshot.type);
+  EXPECT_EQ(2u, snapshot.count);
+  EXPECT_TRUE(snapshot.sum.integral);
+  EXPECT_EQ(4000, snapshot.sum.integer);
+  EXPECT_EQ(1000, snapshot.min.integer);
+  EXPECT_EQ(3000, snapshot.max.integer);
+  EXPECT_TRUE(snapshot.histogram.empty());
+}
+
+TEST(TestValueMeasurement, testFloatingPointValues)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ValueMeasurement<double>(profiler, "residual", 0.25, "m");
+  arti_profiling::ValueMeasurement<double>(profiler, "residual", 0.75, "m");
+
+  const arti_profiling::ProfileSnapshot snapshot = takeSnapshot(profiler, "residual");
+  EXPECT_EQ("value", snapshot.type);
+  EXPECT_EQ(2u, snapshot.count);
+  EXPECT_FALSE(snapshot.sum.integral);
+  EXPECT_DOUBLE_EQ(1.0, snapshot.sum.real);
+  EXPECT_DOUBLE_EQ(0.5, snapshot.getAverage());
+}
+
+TEST(TestValueMeasurement, testFormatter)
+{
+  // Integral values have no decimals, floating-point ones one:
+  EXPECT_EQ("    1234pts", format<int>(1234, "pts"));
+  EXPECT_EQ("     1.5m", format<double>(1.5, "m"));
+  EXPECT_EQ("       7", format<std::size_t>(7, std::string()));
+}
+
+TEST(TestValueMeasurement, testHistogram)
+{
+  arti_profiling::Profiler profiler(arti_profiling::Profiler::getRootInstance(), "test");
+  arti_profiling::ValueMeasurement<int>(profiler, "iterations", 10, "it", true);
+
+  // The histogram stays enabled for later measurements that don't request it:
+  arti_profiling::ValueMeasurement<int>(profiler, "iterations", 20, "it");
+
+  const arti_profiling::ProfileSnapshot snapshot = takeSnapshot(profiler, "iterations");
+  EXPECT_EQ(2u, snapshot.histogram.getCount());
+  EXPECT_NEAR(20.0, snapshot.histogram.getQuantile(1.0), 20.0 / arti_profiling::Histogram::SUB_BUCKET_COUNT);
+}